@@ -0,0 +1,275 @@
+#include "account_cache.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+
+#define PC_CACHE_MAGIC     0x7079746863616368UL
+#define PC_CACHE_VERSION   1
+#define PC_CACHE_INIT_SIZE (4UL<<20)
+
+using namespace pc;
+
+///////////////////////////////////////////////////////////////////////////
+// account_cache
+
+account_cache::account_cache()
+: fd_( -1 ),
+  buf_( nullptr ),
+  len_( 0 ),
+  num_( 0 )
+{
+}
+
+account_cache::~account_cache()
+{
+  close();
+}
+
+void account_cache::set_file( const std::string& file )
+{
+  file_ = file;
+}
+
+std::string account_cache::get_file() const
+{
+  return file_;
+}
+
+bool account_cache::get_is_init() const
+{
+  return buf_ != nullptr;
+}
+
+size_t account_cache::get_num_accounts() const
+{
+  return num_;
+}
+
+bool account_cache::init()
+{
+  fd_ = ::open( file_.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600 );
+  if ( fd_ < 0 ) {
+    return set_err_msg(
+        "failed to open account cache file=" + file_, errno );
+  }
+  struct stat fst[1];
+  if ( 0 != ::fstat( fd_, fst ) ) {
+    return set_err_msg(
+        "failed to stat account cache file=" + file_, errno );
+  }
+  size_t len = (size_t)fst->st_size;
+  if ( len < sizeof( file_hdr ) ) {
+    return reset();
+  }
+  if ( !map( len ) ) {
+    return false;
+  }
+  file_hdr *hdr = (file_hdr*)buf_;
+  if ( hdr->magic_ != PC_CACHE_MAGIC ||
+       hdr->ver_ != PC_CACHE_VERSION ||
+       hdr->hsize_ != sizeof( rec_hdr ) ||
+       hdr->len_ > len_ ) {
+    return reset();
+  }
+  load();
+  return true;
+}
+
+void account_cache::close()
+{
+  if ( buf_ ) {
+    ::munmap( buf_, len_ );
+    buf_ = nullptr;
+    len_ = 0;
+  }
+  if ( fd_ >= 0 ) {
+    ::close( fd_ );
+    fd_ = -1;
+  }
+  amap_.clear();
+  num_ = 0;
+}
+
+bool account_cache::map( size_t len )
+{
+  if ( len > len_ && 0 != ::ftruncate( fd_, (off_t)len ) ) {
+    return set_err_msg(
+        "failed to extend account cache file=" + file_, errno );
+  }
+  void *buf;
+  if ( buf_ ) {
+    buf = ::mremap( buf_, len_, len, MREMAP_MAYMOVE );
+  } else {
+    buf = ::mmap( nullptr, len, PROT_READ|PROT_WRITE, MAP_SHARED, fd_, 0 );
+  }
+  if ( buf == MAP_FAILED ) {
+    return set_err_msg(
+        "failed to map account cache file=" + file_, errno );
+  }
+  buf_ = (char*)buf;
+  len_ = len;
+  return true;
+}
+
+bool account_cache::reset()
+{
+  if ( !map( std::max( len_, PC_CACHE_INIT_SIZE ) ) ) {
+    return false;
+  }
+  amap_.clear();
+  num_ = 0;
+  file_hdr *hdr = (file_hdr*)buf_;
+  hdr->magic_ = PC_CACHE_MAGIC;
+  hdr->ver_   = PC_CACHE_VERSION;
+  hdr->hsize_ = sizeof( rec_hdr );
+  hdr->len_   = sizeof( file_hdr );
+  return true;
+}
+
+account_cache::rec_hdr *account_cache::get_rec( uint64_t off ) const
+{
+  return (rec_hdr*)&buf_[off];
+}
+
+void account_cache::load()
+{
+  // index records up to the first one that is not intact. a later
+  // image of the same account supersedes an earlier one
+  file_hdr *hdr = (file_hdr*)buf_;
+  uint64_t off = sizeof( file_hdr );
+  while( off + sizeof( rec_hdr ) <= hdr->len_ ) {
+    rec_hdr *rec = get_rec( off );
+    uint64_t nxt = off + sizeof( rec_hdr ) + rec->cap_;
+    if ( rec->cap_ % 8 || nxt > hdr->len_ || rec->len_ > rec->cap_ ) {
+      break;
+    }
+    const pc_acc_t *acc = (const pc_acc_t*)&rec[1];
+    if ( rec->len_ >= sizeof( pc_acc_t ) && acc->magic_ == PC_MAGIC ) {
+      pub_key key;
+      __builtin_memcpy( (void*)key.data(), &rec->acc_, sizeof( pc_pub_key_t ) );
+      acc_map_t::iter_t it = amap_.find( key );
+      if ( it ) {
+        get_rec( amap_.obj( it ) )->len_ = 0;
+      } else {
+        it = amap_.add( key );
+        ++num_;
+      }
+      amap_.ref( it ) = off;
+    }
+    off = nxt;
+  }
+  hdr->len_ = off;
+}
+
+account_cache::rec_hdr *account_cache::append(
+    const pub_key& key, uint32_t cap )
+{
+  file_hdr *hdr = (file_hdr*)buf_;
+  uint64_t off = hdr->len_;
+  size_t need = off + sizeof( rec_hdr ) + cap;
+  if ( need > len_ ) {
+    size_t len = len_;
+    while( len < need ) {
+      len *= 2;
+    }
+    if ( !map( len ) ) {
+      return nullptr;
+    }
+    hdr = (file_hdr*)buf_;
+  }
+  rec_hdr *rec = get_rec( off );
+  __builtin_memcpy( &rec->acc_, key.data(), sizeof( pc_pub_key_t ) );
+  rec->slot_     = 0UL;
+  rec->lamports_ = 0UL;
+  rec->cap_      = cap;
+  rec->len_      = 0;
+  hdr->len_      = need;
+  acc_map_t::iter_t it = amap_.find( key );
+  if ( it ) {
+    // moved to a bigger record
+    get_rec( amap_.obj( it ) )->len_ = 0;
+  } else {
+    it = amap_.add( key );
+    ++num_;
+  }
+  amap_.ref( it ) = off;
+  return rec;
+}
+
+void account_cache::write( const pub_key& key, uint64_t slot,
+                           uint64_t lamports, const void *data, size_t len )
+{
+  if ( !buf_ || len < sizeof( pc_acc_t ) || len > UINT32_MAX / 2 ) {
+    return;
+  }
+  rec_hdr *rec = nullptr;
+  acc_map_t::iter_t it = amap_.find( key );
+  if ( it ) {
+    rec = get_rec( amap_.obj( it ) );
+    if ( slot <= rec->slot_ ) {
+      return;
+    }
+  }
+  if ( !rec || len > rec->cap_ ) {
+    // round up to allow the account to grow a little in place
+    rec = append( key, (uint32_t)( ( len + 255 ) & ~255UL ) );
+    if ( !rec ) {
+      return;
+    }
+  }
+  // invalidate while the image is being rewritten
+  rec->len_ = 0;
+  __builtin_memcpy( &rec[1], data, len );
+  rec->slot_     = slot;
+  rec->lamports_ = lamports;
+  rec->len_      = (uint32_t)len;
+}
+
+const char *account_cache::read( const pub_key& key, uint64_t& slot,
+                                 uint64_t& lamports, size_t& len )
+{
+  acc_map_t::iter_t it = buf_ ? amap_.find( key ) : nullptr;
+  if ( !it ) {
+    return nullptr;
+  }
+  rec_hdr *rec = get_rec( amap_.obj( it ) );
+  if ( rec->len_ == 0 ) {
+    return nullptr;
+  }
+  slot     = rec->slot_;
+  lamports = rec->lamports_;
+  len      = rec->len_;
+  return (const char*)&rec[1];
+}
+
+///////////////////////////////////////////////////////////////////////////
+// cached_account
+
+cached_account::cached_account( const pub_key& acc, uint64_t slot,
+                                uint64_t lamports, const char *data,
+                                size_t len )
+: acc_( acc ),
+  slot_( slot ),
+  lamports_( lamports ),
+  ptr_( data ),
+  len_( len )
+{
+}
+
+const pub_key *cached_account::get_account() const
+{
+  return &acc_;
+}
+
+uint64_t cached_account::get_slot() const
+{
+  return slot_;
+}
+
+uint64_t cached_account::get_lamports() const
+{
+  return lamports_;
+}
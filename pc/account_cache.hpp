@@ -0,0 +1,127 @@
+#pragma once
+
+#include <pc/key_pair.hpp>
+#include <pc/error.hpp>
+#include <pc/hash_map.hpp>
+#include <oracle/oracle.h>
+
+namespace pc
+{
+
+  // last known mapping, product and price account images kept in a
+  // memory-mapped file so that a restarted manager can serve accounts
+  // before the chain has responded
+  class account_cache : public error
+  {
+  public:
+
+    account_cache();
+    ~account_cache();
+
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // map cache file (creating it if missing) and index valid images
+    bool init();
+    void close();
+    bool get_is_init() const;
+
+    // store account image seen at slot. ignored unless newer than the
+    // image already cached
+    void write( const pub_key&, uint64_t slot, uint64_t lamports,
+                const void *data, size_t len );
+
+    // find account image. returns nullptr if not cached
+    const char *read( const pub_key&, uint64_t& slot,
+                      uint64_t& lamports, size_t& len );
+
+    // number of cached accounts
+    size_t get_num_accounts() const;
+
+  private:
+
+    struct file_hdr {
+      uint64_t     magic_;
+      uint32_t     ver_;
+      uint32_t     hsize_;
+      uint64_t     len_;       // bytes used including header
+    };
+
+    struct rec_hdr {
+      pc_pub_key_t acc_;
+      uint64_t     slot_;
+      uint64_t     lamports_;
+      uint32_t     cap_;       // bytes reserved for image
+      uint32_t     len_;       // bytes in image (zero if moved)
+    };
+
+    struct trait_account {
+      static const size_t hsize_ = 8363UL;
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint64_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return *i;
+        }
+      };
+    };
+
+    typedef hash_map<trait_account> acc_map_t;
+
+    bool map( size_t );
+    bool reset();
+    void load();
+    rec_hdr *append( const pub_key&, uint32_t cap );
+    rec_hdr *get_rec( uint64_t off ) const;
+
+    std::string file_;
+    int         fd_;
+    char       *buf_;   // mapped file
+    size_t      len_;   // mapped length
+    acc_map_t   amap_;  // account to record offset
+    size_t      num_;   // number of cached accounts
+  };
+
+  // cached account image presented like an rpc account update
+  class cached_account : public error
+  {
+  public:
+    cached_account( const pub_key&, uint64_t slot, uint64_t lamports,
+                    const char *data, size_t len );
+
+    const pub_key *get_account() const;
+    uint64_t get_slot() const;
+    uint64_t get_lamports() const;
+
+    template<class T>
+    size_t get_data_ref( T *&, size_t srclen=sizeof(T) ) const;
+    template<class T>
+    size_t get_data_val( T *, size_t srclen=sizeof(T) ) const;
+
+  private:
+    pub_key         acc_;
+    uint64_t        slot_;
+    uint64_t        lamports_;
+    const char     *ptr_;
+    size_t          len_;
+  };
+
+  template<class T>
+  size_t cached_account::get_data_ref( T *&res, size_t ) const
+  {
+    res = (T*)ptr_;
+    return len_;
+  }
+
+  template<class T>
+  size_t cached_account::get_data_val( T *res, size_t tlen ) const
+  {
+    size_t len = len_ < tlen ? len_ : tlen;
+    __builtin_memcpy( (void*)res, ptr_, len );
+    return len;
+  }
+
+}
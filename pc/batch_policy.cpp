@@ -0,0 +1,128 @@
+#include "batch_policy.hpp"
+#include <algorithm>
+
+// weight of the last slot in the moving averages as a power of two
+// fraction (1/4)
+#define PC_BATCH_EWMA_SHIFT  2
+
+// weight of a new ack latency sample as a power of two fraction (1/8)
+#define PC_BATCH_LAT_SHIFT   3
+
+// batches are halved while fewer updates than this are acknowledged
+#define PC_BATCH_MIN_ACK_RATE 0.9
+
+// slots the batch size is held after a change so that the averages
+// reflect it before the next one
+#define PC_BATCH_HOLD        4
+
+using namespace pc;
+
+batch_policy::batch_policy()
+: max_( 1 ),
+  batch_( 1 ),
+  hold_( 0 ),
+  slot_( 0UL ),
+  slot_int_( 0L ),
+  flush_ts_( 0L ),
+  lead_( 0L ),
+  max_pend_( 0UL ),
+  num_sent_( 0 ),
+  prev_sent_( 0 ),
+  num_slot_ack_( 0 ),
+  sent_avg_( 0. ),
+  ack_avg_( 0. ),
+  lat_( 0L ),
+  num_ack_( 0UL ),
+  num_err_( 0UL ),
+  num_grow_( 0UL ),
+  num_shrink_( 0UL )
+{
+}
+
+void batch_policy::set_max_batch( unsigned num )
+{
+  max_ = batch_ = num ? num : 1;
+}
+
+unsigned batch_policy::get_max_batch() const
+{
+  return max_;
+}
+
+void batch_policy::add_pending( size_t num )
+{
+  max_pend_ = std::max( max_pend_, num );
+}
+
+void batch_policy::add_sent( unsigned num )
+{
+  num_sent_ += num;
+}
+
+void batch_policy::add_ack( int64_t lat )
+{
+  if ( num_ack_++ ) {
+    lat_ += ( lat - lat_ ) / ( 1L << PC_BATCH_LAT_SHIFT );
+  } else {
+    lat_ = lat;
+  }
+  ++num_slot_ack_;
+}
+
+void batch_policy::add_err()
+{
+  ++num_err_;
+}
+
+double batch_policy::get_ack_rate() const
+{
+  // updates sent through a path that never reports acks (e.g. the tx
+  // proxy) must not shrink batches
+  if ( !num_ack_ && !num_err_ ) {
+    return 1.;
+  }
+  return sent_avg_ > 0. ? std::min( 1., ack_avg_ / sent_avg_ ) : 1.;
+}
+
+bool batch_policy::on_slot( uint64_t slot, int64_t ts, int64_t slot_int )
+{
+  // acks mostly arrive in the slot after their updates were sent so
+  // they are matched against the previous slot's sends
+  const double wgt = 1. / ( 1 << PC_BATCH_EWMA_SHIFT );
+  sent_avg_ += ( prev_sent_ - sent_avg_ ) * wgt;
+  ack_avg_ += ( num_slot_ack_ - ack_avg_ ) * wgt;
+  prev_sent_ = num_sent_;
+
+  // shrink multiplicatively on lost updates, grow additively on backlog
+  unsigned batch = batch_;
+  if ( hold_ ) {
+    --hold_;
+  } else if ( sent_avg_ >= 1. && get_ack_rate() < PC_BATCH_MIN_ACK_RATE ) {
+    batch_ = std::max( 1U, batch_ / 2 );
+  } else if ( max_pend_ > batch_ ) {
+    batch_ = std::min( max_, batch_ + 1 );
+  }
+  if ( batch_ != batch ) {
+    hold_ = PC_BATCH_HOLD;
+    num_shrink_ += batch_ < batch;
+    num_grow_ += batch_ > batch;
+  }
+
+  // flush partial batches half an ack round trip before the slot ends
+  slot_ = slot;
+  slot_int_ = slot_int;
+  lead_ = std::min( lat_ / 2, slot_int / 2 );
+  flush_ts_ = ts + slot_int - lead_;
+
+  max_pend_ = 0UL;
+  num_sent_ = 0;
+  num_slot_ack_ = 0;
+  return batch_ != batch;
+}
+
+void batch_policy::on_flush( int64_t ts )
+{
+  while( flush_ts_ && slot_int_ > 0 && ts >= flush_ts_ ) {
+    flush_ts_ += slot_int_;
+  }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pc
+{
+
+  // picks the number of price updates per transaction and the time at
+  // which a partial batch is flushed, once per slot. batches are halved
+  // while too few updates are acknowledged and grow by one while more
+  // updates wait in a slot than fit in one batch. partial batches are
+  // flushed ahead of the next slot boundary by half the acknowledgement
+  // latency so that they still reach the leader of the current slot
+  class batch_policy
+  {
+  public:
+
+    batch_policy();
+
+    // upper bound on (and initial) batch size
+    void set_max_batch( unsigned );
+    unsigned get_max_batch() const;
+
+    // updates waiting to be sent
+    void add_pending( size_t num );
+
+    // updates sent on a path whose acks are reported, acknowledged after
+    // lat nanoseconds or rejected. the ack rate is taken as 1 until the
+    // first ack or rejection
+    void add_sent( unsigned num );
+    void add_ack( int64_t lat );
+    void add_err();
+
+    // re-evaluate at the start of slot observed at ts. returns true if
+    // the batch size changed
+    bool on_slot( uint64_t slot, int64_t ts, int64_t slot_int );
+
+    // partial batch flushed at ts. a passed deadline moves to the
+    // following slot
+    void on_flush( int64_t ts );
+
+    // current decisions. flush time is zero until the first slot
+    unsigned get_batch_size() const;
+    int64_t get_flush_time() const;
+    int64_t get_flush_lead() const;
+
+    // moving averages of updates acknowledged per update sent and of
+    // acknowledgement latency
+    double get_ack_rate() const;
+    int64_t get_ack_latency() const;
+
+    uint64_t get_slot() const;
+    uint64_t get_num_ack() const;
+    uint64_t get_num_err() const;
+    uint64_t get_num_grow() const;
+    uint64_t get_num_shrink() const;
+
+  private:
+
+    unsigned max_;       // batch size bound
+    unsigned batch_;     // current batch size
+    unsigned hold_;      // slots before the size may change again
+    uint64_t slot_;      // last slot evaluated
+    int64_t  slot_int_;  // slot interval estimate
+    int64_t  flush_ts_;  // flush deadline
+    int64_t  lead_;      // flush deadline ahead of slot end
+    size_t   max_pend_;  // most updates waiting during slot
+    unsigned num_sent_;  // updates sent during slot
+    unsigned prev_sent_; // updates sent during previous slot
+    unsigned num_slot_ack_; // updates acknowledged during slot
+    double   sent_avg_;  // moving average of updates sent per slot
+    double   ack_avg_;   // moving average of acks per slot
+    int64_t  lat_;       // moving average ack latency
+    uint64_t num_ack_;
+    uint64_t num_err_;
+    uint64_t num_grow_;
+    uint64_t num_shrink_;
+  };
+
+  inline unsigned batch_policy::get_batch_size() const
+  {
+    return batch_;
+  }
+
+  inline int64_t batch_policy::get_flush_time() const
+  {
+    return flush_ts_;
+  }
+
+  inline int64_t batch_policy::get_flush_lead() const
+  {
+    return lead_;
+  }
+
+  inline int64_t batch_policy::get_ack_latency() const
+  {
+    return lat_;
+  }
+
+  inline uint64_t batch_policy::get_slot() const
+  {
+    return slot_;
+  }
+
+  inline uint64_t batch_policy::get_num_ack() const
+  {
+    return num_ack_;
+  }
+
+  inline uint64_t batch_policy::get_num_err() const
+  {
+    return num_err_;
+  }
+
+  inline uint64_t batch_policy::get_num_grow() const
+  {
+    return num_grow_;
+  }
+
+  inline uint64_t batch_policy::get_num_shrink() const
+  {
+    return num_shrink_;
+  }
+
+}
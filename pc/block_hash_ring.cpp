@@ -0,0 +1,75 @@
+#include "block_hash_ring.hpp"
+
+using namespace pc;
+
+block_hash_ring::block_hash_ring()
+: num_( 0 ),
+  idx_( 0 )
+{
+  reset();
+}
+
+void block_hash_ring::reset()
+{
+  for( entry& ent: ring_ ) {
+    ent.hash_.zero();
+    ent.slot_ = 0UL;
+    ent.ts_ = 0L;
+  }
+  num_ = 0;
+  idx_ = 0;
+}
+
+bool block_hash_ring::add( const hash& bhash, uint64_t slot, int64_t ts )
+{
+  if ( num_ ) {
+    const entry& last = ring_[idx_];
+    if ( slot < last.slot_ || bhash == last.hash_ ) {
+      return false;
+    }
+    idx_ = ( idx_ + 1 ) % PC_BLOCK_HASH_RING;
+  }
+  entry& ent = ring_[idx_];
+  ent.hash_ = bhash;
+  ent.slot_ = slot;
+  ent.ts_ = ts;
+  if ( num_ < PC_BLOCK_HASH_RING ) {
+    ++num_;
+  }
+  return true;
+}
+
+unsigned block_hash_ring::get_num() const
+{
+  return num_;
+}
+
+const block_hash_ring::entry& block_hash_ring::get( unsigned i ) const
+{
+  return ring_[( idx_ + PC_BLOCK_HASH_RING - i ) % PC_BLOCK_HASH_RING];
+}
+
+const hash *block_hash_ring::get_hash( unsigned i ) const
+{
+  return &get( i ).hash_;
+}
+
+uint64_t block_hash_ring::get_slot( unsigned i ) const
+{
+  return get( i ).slot_;
+}
+
+int64_t block_hash_ring::get_time( unsigned i ) const
+{
+  return get( i ).ts_;
+}
+
+uint64_t block_hash_ring::find( const hash& bhash ) const
+{
+  for( unsigned i = 0; i != num_; ++i ) {
+    if ( get( i ).hash_ == bhash ) {
+      return get( i ).slot_;
+    }
+  }
+  return 0UL;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <pc/key_pair.hpp>
+
+// recent block hashes kept
+#define PC_BLOCK_HASH_RING 8
+
+namespace pc
+{
+
+  // the last few block hashes received with the slot and time each was
+  // first observed. the freshest one is used to sign transactions
+  class block_hash_ring
+  {
+  public:
+
+    block_hash_ring();
+
+    // forget all hashes
+    void reset();
+
+    // hash reported at slot and received at time ts (nanoseconds).
+    // returns true if it is new and becomes the freshest. repeats of the
+    // freshest hash and hashes from older slots are ignored
+    bool add( const hash&, uint64_t slot, int64_t ts );
+
+    // number of hashes held (up to PC_BLOCK_HASH_RING)
+    unsigned get_num() const;
+
+    // i-th most recent hash (0 = freshest)
+    const hash *get_hash( unsigned i = 0 ) const;
+    uint64_t get_slot( unsigned i = 0 ) const;
+    int64_t get_time( unsigned i = 0 ) const;
+
+    // slot at which a held hash was first observed or zero if not held
+    uint64_t find( const hash& ) const;
+
+  private:
+
+    struct entry {
+      hash     hash_;
+      uint64_t slot_;
+      int64_t  ts_;
+    };
+
+    const entry& get( unsigned i ) const;
+
+    entry    ring_[PC_BLOCK_HASH_RING];
+    unsigned num_;
+    unsigned idx_;  // index of freshest entry
+  };
+
+}
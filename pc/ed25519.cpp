@@ -0,0 +1,769 @@
+#include "ed25519.hpp"
+
+// field elements of GF(2^255-19) are five 51-bit limbs
+#define PC_FE_MASK 0x7ffffffffffffUL
+
+using namespace pc;
+
+typedef unsigned __int128 uint128_t;
+
+static const uint64_t sha512_k[80] = {
+  0x428a2f98d728ae22UL, 0x7137449123ef65cdUL, 0xb5c0fbcfec4d3b2fUL,
+  0xe9b5dba58189dbbcUL, 0x3956c25bf348b538UL, 0x59f111f1b605d019UL,
+  0x923f82a4af194f9bUL, 0xab1c5ed5da6d8118UL, 0xd807aa98a3030242UL,
+  0x12835b0145706fbeUL, 0x243185be4ee4b28cUL, 0x550c7dc3d5ffb4e2UL,
+  0x72be5d74f27b896fUL, 0x80deb1fe3b1696b1UL, 0x9bdc06a725c71235UL,
+  0xc19bf174cf692694UL, 0xe49b69c19ef14ad2UL, 0xefbe4786384f25e3UL,
+  0x0fc19dc68b8cd5b5UL, 0x240ca1cc77ac9c65UL, 0x2de92c6f592b0275UL,
+  0x4a7484aa6ea6e483UL, 0x5cb0a9dcbd41fbd4UL, 0x76f988da831153b5UL,
+  0x983e5152ee66dfabUL, 0xa831c66d2db43210UL, 0xb00327c898fb213fUL,
+  0xbf597fc7beef0ee4UL, 0xc6e00bf33da88fc2UL, 0xd5a79147930aa725UL,
+  0x06ca6351e003826fUL, 0x142929670a0e6e70UL, 0x27b70a8546d22ffcUL,
+  0x2e1b21385c26c926UL, 0x4d2c6dfc5ac42aedUL, 0x53380d139d95b3dfUL,
+  0x650a73548baf63deUL, 0x766a0abb3c77b2a8UL, 0x81c2c92e47edaee6UL,
+  0x92722c851482353bUL, 0xa2bfe8a14cf10364UL, 0xa81a664bbc423001UL,
+  0xc24b8b70d0f89791UL, 0xc76c51a30654be30UL, 0xd192e819d6ef5218UL,
+  0xd69906245565a910UL, 0xf40e35855771202aUL, 0x106aa07032bbd1b8UL,
+  0x19a4c116b8d2d0c8UL, 0x1e376c085141ab53UL, 0x2748774cdf8eeb99UL,
+  0x34b0bcb5e19b48a8UL, 0x391c0cb3c5c95a63UL, 0x4ed8aa4ae3418acbUL,
+  0x5b9cca4f7763e373UL, 0x682e6ff3d6b2b8a3UL, 0x748f82ee5defb2fcUL,
+  0x78a5636f43172f60UL, 0x84c87814a1f0ab72UL, 0x8cc702081a6439ecUL,
+  0x90befffa23631e28UL, 0xa4506cebde82bde9UL, 0xbef9a3f7b2c67915UL,
+  0xc67178f2e372532bUL, 0xca273eceea26619cUL, 0xd186b8c721c0c207UL,
+  0xeada7dd6cde0eb1eUL, 0xf57d4f7fee6ed178UL, 0x06f067aa72176fbaUL,
+  0x0a637dc5a2c898a6UL, 0x113f9804bef90daeUL, 0x1b710b35131c471bUL,
+  0x28db77f523047d84UL, 0x32caab7b40c72493UL, 0x3c9ebe0a15c9bebcUL,
+  0x431d67c49c100d4cUL, 0x4cc5d4becb3e42b6UL, 0x597f299cfc657e2aUL,
+  0x5fcb6fab3ad6faecUL, 0x6c44198c4a475817UL
+};
+
+static inline uint64_t load64( const uint8_t *buf )
+{
+  uint64_t val;
+  __builtin_memcpy( &val, buf, sizeof( val ) );
+  return val;
+}
+
+static inline void store64( uint8_t *buf, uint64_t val )
+{
+  __builtin_memcpy( buf, &val, sizeof( val ) );
+}
+
+static inline uint64_t rotr( uint64_t val, unsigned n )
+{
+  return ( val >> n ) | ( val << ( 64 - n ) );
+}
+
+sha512::sha512()
+{
+  init();
+}
+
+void sha512::init()
+{
+  h_[0] = 0x6a09e667f3bcc908UL;
+  h_[1] = 0xbb67ae8584caa73bUL;
+  h_[2] = 0x3c6ef372fe94f82bUL;
+  h_[3] = 0xa54ff53a5f1d36f1UL;
+  h_[4] = 0x510e527fade682d1UL;
+  h_[5] = 0x9b05688c2b3e6c1fUL;
+  h_[6] = 0x1f83d9abfb41bd6bUL;
+  h_[7] = 0x5be0cd19137e2179UL;
+  num_ = 0UL;
+}
+
+void sha512::add( const uint8_t *buf, size_t len )
+{
+  size_t off = num_ % sizeof( buf_ );
+  num_ += len;
+  if ( off ) {
+    size_t num = sizeof( buf_ ) - off;
+    if ( len < num ) {
+      __builtin_memcpy( &buf_[off], buf, len );
+      return;
+    }
+    __builtin_memcpy( &buf_[off], buf, num );
+    block( buf_ );
+    buf += num;
+    len -= num;
+  }
+  for( ; len >= sizeof( buf_ ); buf += sizeof( buf_ ) ) {
+    block( buf );
+    len -= sizeof( buf_ );
+  }
+  __builtin_memcpy( buf_, buf, len );
+}
+
+void sha512::fini( uint8_t *res )
+{
+  size_t off = num_ % sizeof( buf_ );
+  buf_[off++] = 0x80;
+  if ( off > sizeof( buf_ ) - 16 ) {
+    __builtin_memset( &buf_[off], 0, sizeof( buf_ ) - off );
+    block( buf_ );
+    off = 0;
+  }
+  __builtin_memset( &buf_[off], 0, sizeof( buf_ ) - 8 - off );
+  store64( &buf_[sizeof( buf_ ) - 8], __builtin_bswap64( num_ << 3 ) );
+  block( buf_ );
+  for( unsigned i = 0; i != 8; ++i ) {
+    store64( &res[i*8], __builtin_bswap64( h_[i] ) );
+  }
+}
+
+void sha512::block( const uint8_t *buf )
+{
+  uint64_t w[80];
+  for( unsigned i = 0; i != 16; ++i ) {
+    w[i] = __builtin_bswap64( load64( &buf[i*8] ) );
+  }
+  for( unsigned i = 16; i != 80; ++i ) {
+    uint64_t s0 = rotr( w[i-15], 1 ) ^ rotr( w[i-15], 8 ) ^ ( w[i-15] >> 7 );
+    uint64_t s1 = rotr( w[i-2], 19 ) ^ rotr( w[i-2], 61 ) ^ ( w[i-2] >> 6 );
+    w[i] = w[i-16] + s0 + w[i-7] + s1;
+  }
+  uint64_t a = h_[0], b = h_[1], c = h_[2], d = h_[3];
+  uint64_t e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+  for( unsigned i = 0; i != 80; ++i ) {
+    uint64_t s1 = rotr( e, 14 ) ^ rotr( e, 18 ) ^ rotr( e, 41 );
+    uint64_t t1 = h + s1 + ( ( e & f ) ^ ( ~e & g ) ) + sha512_k[i] + w[i];
+    uint64_t s0 = rotr( a, 28 ) ^ rotr( a, 34 ) ^ rotr( a, 39 );
+    uint64_t t2 = s0 + ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  h_[0] += a;
+  h_[1] += b;
+  h_[2] += c;
+  h_[3] += d;
+  h_[4] += e;
+  h_[5] += f;
+  h_[6] += g;
+  h_[7] += h;
+}
+
+namespace
+{
+  // field element
+  struct fe
+  {
+    uint64_t v_[5];
+  };
+
+  // curve points in projective (p2), extended (p3) and completed (p1p1)
+  // coordinates
+  struct ge_p2
+  {
+    fe x_, y_, z_;
+  };
+
+  struct ge_p3
+  {
+    fe x_, y_, z_, t_;
+  };
+
+  struct ge_p1p1
+  {
+    fe x_, y_, z_, t_;
+  };
+
+  // affine point prepared for mixed addition
+  struct ge_precomp
+  {
+    fe ypx_, ymx_, xy2d_;
+  };
+
+  // extended point prepared for addition
+  struct ge_cached
+  {
+    fe ypx_, ymx_, z_, t2d_;
+  };
+
+  // curve constants and multiples of the base point B. base_[i][j]
+  // is (j+1)*256^i*B
+  struct ge_table
+  {
+    ge_table();
+    fe         d_;        // -121665/121666
+    fe         d2_;       // 2*d
+    fe         sqrtm1_;   // sqrt(-1)
+    ge_precomp base_[32][8];
+  };
+}
+
+static void fe_set( fe& h, uint64_t val )
+{
+  h.v_[0] = val;
+  h.v_[1] = h.v_[2] = h.v_[3] = h.v_[4] = 0UL;
+}
+
+static inline void fe_carry( fe& h )
+{
+  uint64_t c;
+  c = h.v_[0] >> 51; h.v_[0] &= PC_FE_MASK; h.v_[1] += c;
+  c = h.v_[1] >> 51; h.v_[1] &= PC_FE_MASK; h.v_[2] += c;
+  c = h.v_[2] >> 51; h.v_[2] &= PC_FE_MASK; h.v_[3] += c;
+  c = h.v_[3] >> 51; h.v_[3] &= PC_FE_MASK; h.v_[4] += c;
+  c = h.v_[4] >> 51; h.v_[4] &= PC_FE_MASK; h.v_[0] += c * 19;
+}
+
+static inline void fe_add( fe& h, const fe& f, const fe& g )
+{
+  for( unsigned i = 0; i != 5; ++i ) {
+    h.v_[i] = f.v_[i] + g.v_[i];
+  }
+  fe_carry( h );
+}
+
+// adds 4*p so limbs cannot underflow
+static inline void fe_sub( fe& h, const fe& f, const fe& g )
+{
+  h.v_[0] = ( f.v_[0] + 0x1fffffffffffb4UL ) - g.v_[0];
+  h.v_[1] = ( f.v_[1] + 0x1ffffffffffffcUL ) - g.v_[1];
+  h.v_[2] = ( f.v_[2] + 0x1ffffffffffffcUL ) - g.v_[2];
+  h.v_[3] = ( f.v_[3] + 0x1ffffffffffffcUL ) - g.v_[3];
+  h.v_[4] = ( f.v_[4] + 0x1ffffffffffffcUL ) - g.v_[4];
+  fe_carry( h );
+}
+
+static inline void fe_reduce( fe& h, uint128_t r0, uint128_t r1,
+                              uint128_t r2, uint128_t r3, uint128_t r4 )
+{
+  uint64_t c;
+  r1 += (uint64_t)( r0 >> 51 );
+  r2 += (uint64_t)( r1 >> 51 );
+  r3 += (uint64_t)( r2 >> 51 );
+  r4 += (uint64_t)( r3 >> 51 );
+  h.v_[0] = (uint64_t)r0 & PC_FE_MASK;
+  h.v_[1] = (uint64_t)r1 & PC_FE_MASK;
+  h.v_[2] = (uint64_t)r2 & PC_FE_MASK;
+  h.v_[3] = (uint64_t)r3 & PC_FE_MASK;
+  h.v_[4] = (uint64_t)r4 & PC_FE_MASK;
+  h.v_[0] += (uint64_t)( r4 >> 51 ) * 19;
+  c = h.v_[0] >> 51; h.v_[0] &= PC_FE_MASK; h.v_[1] += c;
+}
+
+static void fe_mul( fe& h, const fe& f, const fe& g )
+{
+  uint128_t f0 = f.v_[0], f1 = f.v_[1], f2 = f.v_[2];
+  uint128_t f3 = f.v_[3], f4 = f.v_[4];
+  uint64_t g0 = g.v_[0], g1 = g.v_[1], g2 = g.v_[2];
+  uint64_t g3 = g.v_[3], g4 = g.v_[4];
+  uint64_t g1_19 = g1 * 19, g2_19 = g2 * 19;
+  uint64_t g3_19 = g3 * 19, g4_19 = g4 * 19;
+  fe_reduce( h,
+      f0*g0 + f1*g4_19 + f2*g3_19 + f3*g2_19 + f4*g1_19,
+      f0*g1 + f1*g0 + f2*g4_19 + f3*g3_19 + f4*g2_19,
+      f0*g2 + f1*g1 + f2*g0 + f3*g4_19 + f4*g3_19,
+      f0*g3 + f1*g2 + f2*g1 + f3*g0 + f4*g4_19,
+      f0*g4 + f1*g3 + f2*g2 + f3*g1 + f4*g0 );
+}
+
+static void fe_sq( fe& h, const fe& f )
+{
+  uint128_t f0 = f.v_[0], f1 = f.v_[1], f2 = f.v_[2];
+  uint128_t f3 = f.v_[3], f4 = f.v_[4];
+  uint64_t f0_2 = f.v_[0] * 2, f1_2 = f.v_[1] * 2;
+  uint64_t f1_38 = f.v_[1] * 38, f2_38 = f.v_[2] * 38;
+  uint64_t f3_38 = f.v_[3] * 38, f3_19 = f.v_[3] * 19;
+  uint64_t f4_19 = f.v_[4] * 19;
+  fe_reduce( h,
+      f0*f0 + f4*f1_38 + f3*f2_38,
+      f1*f0_2 + f4*f2_38 + f3*f3_19,
+      f2*f0_2 + f1*f1 + f4*f3_38,
+      f3*f0_2 + f2*f1_2 + f4*f4_19,
+      f4*f0_2 + f3*f1_2 + f2*f2 );
+}
+
+// h = f^(2^n)
+static void fe_sqn( fe& h, const fe& f, unsigned n )
+{
+  fe_sq( h, f );
+  while( --n ) {
+    fe_sq( h, h );
+  }
+}
+
+// z^(p-2)
+static void fe_invert( fe& h, const fe& z )
+{
+  fe t0, t1, t2, t3;
+  fe_sq( t0, z );
+  fe_sqn( t1, t0, 2 );
+  fe_mul( t1, z, t1 );
+  fe_mul( t0, t0, t1 );
+  fe_sq( t2, t0 );
+  fe_mul( t1, t1, t2 );
+  fe_sqn( t2, t1, 5 );
+  fe_mul( t1, t2, t1 );
+  fe_sqn( t2, t1, 10 );
+  fe_mul( t2, t2, t1 );
+  fe_sqn( t3, t2, 20 );
+  fe_mul( t2, t3, t2 );
+  fe_sqn( t2, t2, 10 );
+  fe_mul( t1, t2, t1 );
+  fe_sqn( t2, t1, 50 );
+  fe_mul( t2, t2, t1 );
+  fe_sqn( t3, t2, 100 );
+  fe_mul( t2, t3, t2 );
+  fe_sqn( t2, t2, 50 );
+  fe_mul( t1, t2, t1 );
+  fe_sqn( t1, t1, 5 );
+  fe_mul( h, t1, t0 );
+}
+
+// z^e for a 256 bit little-endian exponent. not constant time
+static void fe_pow( fe& h, const fe& z, const uint8_t *e )
+{
+  fe r;
+  fe_set( r, 1UL );
+  for( unsigned i = 256; i--; ) {
+    fe_sq( r, r );
+    if ( ( e[i/8] >> ( i % 8 ) ) & 1 ) {
+      fe_mul( r, r, z );
+    }
+  }
+  h = r;
+}
+
+// canonical little-endian encoding
+static void fe_tobytes( uint8_t *s, const fe& h )
+{
+  fe t = h;
+  fe_carry( t );
+  fe_carry( t );
+
+  // t is now below 2^255. add 19 and let the carry out of bit 255
+  // tell whether t >= p
+  t.v_[0] += 19;
+  fe_carry( t );
+  t.v_[0] += 0x8000000000000UL - 19;
+  t.v_[1] += 0x8000000000000UL - 1;
+  t.v_[2] += 0x8000000000000UL - 1;
+  t.v_[3] += 0x8000000000000UL - 1;
+  t.v_[4] += 0x8000000000000UL - 1;
+  t.v_[1] += t.v_[0] >> 51; t.v_[0] &= PC_FE_MASK;
+  t.v_[2] += t.v_[1] >> 51; t.v_[1] &= PC_FE_MASK;
+  t.v_[3] += t.v_[2] >> 51; t.v_[2] &= PC_FE_MASK;
+  t.v_[4] += t.v_[3] >> 51; t.v_[3] &= PC_FE_MASK;
+  t.v_[4] &= PC_FE_MASK;
+
+  store64( &s[0], t.v_[0] | ( t.v_[1] << 51 ) );
+  store64( &s[8], ( t.v_[1] >> 13 ) | ( t.v_[2] << 38 ) );
+  store64( &s[16], ( t.v_[2] >> 26 ) | ( t.v_[3] << 25 ) );
+  store64( &s[24], ( t.v_[3] >> 39 ) | ( t.v_[4] << 12 ) );
+}
+
+static bool fe_eq( const fe& f, const fe& g )
+{
+  uint8_t fs[32], gs[32];
+  fe_tobytes( fs, f );
+  fe_tobytes( gs, g );
+  return __builtin_memcmp( fs, gs, sizeof( fs ) ) == 0;
+}
+
+static unsigned fe_isneg( const fe& f )
+{
+  uint8_t s[32];
+  fe_tobytes( s, f );
+  return s[0] & 1U;
+}
+
+static void fe_neg( fe& h, const fe& f )
+{
+  fe z;
+  fe_set( z, 0UL );
+  fe_sub( h, z, f );
+}
+
+// f = g if b is 1 without branching on b
+static inline void fe_cmov( fe& f, const fe& g, unsigned b )
+{
+  uint64_t mask = 0UL - (uint64_t)b;
+  for( unsigned i = 0; i != 5; ++i ) {
+    f.v_[i] ^= mask & ( f.v_[i] ^ g.v_[i] );
+  }
+}
+
+static const ge_table& get_table()
+{
+  static const ge_table tab;
+  return tab;
+}
+
+static void ge_p3_0( ge_p3& h )
+{
+  fe_set( h.x_, 0UL );
+  fe_set( h.y_, 1UL );
+  fe_set( h.z_, 1UL );
+  fe_set( h.t_, 0UL );
+}
+
+static void ge_p1p1_to_p2( ge_p2& r, const ge_p1p1& p )
+{
+  fe_mul( r.x_, p.x_, p.t_ );
+  fe_mul( r.y_, p.y_, p.z_ );
+  fe_mul( r.z_, p.z_, p.t_ );
+}
+
+static void ge_p1p1_to_p3( ge_p3& r, const ge_p1p1& p )
+{
+  fe_mul( r.x_, p.x_, p.t_ );
+  fe_mul( r.y_, p.y_, p.z_ );
+  fe_mul( r.z_, p.z_, p.t_ );
+  fe_mul( r.t_, p.x_, p.y_ );
+}
+
+static void ge_p2_dbl( ge_p1p1& r, const ge_p2& p )
+{
+  fe t0;
+  fe_sq( r.x_, p.x_ );
+  fe_sq( r.z_, p.y_ );
+  fe_sq( r.t_, p.z_ );
+  fe_add( r.t_, r.t_, r.t_ );
+  fe_add( r.y_, p.x_, p.y_ );
+  fe_sq( t0, r.y_ );
+  fe_add( r.y_, r.z_, r.x_ );
+  fe_sub( r.z_, r.z_, r.x_ );
+  fe_sub( r.x_, t0, r.y_ );
+  fe_sub( r.t_, r.t_, r.z_ );
+}
+
+static void ge_p3_dbl( ge_p1p1& r, const ge_p3& p )
+{
+  ge_p2 q;
+  q.x_ = p.x_;
+  q.y_ = p.y_;
+  q.z_ = p.z_;
+  ge_p2_dbl( r, q );
+}
+
+static void ge_p3_to_cached( ge_cached& r, const ge_p3& p, const fe& d2 )
+{
+  fe_add( r.ypx_, p.y_, p.x_ );
+  fe_sub( r.ymx_, p.y_, p.x_ );
+  r.z_ = p.z_;
+  fe_mul( r.t2d_, p.t_, d2 );
+}
+
+static void ge_p3_to_precomp( ge_precomp& r, const ge_p3& p, const fe& d2 )
+{
+  fe zi, x, y;
+  fe_invert( zi, p.z_ );
+  fe_mul( x, p.x_, zi );
+  fe_mul( y, p.y_, zi );
+  fe_add( r.ypx_, y, x );
+  fe_sub( r.ymx_, y, x );
+  fe_mul( r.xy2d_, x, y );
+  fe_mul( r.xy2d_, r.xy2d_, d2 );
+}
+
+static void ge_p3_tobytes( uint8_t *s, const ge_p3& p )
+{
+  fe zi, x, y;
+  fe_invert( zi, p.z_ );
+  fe_mul( x, p.x_, zi );
+  fe_mul( y, p.y_, zi );
+  fe_tobytes( s, y );
+  s[31] = (uint8_t)( s[31] ^ ( fe_isneg( x ) << 7 ) );
+}
+
+static void ge_add( ge_p1p1& r, const ge_p3& p, const ge_cached& q )
+{
+  fe t0;
+  fe_add( r.x_, p.y_, p.x_ );
+  fe_sub( r.y_, p.y_, p.x_ );
+  fe_mul( r.z_, r.x_, q.ypx_ );
+  fe_mul( r.y_, r.y_, q.ymx_ );
+  fe_mul( r.t_, q.t2d_, p.t_ );
+  fe_mul( r.x_, p.z_, q.z_ );
+  fe_add( t0, r.x_, r.x_ );
+  fe_sub( r.x_, r.z_, r.y_ );
+  fe_add( r.y_, r.z_, r.y_ );
+  fe_add( r.z_, t0, r.t_ );
+  fe_sub( r.t_, t0, r.t_ );
+}
+
+static void ge_madd( ge_p1p1& r, const ge_p3& p, const ge_precomp& q )
+{
+  fe t0;
+  fe_add( r.x_, p.y_, p.x_ );
+  fe_sub( r.y_, p.y_, p.x_ );
+  fe_mul( r.z_, r.x_, q.ypx_ );
+  fe_mul( r.y_, r.y_, q.ymx_ );
+  fe_mul( r.t_, q.xy2d_, p.t_ );
+  fe_add( t0, p.z_, p.z_ );
+  fe_sub( r.x_, r.z_, r.y_ );
+  fe_add( r.y_, r.z_, r.y_ );
+  fe_add( r.z_, t0, r.t_ );
+  fe_sub( r.t_, t0, r.t_ );
+}
+
+ge_table::ge_table()
+{
+  // (p-5)/8 = 2^252-3 and (p-1)/4 = 2^253-5
+  uint8_t e58[32], e14[32];
+  __builtin_memset( e58, 0xff, sizeof( e58 ) );
+  __builtin_memset( e14, 0xff, sizeof( e14 ) );
+  e58[0] = 0xfd;
+  e58[31] = 0x0f;
+  e14[0] = 0xfb;
+  e14[31] = 0x1f;
+
+  fe one, t;
+  fe_set( one, 1UL );
+  fe_set( t, 121666UL );
+  fe_invert( t, t );
+  fe_set( d_, 121665UL );
+  fe_mul( d_, d_, t );
+  fe_neg( d_, d_ );
+  fe_add( d2_, d_, d_ );
+  fe_set( t, 2UL );
+  fe_pow( sqrtm1_, t, e14 );
+
+  // base point B has y = 4/5 and even x
+  fe x, y, u, v, v3, chk;
+  fe_set( t, 5UL );
+  fe_invert( t, t );
+  fe_set( y, 4UL );
+  fe_mul( y, y, t );
+  fe_sq( u, y );
+  fe_mul( v, u, d_ );
+  fe_sub( u, u, one );
+  fe_add( v, v, one );
+  fe_sq( v3, v );
+  fe_mul( v3, v3, v );
+  fe_sq( x, v3 );
+  fe_mul( x, x, v );
+  fe_mul( x, x, u );
+  fe_pow( x, x, e58 );
+  fe_mul( x, x, v3 );
+  fe_mul( x, x, u );
+  fe_sq( chk, x );
+  fe_mul( chk, chk, v );
+  if ( !fe_eq( chk, u ) ) {
+    fe_mul( x, x, sqrtm1_ );
+  }
+  if ( fe_isneg( x ) ) {
+    fe_neg( x, x );
+  }
+
+  ge_p3 bp;
+  bp.x_ = x;
+  bp.y_ = y;
+  fe_set( bp.z_, 1UL );
+  fe_mul( bp.t_, x, y );
+  for( unsigned i = 0; i != 32; ++i ) {
+    ge_cached bc;
+    ge_p3_to_cached( bc, bp, d2_ );
+    ge_p3 cur = bp;
+    ge_p1p1 r;
+    for( unsigned j = 0; j != 8; ++j ) {
+      ge_p3_to_precomp( base_[i][j], cur, d2_ );
+      ge_add( r, cur, bc );
+      ge_p1p1_to_p3( cur, r );
+    }
+    for( unsigned j = 0; j != 8; ++j ) {
+      ge_p3_dbl( r, bp );
+      ge_p1p1_to_p3( bp, r );
+    }
+  }
+}
+
+static inline unsigned ct_eq( unsigned a, unsigned b )
+{
+  return ( ( a ^ b ) - 1U ) >> 31;
+}
+
+// t = b*256^pos*B for b in [-8,8] with table access independent of b
+static void ge_select(
+    ge_precomp& t, const ge_table& tab, unsigned pos, int b )
+{
+  int neg = b >> 31;
+  unsigned babs = (unsigned)( ( b ^ neg ) - neg );
+  fe_set( t.ypx_, 1UL );
+  fe_set( t.ymx_, 1UL );
+  fe_set( t.xy2d_, 0UL );
+  for( unsigned j = 0; j != 8; ++j ) {
+    unsigned is_eq = ct_eq( babs, j + 1 );
+    const ge_precomp& p = tab.base_[pos][j];
+    fe_cmov( t.ypx_, p.ypx_, is_eq );
+    fe_cmov( t.ymx_, p.ymx_, is_eq );
+    fe_cmov( t.xy2d_, p.xy2d_, is_eq );
+  }
+  ge_precomp m;
+  m.ypx_ = t.ymx_;
+  m.ymx_ = t.ypx_;
+  fe_neg( m.xy2d_, t.xy2d_ );
+  unsigned is_neg = (unsigned)( neg & 1 );
+  fe_cmov( t.ypx_, m.ypx_, is_neg );
+  fe_cmov( t.ymx_, m.ymx_, is_neg );
+  fe_cmov( t.xy2d_, m.xy2d_, is_neg );
+}
+
+// h = a*B for a 256 bit scalar with a[31] <= 127
+static void ge_scalarmult_base( ge_p3& h, const uint8_t *a )
+{
+  const ge_table& tab = get_table();
+
+  // signed radix 16 digits in [-8,8]
+  int e[64];
+  for( unsigned i = 0; i != 32; ++i ) {
+    e[2*i] = a[i] & 15;
+    e[2*i+1] = a[i] >> 4;
+  }
+  int carry = 0;
+  for( unsigned i = 0; i != 63; ++i ) {
+    e[i] += carry;
+    carry = ( e[i] + 8 ) >> 4;
+    e[i] -= carry * 16;
+  }
+  e[63] += carry;
+
+  ge_p1p1 r;
+  ge_p2 s;
+  ge_precomp t;
+  ge_p3_0( h );
+  for( unsigned i = 1; i < 64; i += 2 ) {
+    ge_select( t, tab, i/2, e[i] );
+    ge_madd( r, h, t );
+    ge_p1p1_to_p3( h, r );
+  }
+  ge_p3_dbl( r, h );
+  ge_p1p1_to_p2( s, r );
+  ge_p2_dbl( r, s );
+  ge_p1p1_to_p2( s, r );
+  ge_p2_dbl( r, s );
+  ge_p1p1_to_p2( s, r );
+  ge_p2_dbl( r, s );
+  ge_p1p1_to_p3( h, r );
+  for( unsigned i = 0; i < 64; i += 2 ) {
+    ge_select( t, tab, i/2, e[i] );
+    ge_madd( r, h, t );
+    ge_p1p1_to_p3( h, r );
+  }
+}
+
+// group order L = 2^252 + 27742317777372353535851937790883648493
+static const int64_t sc_l[32] = {
+  0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+  0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x10
+};
+
+// r = x mod L for x given as 64 signed byte-sized limbs
+static void sc_modl( uint8_t *r, int64_t *x )
+{
+  int64_t carry;
+  for( int i = 63; i >= 32; --i ) {
+    int j;
+    carry = 0;
+    for( j = i - 32; j < i - 12; ++j ) {
+      x[j] += carry - 16 * x[i] * sc_l[j - ( i - 32 )];
+      carry = ( x[j] + 128 ) >> 8;
+      x[j] -= carry * 256;
+    }
+    x[j] += carry;
+    x[i] = 0;
+  }
+  carry = 0;
+  for( unsigned j = 0; j != 32; ++j ) {
+    x[j] += carry - ( x[31] >> 4 ) * sc_l[j];
+    carry = x[j] >> 8;
+    x[j] &= 255;
+  }
+  for( unsigned j = 0; j != 32; ++j ) {
+    x[j] -= carry * sc_l[j];
+  }
+  for( unsigned i = 0; i != 32; ++i ) {
+    x[i+1] += x[i] >> 8;
+    r[i] = (uint8_t)( x[i] & 255 );
+  }
+}
+
+// reduce 64 byte digest in place to 32 byte scalar
+static void sc_reduce( uint8_t *s )
+{
+  int64_t x[64];
+  for( unsigned i = 0; i != 64; ++i ) {
+    x[i] = s[i];
+  }
+  sc_modl( s, x );
+}
+
+// s = ( r + k*a ) mod L
+static void sc_muladd(
+    uint8_t *s, const uint8_t *k, const uint8_t *a, const uint8_t *r )
+{
+  int64_t x[64];
+  for( unsigned i = 0; i != 32; ++i ) {
+    x[i] = r[i];
+    x[i+32] = 0;
+  }
+  for( unsigned i = 0; i != 32; ++i ) {
+    for( unsigned j = 0; j != 32; ++j ) {
+      x[i+j] += (int64_t)k[i] * a[j];
+    }
+  }
+  sc_modl( s, x );
+}
+
+ed25519::ed25519()
+{
+  zero();
+}
+
+void ed25519::init( const uint8_t *seed )
+{
+  uint8_t h[sha512::len];
+  sha512 dg;
+  dg.add( seed, seed_len );
+  dg.fini( h );
+  h[0] &= 248;
+  h[31] &= 127;
+  h[31] |= 64;
+  __builtin_memcpy( a_, h, sizeof( a_ ) );
+  __builtin_memcpy( pfx_, &h[32], sizeof( pfx_ ) );
+  __builtin_memset( h, 0, sizeof( h ) );
+
+  ge_p3 ap;
+  ge_scalarmult_base( ap, a_ );
+  ge_p3_tobytes( pub_, ap );
+}
+
+void ed25519::zero()
+{
+  __builtin_memset( a_, 0, sizeof( a_ ) );
+  __builtin_memset( pfx_, 0, sizeof( pfx_ ) );
+  __builtin_memset( pub_, 0, sizeof( pub_ ) );
+}
+
+void ed25519::sign( uint8_t *sig, const uint8_t *msg, size_t len ) const
+{
+  // deterministic nonce r = H( prefix || msg ) and R = r*B
+  uint8_t r[sha512::len];
+  sha512 dg;
+  dg.add( pfx_, sizeof( pfx_ ) );
+  dg.add( msg, len );
+  dg.fini( r );
+  sc_reduce( r );
+  ge_p3 rp;
+  ge_scalarmult_base( rp, r );
+  ge_p3_tobytes( sig, rp );
+
+  // S = r + H( R || A || msg )*a
+  uint8_t k[sha512::len];
+  dg.init();
+  dg.add( sig, 32 );
+  dg.add( pub_, sizeof( pub_ ) );
+  dg.add( msg, len );
+  dg.fini( k );
+  sc_reduce( k );
+  sc_muladd( &sig[32], k, a_, r );
+}
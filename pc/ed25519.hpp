@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pc
+{
+
+  // sha-512 message digest (fips 180-4)
+  class sha512
+  {
+  public:
+    static const size_t len = 64;
+
+    sha512();
+
+    // start new digest
+    void init();
+
+    // add message bytes
+    void add( const uint8_t *buf, size_t len );
+
+    // finish digest into len bytes
+    void fini( uint8_t *res );
+
+  private:
+    void block( const uint8_t * );
+
+    uint64_t h_[8];     // chaining state
+    uint64_t num_;      // bytes added
+    uint8_t  buf_[128]; // partial block
+  };
+
+  // ed25519 signing key (rfc 8032) expanded once from its secret seed.
+  // signing only needs two digests and a fixed-base scalar multiplication
+  // over a precomputed table, does not allocate and is thread safe
+  class ed25519
+  {
+  public:
+    static const size_t seed_len = 32;
+    static const size_t pub_len  = 32;
+    static const size_t sig_len  = 64;
+
+    ed25519();
+
+    // expand 32 byte secret seed and derive public key
+    void init( const uint8_t *seed );
+
+    // erase expanded key
+    void zero();
+
+    // sign message into sig_len bytes
+    void sign( uint8_t *sig, const uint8_t *msg, size_t len ) const;
+
+    // encoded public key
+    const uint8_t *get_pub_key() const;
+
+  private:
+    uint8_t a_[32];   // clamped secret scalar
+    uint8_t pfx_[32]; // nonce prefix
+    uint8_t pub_[32]; // encoded public point a*B
+  };
+
+  inline const uint8_t *ed25519::get_pub_key() const
+  {
+    return pub_;
+  }
+
+}
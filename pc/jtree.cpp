@@ -1,12 +1,301 @@
 #include "jtree.hpp"
-#include <ctype.h>
 #include <stdlib.h>
+#include <atomic>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace pc;
 
+jpath::jpath( std::initializer_list<const char *> keys )
+{
+  for( const char *key: keys ) {
+    vec_.push_back( elem{ jkey( key ), 0 } );
+  }
+}
+
 jtree::jtree()
-: key_( 0 ), buf_( nullptr  )
+: key_( 0 ), khash_( 0 ), buf_( nullptr  )
+{
+}
+
+///////////////////////////////////////////////////////////////////////////
+// stage 1: structural index
+//
+// input is classified in 64-byte blocks into bitmasks. unescaped
+// quotes delimit strings (tracked with a prefix xor), and outside
+// strings the index records brackets, quotes and the first character
+// of every run of characters that are neither whitespace nor one of
+// {}[]":, (i.e. numbers and keywords)
+
+namespace {
+
+  struct jblock
+  {
+    uint64_t qt_;   // '"'
+    uint64_t bs_;   // '\\'
+    uint64_t ws_;   // whitespace
+    uint64_t op_;   // {}[]":,
+    uint64_t br_;   // {}[]
+  };
+
+  struct jstate
+  {
+    uint64_t esc_;  // first character of next block is escaped
+    uint64_t str_;  // next block starts inside string (all ones)
+    uint64_t run_;  // last character of block was part of a run
+  };
+
+  inline bool is_ws( char c )
+  {
+    return c == ' ' || ( c >= '\t' && c <= '\r' );
+  }
+
+  inline bool is_op( char c )
+  {
+    return c == '{' || c == '}' || c == '[' || c == ']' ||
+           c == '"' || c == ':' || c == ',';
+  }
+
+  inline bool is_num( char c )
+  {
+    return ( c >= '0' && c <= '9' ) || c == '.' || c == '-' ||
+      c == 'e' || c == '+';
+  }
+
+  inline bool is_alpha( char c )
+  {
+    return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' );
+  }
+
+#if defined(__x86_64__)
+
+  struct jsse42
+  {
+    __attribute__((target("sse4.2")))
+    static uint64_t mask( __m128i v, unsigned i )
+    {
+      return (uint64_t)(uint32_t)_mm_movemask_epi8( v ) << i;
+    }
+
+    __attribute__((target("sse4.2")))
+    static void classify( const char *cptr, jblock& blk )
+    {
+      const __m128i qt = _mm_set1_epi8( '"' );
+      const __m128i bs = _mm_set1_epi8( '\\' );
+      const __m128i sp = _mm_set1_epi8( ' ' );
+      const __m128i tb = _mm_set1_epi8( '\t' );
+      const __m128i n4 = _mm_set1_epi8( 4 );
+      const __m128i lc = _mm_set1_epi8( 0x20 );
+      const __m128i ob = _mm_set1_epi8( '{' );
+      const __m128i cb = _mm_set1_epi8( '}' );
+      const __m128i cl = _mm_set1_epi8( ':' );
+      const __m128i cm = _mm_set1_epi8( ',' );
+      blk.qt_ = blk.bs_ = blk.ws_ = blk.op_ = blk.br_ = 0;
+      for( unsigned i=0; i != 64; i += 16 ) {
+        __m128i v = _mm_loadu_si128( (const __m128i*)&cptr[i] );
+        __m128i t = _mm_sub_epi8( v, tb );
+        __m128i l = _mm_or_si128( v, lc );
+        __m128i q = _mm_cmpeq_epi8( v, qt );
+        __m128i r = _mm_or_si128(
+            _mm_cmpeq_epi8( l, ob ), _mm_cmpeq_epi8( l, cb ) );
+        __m128i o = _mm_or_si128( _mm_or_si128( r, q ), _mm_or_si128(
+              _mm_cmpeq_epi8( v, cl ), _mm_cmpeq_epi8( v, cm ) ) );
+        __m128i w = _mm_or_si128( _mm_cmpeq_epi8( v, sp ),
+            _mm_cmpeq_epi8( _mm_min_epu8( t, n4 ), t ) );
+        blk.qt_ |= mask( q, i );
+        blk.bs_ |= mask( _mm_cmpeq_epi8( v, bs ), i );
+        blk.ws_ |= mask( w, i );
+        blk.op_ |= mask( o, i );
+        blk.br_ |= mask( r, i );
+      }
+    }
+  };
+
+  struct javx2
+  {
+    __attribute__((target("avx2")))
+    static uint64_t mask( __m256i lo, __m256i hi )
+    {
+      return (uint64_t)(uint32_t)_mm256_movemask_epi8( lo ) |
+        ( (uint64_t)(uint32_t)_mm256_movemask_epi8( hi ) << 32 );
+    }
+
+    __attribute__((target("avx2")))
+    static void classify( const char *cptr, jblock& blk )
+    {
+      const __m256i qt = _mm256_set1_epi8( '"' );
+      const __m256i bs = _mm256_set1_epi8( '\\' );
+      const __m256i sp = _mm256_set1_epi8( ' ' );
+      const __m256i tb = _mm256_set1_epi8( '\t' );
+      const __m256i n4 = _mm256_set1_epi8( 4 );
+      const __m256i lc = _mm256_set1_epi8( 0x20 );
+      const __m256i ob = _mm256_set1_epi8( '{' );
+      const __m256i cb = _mm256_set1_epi8( '}' );
+      const __m256i cl = _mm256_set1_epi8( ':' );
+      const __m256i cm = _mm256_set1_epi8( ',' );
+      __m256i v[2], q[2], b[2], w[2], r[2], o[2];
+      v[0] = _mm256_loadu_si256( (const __m256i*)&cptr[0] );
+      v[1] = _mm256_loadu_si256( (const __m256i*)&cptr[32] );
+      for( unsigned i=0; i != 2; ++i ) {
+        // whitespace is ' ' or '\t'..'\r' (unsigned c-'\t' <= 4)
+        __m256i t = _mm256_sub_epi8( v[i], tb );
+        __m256i l = _mm256_or_si256( v[i], lc );
+        q[i] = _mm256_cmpeq_epi8( v[i], qt );
+        b[i] = _mm256_cmpeq_epi8( v[i], bs );
+        w[i] = _mm256_or_si256( _mm256_cmpeq_epi8( v[i], sp ),
+            _mm256_cmpeq_epi8( _mm256_min_epu8( t, n4 ), t ) );
+        r[i] = _mm256_or_si256( _mm256_cmpeq_epi8( l, ob ),
+            _mm256_cmpeq_epi8( l, cb ) );
+        o[i] = _mm256_or_si256( _mm256_or_si256( r[i], q[i] ),
+            _mm256_or_si256( _mm256_cmpeq_epi8( v[i], cl ),
+              _mm256_cmpeq_epi8( v[i], cm ) ) );
+      }
+      blk.qt_ = mask( q[0], q[1] );
+      blk.bs_ = mask( b[0], b[1] );
+      blk.ws_ = mask( w[0], w[1] );
+      blk.op_ = mask( o[0], o[1] );
+      blk.br_ = mask( r[0], r[1] );
+    }
+  };
+
+#endif
+
+  // characters escaped by an odd-length backslash sequence
+  inline uint64_t get_escaped( uint64_t bs, uint64_t& esc )
+  {
+    uint64_t res = esc;
+    bs &= ~esc;
+    esc = 0;
+    while( bs ) {
+      uint64_t bit = bs & -bs;
+      if ( bit == 1UL << 63 ) {
+        esc = 1;
+      } else {
+        res |= bit << 1;
+        bs &= ~( bit << 1 );
+      }
+      bs &= bs - 1;
+    }
+    return res;
+  }
+
+  inline uint64_t prefix_xor( uint64_t x )
+  {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+  }
+
+  inline uint32_t *flatten( uint64_t bits, uint32_t pos, uint32_t *ix )
+  {
+    while( bits ) {
+      *ix++ = pos + (uint32_t)__builtin_ctzll( bits );
+      bits &= bits - 1;
+    }
+    return ix;
+  }
+
+  template<class C>
+  inline __attribute__((always_inline))
+  uint32_t *index_block( const char *cptr, uint32_t pos,
+                         jstate& st, uint32_t *ix )
+  {
+    jblock blk;
+    C::classify( cptr, blk );
+    uint64_t qt = blk.qt_;
+    if ( blk.bs_ | st.esc_ ) {
+      qt &= ~get_escaped( blk.bs_, st.esc_ );
+    }
+    uint64_t in_str = prefix_xor( qt ) ^ st.str_;
+    st.str_ = (uint64_t)( (int64_t)in_str >> 63 );
+    uint64_t run = ~( blk.ws_ | blk.op_ | in_str );
+    uint64_t run_start = run & ~( ( run << 1 ) | st.run_ );
+    st.run_ = run >> 63;
+    return flatten( ( blk.br_ & ~in_str ) | qt | run_start, pos, ix );
+  }
+
+  template<class C>
+  inline __attribute__((always_inline))
+  size_t index_all( const char *cptr, size_t sz, uint32_t *ix )
+  {
+    jstate st = { 0, 0, 0 };
+    uint32_t *beg = ix;
+    size_t i = 0;
+    for( ; i + 64 <= sz; i += 64 ) {
+      ix = index_block<C>( &cptr[i], (uint32_t)i, st, ix );
+    }
+    if ( i < sz ) {
+      // pad final partial block with whitespace
+      char buf[64];
+      __builtin_memset( buf, ' ', sizeof( buf ) );
+      __builtin_memcpy( buf, &cptr[i], sz - i );
+      ix = index_block<C>( buf, (uint32_t)i, st, ix );
+    }
+    return (size_t)( ix - beg );
+  }
+
+#if defined(__x86_64__)
+
+  __attribute__((target("sse4.2")))
+  size_t index_sse42( const char *cptr, size_t sz, uint32_t *ix )
+  {
+    return index_all<jsse42>( cptr, sz, ix );
+  }
+
+  __attribute__((target("avx2")))
+  size_t index_avx2( const char *cptr, size_t sz, uint32_t *ix )
+  {
+    return index_all<javx2>( cptr, sz, ix );
+  }
+
+#endif
+
+  jtree::simd_t get_best_simd()
+  {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) ) {
+      return jtree::e_avx2;
+    }
+    if ( __builtin_cpu_supports( "sse4.2" ) ) {
+      return jtree::e_sse42;
+    }
+#endif
+    return jtree::e_scalar;
+  }
+
+  std::atomic<int> simd_( get_best_simd() );
+
+}
+
+void jtree::set_simd( simd_t val )
+{
+  simd_t best = get_best_simd();
+  simd_.store( val < best ? val : best, std::memory_order_relaxed );
+}
+
+jtree::simd_t jtree::get_simd()
 {
+  return (simd_t)simd_.load( std::memory_order_relaxed );
+}
+
+size_t jtree::index( const char *cptr, size_t sz )
+{
+  if ( ix_.size() < sz ) {
+    ix_.resize( sz );
+  }
+  switch( get_simd() ) {
+#if defined(__x86_64__)
+    case e_avx2:  return index_avx2( cptr, sz, ix_.data() );
+    case e_sse42: return index_sse42( cptr, sz, ix_.data() );
+#endif
+    default:      return 0;
+  }
 }
 
 void jtree::parse( const char *cptr, size_t sz )
@@ -16,6 +305,22 @@ void jtree::parse( const char *cptr, size_t sz )
   nv_.resize(1);
   st_.clear();
 
+  // offsets are stored in 24/32 bits
+  if ( sz >= ( 1UL << 32 ) ) {
+    return;
+  }
+  if ( get_simd() == e_scalar ) {
+    parse_bytes( cptr, sz );
+  } else {
+    parse_index( cptr, sz );
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// byte at a time parser used without simd support
+
+void jtree::parse_bytes( const char *cptr, size_t sz )
+{
   typedef enum { e_start, e_string, e_number, e_keyword } state_t;
   state_t st = e_start;
   const char *txt=nullptr, *end = &cptr[sz];
@@ -34,7 +339,8 @@ void jtree::parse( const char *cptr, size_t sz )
             parse_end_array();
           } else if ( *cptr == '"' ) {
             st = e_string; txt=cptr+1; break;
-          } else if ( *cptr == '-' || *cptr == '.' || isdigit(*cptr)) {
+          } else if ( *cptr == '-' || *cptr == '.' ||
+                      ( *cptr >= '0' && *cptr <= '9' ) ) {
             st = e_number; txt=cptr; break;
           } else if ( *cptr == 't' || *cptr == 'f' || *cptr == 'n' ) {
             st = e_keyword; txt=cptr; break;
@@ -47,7 +353,10 @@ void jtree::parse( const char *cptr, size_t sz )
       case e_string: {
         for(;;++cptr) {
           if( cptr==end ) return;
-          if (*cptr == '"' ) {
+          if ( *cptr == '\\' ) {
+            // skip escaped character
+            if( ++cptr==end ) return;
+          } else if (*cptr == '"' ) {
             st = e_start;
             const char *etxt = cptr;
             // peek if this is a key
@@ -56,7 +365,7 @@ void jtree::parse( const char *cptr, size_t sz )
               if ( *cptr == ':' ) {
                 parse_key( txt, etxt );
                 break;
-              } else if ( !isspace(*cptr) ) {
+              } else if ( !is_ws(*cptr) ) {
                 parse_string( txt, etxt );
                 break;
               }
@@ -70,8 +379,7 @@ void jtree::parse( const char *cptr, size_t sz )
       case e_number: {
         for(;;++cptr) {
           if( cptr==end ) return;
-          if ( !isdigit(*cptr) && *cptr!='.' &&
-               *cptr!='-' && *cptr!='e' && *cptr!='+' ) {
+          if ( !is_num(*cptr) ) {
             st = e_start; parse_number( txt, cptr );break;
           }
         }
@@ -81,7 +389,7 @@ void jtree::parse( const char *cptr, size_t sz )
       case e_keyword:{
         for(;;++cptr) {
           if ( cptr==end ) return;
-          if (!isalpha(*cptr) ) {
+          if (!is_alpha(*cptr) ) {
             st = e_start; parse_keyword( txt, cptr ); break;
           }
         }
@@ -91,6 +399,61 @@ void jtree::parse( const char *cptr, size_t sz )
   }
 }
 
+///////////////////////////////////////////////////////////////////////////
+// stage 2: build tree from structural index
+
+void jtree::parse_index( const char *cptr, size_t sz )
+{
+  size_t num = index( cptr, sz );
+  const uint32_t *ix = ix_.data(), *eix = &ix[num];
+  const char *end = &cptr[sz];
+  while( ix != eix ) {
+    const char *txt = &cptr[*ix++];
+    switch( *txt ) {
+      case '{': parse_start_object(); break;
+      case '[': parse_start_array(); break;
+      case '}': parse_end_object(); break;
+      case ']': parse_end_array(); break;
+      case '"': {
+        // next index entry is always the closing quote
+        if ( ix == eix ) return;
+        const char *etxt = &cptr[*ix++];
+        // peek if this is a key
+        for( const char *pptr = etxt+1;; ++pptr ) {
+          if ( pptr == end ) return;
+          if ( *pptr == ':' ) {
+            parse_key( txt+1, etxt );
+            break;
+          } else if ( !is_ws( *pptr ) ) {
+            parse_string( txt+1, etxt );
+            break;
+          }
+        }
+        break;
+      }
+      default: {
+        // run of numbers, keywords and ignored characters
+        while( txt != end && !is_ws( *txt ) && !is_op( *txt ) ) {
+          const char *ptr = txt;
+          if ( *ptr == '-' || *ptr == '.' || ( *ptr >= '0' && *ptr <= '9' ) ) {
+            for( ++ptr; ptr != end && is_num( *ptr ); ++ptr );
+            if ( ptr == end ) return;
+            parse_number( txt, ptr );
+          } else if ( *ptr == 't' || *ptr == 'f' || *ptr == 'n' ) {
+            for( ++ptr; ptr != end && is_alpha( *ptr ); ++ptr );
+            if ( ptr == end ) return;
+            parse_keyword( txt, ptr );
+          } else {
+            ++ptr;
+          }
+          txt = ptr;
+        }
+        break;
+      }
+    }
+  }
+}
+
 bool jtree::is_valid() const
 {
   return nv_.size()>1 && st_.empty();
@@ -105,12 +468,14 @@ uint32_t jtree::new_node(type_t t, uint32_t i, uint32_t j )
   nd.next_ = 0;
   nd.h_    = i;
   nd.t_    = j;
+  nd.hash_ = 0;
   return nxt;
 }
 
 void jtree::add_obj( uint32_t val )
 {
   uint32_t kvidx = new_node( e_keyval, key_, val );
+  nv_[kvidx].hash_ = khash_;
   add_arr( kvidx );
 }
 
@@ -153,17 +518,22 @@ void jtree::parse_start_array()
 
 void jtree::parse_end_object()
 {
-  st_.pop_back();
+  if ( !st_.empty() ) {
+    st_.pop_back();
+  }
 }
 
 void jtree::parse_end_array()
 {
-  st_.pop_back();
+  if ( !st_.empty() ) {
+    st_.pop_back();
+  }
 }
 
 void jtree::parse_key( const char *txt, const char *end )
 {
   key_ = new_node( e_val, txt-buf_, end-txt );
+  khash_ = jkey::hash( txt, (size_t)( end-txt ) );
 }
 
 void jtree::parse_number( const char *txt, const char *end)
@@ -181,16 +551,59 @@ void jtree::parse_keyword( const char *txt, const char *end)
   parse_string( txt, end );
 }
 
-uint32_t jtree::find_val( uint32_t obj, str key ) const
+bool jtree::is_key( uint32_t it, str key, uint32_t hash ) const
 {
-  for(uint32_t it=get_first(obj); it; it = get_next(it) ) {
-    if ( e_keyval == get_type( it ) ) {
-      if ( key == get_str( get_key( it ) ) ) {
-        return get_val( it );
-      }
-    } else {
+  const node& n = nv_[it];
+  return n.hash_ == hash && key == get_str( n.k_ );
+}
+
+uint32_t jtree::find_val(
+    uint32_t obj, str key, uint32_t hash, uint32_t& pos ) const
+{
+  // try cached position
+  uint32_t it = get_first( obj ), i = 0;
+  if ( pos ) {
+    for( ; it && i != pos; ++i ) {
+      it = get_next( it );
+    }
+    if ( it && e_keyval == get_type( it ) && is_key( it, key, hash ) ) {
+      return get_val( it );
+    }
+    it = get_first( obj );
+    i = 0;
+  }
+
+  // scan object
+  for( ; it; it = get_next( it ), ++i ) {
+    if ( e_keyval != get_type( it ) ) {
       break;
     }
+    if ( is_key( it, key, hash ) ) {
+      pos = i;
+      return get_val( it );
+    }
   }
   return 0;
 }
+
+uint32_t jtree::find_val( uint32_t obj, str key ) const
+{
+  return find_val( obj, jkey( key ) );
+}
+
+uint32_t jtree::find_val( uint32_t obj, const jkey& key ) const
+{
+  uint32_t pos = 0;
+  return find_val( obj, key.get_str(), key.get_hash(), pos );
+}
+
+uint32_t jtree::find_val( uint32_t obj, jpath& path ) const
+{
+  for( jpath::elem& e: path.vec_ ) {
+    if ( !obj || get_type( obj ) != e_obj ) {
+      return 0;
+    }
+    obj = find_val( obj, e.key_.get_str(), e.key_.get_hash(), e.pos_ );
+  }
+  return obj;
+}
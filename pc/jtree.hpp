@@ -1,11 +1,47 @@
 #pragma once
 
 #include <pc/misc.hpp>
+#include <initializer_list>
 #include <vector>
 #include <stdint.h>
 
 namespace pc
 {
+  class jtree;
+
+  // object key with precomputed hash
+  class jkey
+  {
+  public:
+    jkey( str );
+    str      get_str() const;
+    uint32_t get_hash() const;
+
+    static uint32_t hash( const char *, size_t );
+
+  private:
+    str      key_;
+    uint32_t hash_;
+  };
+
+  // path of nested object keys resolved in one pass. caches the
+  // position of each key among its siblings in the last tree searched
+  // so that messages of the same shape resolve without any scanning.
+  // not thread-safe: use one instance per parsing thread
+  class jpath
+  {
+  public:
+    jpath( std::initializer_list<const char *> );
+
+  private:
+    friend class jtree;
+    struct elem {
+      jkey     key_;
+      uint32_t pos_;
+    };
+    std::vector<elem> vec_;
+  };
+
   // light-weight json parse tree
   class jtree
   {
@@ -18,12 +54,25 @@ namespace pc
       e_val
     } type_t;
 
+    // structural index (stage 1) implementation. e_scalar skips the
+    // index and parses a byte at a time
+    typedef enum {
+      e_scalar = 0,
+      e_sse42,
+      e_avx2
+    } simd_t;
+
     jtree();
 
     // parse message
     void parse( const char *, size_t );
     bool is_valid() const;
 
+    // select stage 1 implementation (for all threads). falls back to
+    // the best one supported by the cpu. defaults to the best available
+    static void set_simd( simd_t );
+    static simd_t get_simd();
+
     // get first element in tree
     type_t   get_type( uint32_t ) const;
     uint32_t get_next( uint32_t ) const;
@@ -45,6 +94,10 @@ namespace pc
 
     // find value in object associated with key
     uint32_t find_val( uint32_t obj, str key ) const;
+    uint32_t find_val( uint32_t obj, const jkey& ) const;
+
+    // find value at end of path of keys starting from obj
+    uint32_t find_val( uint32_t obj, jpath& ) const;
 
   public:
 
@@ -67,24 +120,61 @@ namespace pc
         struct { uint32_t k_; uint32_t v_; }; // key/value pair
         struct { uint32_t p_; uint32_t s_; }; // pos/size offsets
       };
+      uint32_t hash_;                         // key hash of key/value
     };
 
     uint32_t new_node( type_t, uint32_t, uint32_t );
+    uint32_t find_val( uint32_t obj, str, uint32_t hash, uint32_t& pos ) const;
+    bool is_key( uint32_t, str, uint32_t hash ) const;
     void add( uint32_t );
     void add_obj( uint32_t );
     void add_arr( uint32_t );
 
     typedef std::vector<node>     node_vec_t;
     typedef std::vector<uint32_t> stack_t;
+    typedef std::vector<uint32_t> index_t;
+
+    size_t index( const char *, size_t );
+    void parse_index( const char *, size_t );
+    void parse_bytes( const char *, size_t );
+
     node_vec_t nv_;
     stack_t    st_;
+    index_t    ix_;
     uint32_t   key_;
+    uint32_t   khash_;
     const char*buf_;
   };
 
   ///////////////////////////////////////////////////////////////////////
   // inline implementation
 
+  inline uint32_t jkey::hash( const char *txt, size_t len )
+  {
+    // fnv-1a
+    uint32_t h = 2166136261U;
+    for( size_t i=0; i != len; ++i ) {
+      h = ( h ^ (uint8_t)txt[i] ) * 16777619U;
+    }
+    return h;
+  }
+
+  inline jkey::jkey( str key )
+  : key_( key ),
+    hash_( hash( key.str_, key.len_ ) )
+  {
+  }
+
+  inline str jkey::get_str() const
+  {
+    return key_;
+  }
+
+  inline uint32_t jkey::get_hash() const
+  {
+    return hash_;
+  }
+
   inline jtree::type_t jtree::get_type( uint32_t i ) const
   {
     return (type_t)nv_[i].type_;
@@ -165,28 +165,19 @@ void key_pair::get_pub_key( pub_key& pk ) const
 }
 
 key_cache::key_cache()
-: ptr_( nullptr )
+: is_set_( false )
 {
 }
 
 key_cache::~key_cache()
 {
-  if ( ptr_ ) {
-    EVP_PKEY_free( (EVP_PKEY*)ptr_ );
-    ptr_ = nullptr;
-  }
+  key_.zero();
 }
 
 void key_cache::set( const key_pair& pk )
 {
-  EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(
-      EVP_PKEY_ED25519, NULL, pk.data(), pub_key::len );
-  ptr_ = (void*)pkey;
-}
-
-void *key_cache::get() const
-{
-  return ptr_;
+  key_.init( pk.data() );
+  is_set_ = true;
 }
 
 void signature::init_from_buf( const uint8_t *buf )
@@ -217,37 +208,21 @@ int signature::enc_base58( std::string& res )
 bool signature::sign(
     const uint8_t* msg, uint32_t msg_len, const key_pair& kp )
 {
-  EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key( EVP_PKEY_ED25519,
-      NULL, kp.data(), pub_key::len );
-  if ( !pkey ) {
-    return false;
-  }
-  EVP_MD_CTX *mctx = EVP_MD_CTX_new();
-  int rc = EVP_DigestSignInit( mctx, NULL, NULL, NULL, pkey );
-  if ( rc ) {
-    size_t sig_len[1] = { len };
-    rc = EVP_DigestSign( mctx, sig_, sig_len, msg, msg_len );
-  }
-  EVP_MD_CTX_free( mctx );
-  EVP_PKEY_free( pkey );
-  return rc != 0;
+  ed25519 key;
+  key.init( kp.data() );
+  key.sign( sig_, msg, msg_len );
+  key.zero();
+  return true;
 }
 
 bool signature::sign(
     const uint8_t* msg, uint32_t msg_len, const key_cache& kp )
 {
-  EVP_PKEY *pkey = (EVP_PKEY*)kp.get();
-  if ( !pkey ) {
+  if ( !kp.get_is_set() ) {
     return false;
   }
-  EVP_MD_CTX *mctx = EVP_MD_CTX_new();
-  int rc = EVP_DigestSignInit( mctx, NULL, NULL, NULL, pkey );
-  if ( rc ) {
-    size_t sig_len[1] = { len };
-    rc = EVP_DigestSign( mctx, sig_, sig_len, msg, msg_len );
-  }
-  EVP_MD_CTX_free( mctx );
-  return rc != 0;
+  kp.get().sign( sig_, msg, msg_len );
+  return true;
 }
 
 bool signature::verify(
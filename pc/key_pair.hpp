@@ -1,6 +1,7 @@
 #pragma once
 
 #include <pc/misc.hpp>
+#include <pc/ed25519.hpp>
 
 namespace pc
 {
@@ -72,16 +73,19 @@ namespace pc
     uint8_t pk_[len];
   };
 
-  // opaque ssl key handle
+  // signing context expanded once from a key_pair. signing with it is
+  // thread safe and does not allocate
   class key_cache
   {
   public:
     key_cache();
     ~key_cache();
     void set( const key_pair& );
-    void *get() const;
+    bool get_is_set() const;
+    const ed25519& get() const;
   private:
-    void *ptr_;
+    bool    is_set_;
+    ed25519 key_;
   };
 
   // digital signature
@@ -126,6 +130,16 @@ namespace pc
     return pk_;
   }
 
+  inline bool key_cache::get_is_set() const
+  {
+    return is_set_;
+  }
+
+  inline const ed25519& key_cache::get() const
+  {
+    return key_;
+  }
+
   inline const uint8_t *signature::data() const
   {
     return sig_;
@@ -8,10 +8,17 @@ using namespace pc;
 #define PC_TPU_PROXY_PORT     8898
 #define PC_RPC_HTTP_PORT      8899
 #define PC_RECONNECT_TIMEOUT  (120L*1000000000L)
-#define PC_BLOCKHASH_TIMEOUT  3
+#define PC_BLOCKHASH_EXPIRY   150UL
+#define PC_SLOT_POLL          (200L*PC_NSECS_IN_MSEC)
+#define PC_SLOT_MISS          3
+#define PC_RPC_STUCK_INTERVAL (5L*PC_NSECS_IN_SEC)
+#define PC_RPC_TIMEOUT        (2L*PC_NSECS_IN_SEC)
+#define PC_HEDGE_MAX_LAG      2UL
 #define PC_PUB_INTERVAL       PC_NSECS_IN_SEC
 #define PC_RPC_HOST           "localhost"
 #define PC_MAX_BATCH          8
+#define PC_CACHE_MAX_AGE      150UL
+#define PC_CACHE_INTERVAL     32UL
 // Flush partial batches if not completed within 400 ms.
 #define PC_FLUSH_INTERVAL       (400L*PC_NSECS_IN_MSEC)
 // Compute units requested per price update instruction
@@ -67,29 +74,57 @@ manager::manager()
   cts_( 0L ),
   ctimeout_( PC_NSECS_IN_SEC ),
   slot_( 0UL ),
-  slot_cnt_( 0UL ),
   slot_ts_{ 0UL },
   curr_ts_( 0L ),
+  rpc_ts_( 0L ),
   pub_ts_( 0L ),
   pub_int_( PC_PUB_INTERVAL ),
   wait_conn_( false ),
   do_cap_( false ),
+  do_cache_( false ),
+  cage_( PC_CACHE_MAX_AGE ),
+  cint_( PC_CACHE_INTERVAL ),
+  is_replay_( false ),
   do_ws_( true ),
   do_tx_( true ),
   is_pub_( false ),
   cmt_( commitment::e_confirmed ),
-  max_batch_( PC_MAX_BATCH ),
   requested_upd_price_cu_units_( PC_UPD_PRICE_COMPUTE_UNITS ),
   requested_upd_price_cu_price_( 0UL ),
   sreq_{ { commitment::e_processed } },
+  bage_slot_( 0UL ),
+  num_expire_( 0UL ),
+  bidx_( 0 ),
+  qidx_( 0 ),
+  num_sweep_( 0UL ),
+  num_probe_( 0UL ),
+  num_stale_( 0UL ),
   secondary_{ nullptr },
-  is_secondary_( false )
+  is_secondary_( false ),
+  num_rtr_( 0 ),
+  rtr_idx_( 0 ),
+  rtr_id_( 0UL ),
+  num_sgn_( 0 )
 {
+  bpol_.set_max_batch( PC_MAX_BATCH );
   tconn_.set_sub( this );
   breq_->set_sub( this );
   sreq_->set_sub( this );
+  ureq_->set_sub( this );
   preq_->set_sub( this );
-  areq_->set_sub( this );
+  preq_->set_coalesce( true );
+  for( rpc::get_multiple_accounts& mreq: mreq_ ) {
+    mreq.set_sub( this );
+  }
+
+  // deadlines for requests that nothing else would resend.
+  // subscriptions are not resent (a late reply would leave a duplicate
+  // on the server) but time out into a reconnect that resubscribes
+  clnt_.set_timeout<rpc::get_slot>( PC_RPC_TIMEOUT, 0 );
+  clnt_.set_timeout<rpc::get_recent_block_hash>( PC_RPC_TIMEOUT, 0 );
+  clnt_.set_timeout<rpc::slot_subscribe>( PC_RPC_TIMEOUT, 0 );
+  clnt_.set_timeout<rpc::program_subscribe>( PC_RPC_TIMEOUT, 0 );
+  clnt_.set_timeout<rpc::get_multiple_accounts>( 4*PC_RPC_TIMEOUT, 3 );
   tconn_.set_net_parser( &txp_ );
   txp_.mgr_ = this;
 }
@@ -105,6 +140,10 @@ manager::~manager()
     delete ptr;
   }
   svec_.clear();
+  for( rpc_endpoint *ep: evec_ ) {
+    delete ep;
+  }
+  evec_.clear();
   if ( has_secondary() ) {
     delete secondary_;
   }
@@ -144,6 +183,19 @@ std::string manager::get_rpc_host() const
   return rhost_;
 }
 
+void manager::add_rpc_hedge_host( const std::string& rhost )
+{
+  rpc_endpoint *ep = new rpc_endpoint;
+  ep->set_rpc_host( rhost );
+  ep->set_sub( this );
+  evec_.push_back( ep );
+}
+
+unsigned manager::get_num_rpc_hedge() const
+{
+  return static_cast<unsigned>( evec_.size() );
+}
+
 void manager::set_tx_host( const std::string& thost )
 {
   thost_ = thost;
@@ -174,6 +226,41 @@ bool manager::get_do_tx() const
   return do_tx_;
 }
 
+void manager::set_do_uring( bool do_uring )
+{
+  nl_.set_use_uring( do_uring );
+}
+
+bool manager::get_do_uring() const
+{
+  return nl_.get_use_uring();
+}
+
+void manager::set_num_reactor( unsigned num )
+{
+  num_rtr_ = num;
+}
+
+unsigned manager::get_num_reactor() const
+{
+  return num_rtr_;
+}
+
+void manager::set_num_signer( unsigned num )
+{
+  num_sgn_ = num;
+}
+
+unsigned manager::get_num_signer() const
+{
+  return num_sgn_;
+}
+
+price_index *manager::get_price_index()
+{
+  return &pidx_;
+}
+
 void manager::set_capture_file( const std::string& cap_file )
 {
   cap_.set_file( cap_file );
@@ -212,12 +299,22 @@ unsigned manager::get_requested_upd_price_cu_price() const {
 
 void manager::set_max_batch_size( unsigned batch_size )
 {
-  max_batch_ = batch_size;
+  bpol_.set_max_batch( batch_size );
 }
 
 unsigned manager::get_max_batch_size() const
 {
-  return max_batch_;
+  return bpol_.get_max_batch();
+}
+
+unsigned manager::get_batch_size() const
+{
+  return bpol_.get_batch_size();
+}
+
+batch_policy *manager::get_batch_policy()
+{
+  return &bpol_;
 }
 
 void manager::set_do_capture( bool do_cap )
@@ -230,6 +327,42 @@ bool manager::get_do_capture() const
   return do_cap_;
 }
 
+void manager::set_do_cache( bool do_cache )
+{
+  do_cache_ = do_cache;
+}
+
+bool manager::get_do_cache() const
+{
+  return do_cache_;
+}
+
+void manager::set_cache_max_age( uint64_t slots )
+{
+  cage_ = slots;
+}
+
+uint64_t manager::get_cache_max_age() const
+{
+  return cage_;
+}
+
+void manager::set_cache_interval( uint64_t slots )
+{
+  cint_ = slots;
+}
+
+uint64_t manager::get_cache_interval() const
+{
+  return cint_;
+}
+
+std::string manager::get_account_cache_file() const
+{
+  return get_dir() + ( is_secondary_ ?
+      "account_cache_secondary.bin" : "account_cache.bin" );
+}
+
 void manager::set_listen_port( int port )
 {
   lsvr_.set_port( port );
@@ -282,7 +415,7 @@ rpc_client *manager::get_rpc_client()
 
 hash *manager::get_recent_block_hash()
 {
-  return breq_->get_block_hash();
+  return &bhash_;
 }
 
 uint64_t manager::get_slot() const
@@ -290,6 +423,11 @@ uint64_t manager::get_slot() const
   return slot_;
 }
 
+slot_clock *manager::get_slot_clock()
+{
+  return &sclk_;
+}
+
 void manager::teardown()
 {
   PC_LOG_INF( "pythd_teardown" ).add( "secondary", get_is_secondary() ).end();
@@ -297,6 +435,14 @@ void manager::teardown()
   // shutdown listener
   lsvr_.close();
 
+  // stop reactor threads and close their connections
+  for( user_reactor *rtr: rvec_ ) {
+    rtr->teardown();
+    delete rtr;
+  }
+  rvec_.clear();
+  rmap_.clear();
+
   // destroy any open users
   while( !olist_.empty() ) {
     user *usr = olist_.first();
@@ -305,6 +451,114 @@ void manager::teardown()
   }
   teardown_users();
 
+  // write back price images held since the last cache write
+  if ( do_cache_ ) {
+    for( product *ptr: svec_ ) {
+      for( unsigned i=0; i != ptr->get_num_price(); ++i ) {
+        ptr->get_price( i )->flush_cache();
+      }
+    }
+  }
+
+  // report buffer pool usage for sizing
+  if ( !is_secondary_ ) {
+    net_buf_stats st;
+    net_buf::get_stats( st );
+    PC_LOG_INF( "net_buf_stats" )
+      .add( "num_alloc", st.num_alloc_ )
+      .add( "num_sys", st.num_sys_ )
+      .add( "num_rel", st.num_rel_ )
+      .add( "num_depot", st.num_depot_ )
+      .add( "num_peak", st.num_peak_ )
+      .add( "num_huge", st.num_huge_ )
+      .end();
+  }
+
+  PC_LOG_INF( "program_subscribe_stats" )
+    .add( "secondary", get_is_secondary() )
+    .add( "num_stale", preq_->get_num_stale() )
+    .add( "num_coalesce", preq_->get_num_coalesce() )
+    .end();
+  clnt_.get_stats( rstats_ );
+  for( const rpc_client::method_stats& st: rstats_ ) {
+    PC_LOG_INF( "rpc_method_stats" )
+      .add( "secondary", get_is_secondary() )
+      .add( "method", st.method_ )
+      .add( "num_reply", st.num_reply_ )
+      .add( "num_retry", st.num_retry_ )
+      .add( "num_timeout", st.num_timeout_ )
+      .add( "p50(ms)", 1e-6*st.p50_ )
+      .add( "p99(ms)", 1e-6*st.p99_ )
+      .add( "max(ms)", 1e-6*st.max_ )
+      .end();
+  }
+  if ( clnt_.get_sign_pipeline() ) {
+    const latency_hist& lat = spipe_.get_latency();
+    const latency_hist& sgn = spipe_.get_sign_time();
+    PC_LOG_INF( "sign_pipeline_stats" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_worker", spipe_.get_num_worker() )
+      .add( "num_sign", spipe_.get_num_sign() )
+      .add( "depth", spipe_.get_depth() )
+      .add( "max_depth", spipe_.get_max_depth() )
+      .add( "p50(ms)", 1e-6*lat.get_quantile( .5 ) )
+      .add( "p99(ms)", 1e-6*lat.get_quantile( .99 ) )
+      .add( "max(ms)", 1e-6*lat.get_max() )
+      .add( "sign_p50(ms)", 1e-6*sgn.get_quantile( .5 ) )
+      .add( "sign_p99(ms)", 1e-6*sgn.get_quantile( .99 ) )
+      .end();
+    spipe_.teardown();
+    clnt_.set_sign_pipeline( nullptr );
+  }
+  PC_LOG_INF( "batch_policy_stats" )
+    .add( "secondary", get_is_secondary() )
+    .add( "max_batch", bpol_.get_max_batch() )
+    .add( "batch_size", bpol_.get_batch_size() )
+    .add( "num_grow", bpol_.get_num_grow() )
+    .add( "num_shrink", bpol_.get_num_shrink() )
+    .add( "num_ack", bpol_.get_num_ack() )
+    .add( "num_err", bpol_.get_num_err() )
+    .add( "ack_rate", bpol_.get_ack_rate() )
+    .add( "ack_latency(ms)", 1e-6*bpol_.get_ack_latency() )
+    .end();
+  const rpc::upd_price_cache& tc = clnt_.get_tx_cache();
+  if ( tc.get_num_hit() || tc.get_num_miss() ) {
+    PC_LOG_INF( "tx_cache_stats" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_hit", tc.get_num_hit() )
+      .add( "num_miss", tc.get_num_miss() )
+      .end();
+  }
+  PC_LOG_INF( "block_hash_stats" )
+    .add( "secondary", get_is_secondary() )
+    .add( "num_hash", bring_.get_num() )
+    .add( "num_send", bage_.get_count() )
+    .add( "num_expire", num_expire_ )
+    .add( "max_age(slots)", bage_slot_ )
+    .add( "p50_age(ms)", 1e-6*bage_.get_quantile( .5 ) )
+    .add( "p99_age(ms)", 1e-6*bage_.get_quantile( .99 ) )
+    .add( "max_age(ms)", 1e-6*bage_.get_max() )
+    .end();
+  PC_LOG_INF( "resync_stats" )
+    .add( "secondary", get_is_secondary() )
+    .add( "num_probe", num_probe_ )
+    .add( "num_stale", num_stale_ )
+    .end();
+  for( rpc_endpoint *ep: evec_ ) {
+    PC_LOG_INF( "rpc_endpoint_stats" )
+      .add( "secondary", get_is_secondary() )
+      .add( "host", ep->get_rpc_host() )
+      .add( "slot_lag", slot_ > ep->get_slot() ? slot_ - ep->get_slot() : 0UL )
+      .add( "latency(ms)", 1e-6*ep->get_latency() )
+      .add( "score(ms)", 1e-6*ep->get_score( slot_ ) )
+      .add( "num_reply", ep->get_num_reply() )
+      .add( "num_win", ep->get_num_win() )
+      .add( "num_reset", ep->get_num_reset() )
+      .end();
+    ep->teardown();
+  }
+  clnt_.clear_hedge_conn();
+
   // destroy rpc connections
   hconn_.close();
   if ( wconn_ ) {
@@ -375,6 +629,17 @@ bool manager::init()
   if ( wconn_ && !wconn_->init() ) {
     return set_err_msg( wconn_->get_err_msg() );
   }
+  // hedge endpoints keep retrying in the background if unreachable
+  for( rpc_endpoint *ep: evec_ ) {
+    ep->set_net_loop( &nl_ );
+    if ( !ep->init() ) {
+      PC_LOG_WRN( "rpc_endpoint_init" )
+        .add( "secondary", get_is_secondary() )
+        .add( "host", ep->get_rpc_host() )
+        .add( "error", ep->get_err_msg() )
+        .end();
+    }
+  }
   // connect to pyth_tx server
   if ( do_tx_ ) {
     int tport1 = 0, tport2 = 0;
@@ -388,6 +653,32 @@ bool manager::init()
   }
   wait_conn_ = true;
 
+  // start reactor threads for user connections
+  if ( num_rtr_ && lsvr_.get_port() > 0 ) {
+    pidx_.init();
+    if ( has_secondary() ) {
+      secondary_->get_price_index()->init();
+    }
+    for( unsigned i=0; i != num_rtr_; ++i ) {
+      user_reactor *rtr = new user_reactor;
+      rtr->set_manager( this );
+      rvec_.push_back( rtr );
+      if ( !rtr->init() ) {
+        return set_err_msg( rtr->get_err_msg() );
+      }
+    }
+  }
+
+  // start transaction signing workers
+  if ( num_sgn_ ) {
+    spipe_.set_num_worker( num_sgn_ );
+    spipe_.set_net_loop( &nl_ );
+    if ( !spipe_.init() ) {
+      return set_err_msg( spipe_.get_err_msg() );
+    }
+    clnt_.set_sign_pipeline( &spipe_ );
+  }
+
   // initialize listening port if port defined
   if ( lsvr_.get_port() > 0 ) {
     lsvr_.set_net_accept( this );
@@ -400,6 +691,11 @@ bool manager::init()
       .add( "content_dir", get_content_dir() )
       .end();
   }
+  // serve last known accounts until the chain catches up
+  if ( do_cache_ ) {
+    warm_start();
+  }
+
   PC_LOG_INF( "initialized" )
     .add( "secondary", get_is_secondary() )
     .add( "version", PC_VERSION )
@@ -408,6 +704,9 @@ bool manager::init()
     .add( "capture_file", get_capture_file() )
     .add( "commitment", commitment_to_str( get_commitment() ) )
     .add( "publish_interval(ms)", get_publish_interval() )
+    .add( "io_uring", nl_.get_is_uring() )
+    .add( "io_uring_io", nl_.get_is_uring_io() )
+    .add( "num_reactor", (uint64_t)rvec_.size() )
     .end();
 
   // Initialize secondary network manager
@@ -429,8 +728,15 @@ void manager::add_secondary( const std::string& rpc_host, const std::string& key
   mgr->set_tx_host( thost_ );
   mgr->set_do_tx( do_tx_ );
   mgr->set_do_ws( do_ws_ );
+  mgr->set_do_cache( do_cache_ );
+  mgr->set_cache_max_age( cage_ );
+  mgr->set_cache_interval( cint_ );
+  mgr->set_do_uring( get_do_uring() );
   mgr->set_commitment( cmt_ );
   mgr->set_is_secondary( true );
+  for( const std::string& sym: psym_ ) {
+    mgr->add_priority_symbol( sym );
+  }
 
   secondary_ = mgr;
 
@@ -462,6 +768,48 @@ bool manager::get_is_rpc_send() const
   return hconn_.get_is_send() || ( wconn_ && wconn_->get_is_send() );
 }
 
+void manager::warm_start()
+{
+  acache_.set_file( get_account_cache_file() );
+  if ( !acache_.init() ) {
+    PC_LOG_WRN( "account cache unavailable" )
+      .add( "secondary", get_is_secondary() )
+      .add( "error", acache_.get_err_msg() )
+      .end();
+    acache_.close();
+    do_cache_ = false;
+    return;
+  }
+  pub_key *mpub = get_mapping_pub_key();
+  if ( mpub ) {
+    is_replay_ = true;
+    add_mapping( *mpub );
+    is_replay_ = false;
+  }
+  size_t num_px = 0;
+  for( product *ptr: svec_ ) {
+    num_px += ptr->get_num_price();
+  }
+  PC_LOG_INF( "warm_start" )
+    .add( "secondary", get_is_secondary() )
+    .add( "cache_file", acache_.get_file() )
+    .add( "num_cached", acache_.get_num_accounts() )
+    .add( "num_products", svec_.size() )
+    .add( "num_prices", num_px )
+    .end();
+}
+
+void manager::replay( request *req, const pub_key& acc )
+{
+  uint64_t slot, lamports;
+  size_t len;
+  const char *data = acache_.read( acc, slot, lamports, len );
+  if ( data ) {
+    cached_account res( acc, slot, lamports, data, len );
+    req->on_response( &res );
+  }
+}
+
 bool manager::bootstrap()
 {
   int status = PC_PYTH_RPC_CONNECTED | PC_PYTH_HAS_BLOCK_HASH;
@@ -490,6 +838,9 @@ void manager::add_mapping( const pub_key& acc )
 
     // add mapping subscription count
     add_map_sub();
+    if ( is_replay_ ) {
+      replay( mptr, acc );
+    }
   }
 }
 
@@ -517,25 +868,53 @@ void manager::send_pending_ups()
 {
   uint32_t n_to_send = 0;
 
-  // the batch will be sent if its size is greater than max batch size
-  // or time since the previously sent batch is greater than PC_FLUSH_INTERVAL
+  // a full batch is sent right away. a partial one is flushed at the
+  // batch policy's deadline in the current slot or once PC_FLUSH_INTERVAL
+  // has passed since the previous batch
   // the buffer is being updated by user class un user::parse_upd_price
   int64_t curr_ts = get_now();
-  if (curr_ts - last_upd_ts_> PC_FLUSH_INTERVAL) {
-    n_to_send = pending_upds_.size();
-  } else if (pending_upds_.size() >= get_max_batch_size()) {
-    n_to_send = get_max_batch_size();
+  int64_t flush_ts = bpol_.get_flush_time();
+  bool is_flush = ( flush_ts && curr_ts >= flush_ts ) ||
+    curr_ts - last_upd_ts_> PC_FLUSH_INTERVAL;
+  bpol_.add_pending( pq_.size() );
+  if ( is_flush ) {
+    n_to_send = pq_.size();
+  } else if (pq_.size() >= get_batch_size()) {
+    n_to_send = get_batch_size();
   }
 
   if (n_to_send == 0) {
     return;
   }
+  if ( is_flush ) {
+    bpol_.on_flush( curr_ts );
+  }
+  pq_.pop( pbuf_, n_to_send );
 
-  // send batch of price updates to solana
-  price::send( pending_upds_.data(), n_to_send);
+  // track age of the block hash the batch is signed with and drop the
+  // batch if the hash has expired (the transactions would be rejected)
+  bool is_expired = false;
+  if ( bring_.get_num() ) {
+    uint64_t est_slot = sclk_.get_est_slot( curr_ts );
+    uint64_t age_slot = est_slot > bring_.get_slot() ?
+      est_slot - bring_.get_slot() : 0UL;
+    bage_.add( curr_ts - bring_.get_time() );
+    bage_slot_ = std::max( bage_slot_, age_slot );
+    is_expired = age_slot > PC_BLOCKHASH_EXPIRY;
+  }
 
-  // remove the sent elements from the vector
-  pending_upds_.erase(pending_upds_.begin(), pending_upds_.begin() + n_to_send);
+  // send batch of price updates to solana
+  if ( PC_UNLIKELY( is_expired ) ) {
+    ++num_expire_;
+    PC_LOG_WRN( "block_hash_expired" )
+      .add( "secondary", get_is_secondary() )
+      .add( "hash_slot", bring_.get_slot() )
+      .add( "curr_slot", slot_ )
+      .add( "num_dropped", n_to_send )
+      .end();
+  } else {
+    price::send( pbuf_.data(), n_to_send);
+  }
 
   // record the current time
   last_upd_ts_= curr_ts;
@@ -560,12 +939,22 @@ void manager::poll( bool do_wait )
       lsvr_.poll();
       for( user *uptr = olist_.first(); uptr; ) {
         user *nptr = uptr->get_next();
-        uptr->poll();
+        if ( !uptr->get_reactor() ) {
+          uptr->poll();
+        }
         uptr = nptr;
       }
     }
   }
 
+  // process messages from reactor threads
+  if ( !rvec_.empty() ) {
+    poll_reactors();
+  }
+
+  // apply the latest program account update received per account
+  preq_->flush();
+
   // submit pending requests
   for( request *rptr =plist_.first(); rptr; ) {
     request *nxt = rptr->get_next();
@@ -577,24 +966,41 @@ void manager::poll( bool do_wait )
     rptr = nxt;
   }
 
+  // batch up account requests from the submissions above
+  if ( bidx_ != bvec_.size() || qidx_ != qvec_.size() ) {
+    poll_fetch();
+  }
+
   // destroy any users scheduled for deletion
   teardown_users();
 
   // get current time
   curr_ts_ = get_now();
 
-  // get current slot
-  if ( curr_ts_ - slot_ts_ > 200 * PC_NSECS_IN_MSEC ) {
+  // time out or retry rpc requests and report those that have not been
+  // answered for a while
+  clnt_.poll( curr_ts_ );
+  if ( !evec_.empty() ) {
+    poll_endpoints( !do_wait );
+  }
+  if ( curr_ts_ - rpc_ts_ > PC_RPC_STUCK_INTERVAL ) {
+    rpc_ts_ = curr_ts_;
+    log_stuck();
+  }
+
+  // get current slot. with websockets the slot subscription is the
+  // primary source so only poll once it has missed a few slots
+  int64_t slot_poll = get_do_ws() ?
+    PC_SLOT_MISS * sclk_.get_slot_interval() : PC_SLOT_POLL;
+  if ( curr_ts_ - slot_ts_ > slot_poll ) {
     if ( sreq_->get_is_recv() ) {
       if ( has_status( PC_PYTH_RPC_CONNECTED ) ) {
         clnt_.send( sreq_ );
       }
     }
     if ( ! get_do_ws() ) {
-      if ( areq_->get_is_recv() ) {
-        if ( has_status( PC_PYTH_RPC_CONNECTED ) ) {
-          clnt_.send( areq_ );
-        }
+      if ( has_status( PC_PYTH_RPC_CONNECTED ) ) {
+        poll_accounts();
       }
     }
   }
@@ -615,6 +1021,11 @@ void manager::poll( bool do_wait )
     reconnect_rpc();
   }
 
+  // wake reactors with queued outbound messages
+  for( user_reactor *rtr: rvec_ ) {
+    rtr->flush();
+  }
+
   // Call the secondary manager's poll loop if necessary
   if ( has_secondary() ) {
     secondary_->poll();
@@ -671,8 +1082,8 @@ void manager::reconnect_rpc()
     wait_conn_ = false;
     ctimeout_ = PC_NSECS_IN_SEC;
     slot_ = 0L;
-    slot_cnt_ = 0UL;
     slot_ts_ = 0L;
+    sclk_.reset();
     num_sub_ = 0;
     clnt_.reset();
     for(;;) {
@@ -685,7 +1096,17 @@ void manager::reconnect_rpc()
       }
     }
 
+    // bootstrap batches sent on the previous connection were abandoned
+    // by the client reset
+    bvec_.clear();
+    bidx_ = 0;
+    qvec_.clear();
+    qidx_ = 0;
+
     // subscribe to slots and get first block hash
+    if ( get_do_ws() ) {
+      clnt_.send( ureq_ );
+    }
     clnt_.send( sreq_ );
 
     // subscribe to program updates
@@ -699,30 +1120,10 @@ void manager::reconnect_rpc()
         preq_->set_program( get_program_pub_key() );
         clnt_.send( preq_ );
       }
-      else {
-        areq_->set_commitment( get_commitment() );
-        areq_->set_program( get_program_pub_key() );
-      }
     }
 
-    // gather latest info on mapping accounts
-    for( get_mapping *mptr: mvec_ ) {
-      mptr->reset();
-      submit( mptr );
-      add_map_sub();
-    }
-    // gather latest info on product and price accounts
-    for( product *ptr: svec_ ) {
-      ptr->reset();
-      submit( ptr );
-      add_map_sub();
-      for( unsigned i=0; i != ptr->get_num_price(); ++i ) {
-        price *qptr = ptr->get_price( i );
-        qptr->reset();
-        submit( qptr );
-        add_map_sub();
-      }
-    }
+    // gather latest info on mapping, product and price accounts
+    resync();
 
     // add mapping account if not done before
     pub_key *mpub = get_mapping_pub_key();
@@ -764,6 +1165,45 @@ void manager::reconnect_rpc()
   }
 }
 
+void manager::poll_endpoints( bool do_poll )
+{
+  // endpoints poll for the slot at the slot interval whether or not
+  // websockets are in use. that keeps their freshness score current and
+  // hedges the slot subscription
+  int64_t slot_int = sclk_.get_slot_interval();
+  for( rpc_endpoint *ep: evec_ ) {
+    ep->poll( curr_ts_, slot_int, do_poll );
+  }
+}
+
+rpc_endpoint *manager::get_endpoint( rpc_client *cptr )
+{
+  if ( cptr == &clnt_ ) {
+    return nullptr;
+  }
+  for( rpc_endpoint *ep: evec_ ) {
+    if ( cptr == ep->get_rpc_client() ) {
+      return ep;
+    }
+  }
+  return nullptr;
+}
+
+void manager::log_stuck()
+{
+  clnt_.get_stats( rstats_ );
+  for( const rpc_client::method_stats& st: rstats_ ) {
+    if ( st.num_inflight_ && curr_ts_ - st.sent_ts_ > PC_RPC_STUCK_INTERVAL ) {
+      PC_LOG_WRN( "rpc_stuck_requests" )
+        .add( "secondary", get_is_secondary() )
+        .add( "method", st.method_ )
+        .add( "num_inflight", st.num_inflight_ )
+        .add( "oldest_age(ms)", 1e-6*( curr_ts_ - st.sent_ts_ ) )
+        .end();
+    }
+  }
+}
+
 void manager::log_disconnect()
 {
   if ( hconn_.get_is_err() ) {
@@ -786,19 +1226,79 @@ void manager::log_disconnect()
   }
 }
 
+void manager::reset_ws( const std::string& emsg )
+{
+  // fail the websocket so that the next poll reconnects through
+  // reconnect_rpc, which resubscribes and resyncs accounts
+  if ( wconn_ && !wconn_->get_is_err() ) {
+    wconn_->set_err_msg( emsg );
+  }
+}
+
 void manager::teardown_users()
 {
   while( !dlist_.empty() ) {
     user *usr = dlist_.first();
-    PC_LOG_DBG( "delete_user" ).add("fd", usr->get_fd() ).end();
+    PC_LOG_DBG( "delete_user" )
+      .add( "fd", usr->get_fd() )
+      .add( "send_calls", usr->get_num_send_calls() )
+      .add( "send_bytes", usr->get_num_send_bytes() )
+      .end();
     usr->close();
     dlist_.del( usr );
     delete usr;
   }
 }
 
+void manager::poll_reactors()
+{
+  user_reactor::msg m;
+  for( user_reactor *rtr: rvec_ ) {
+    while( rtr->pop( m ) ) {
+      switch( m.type_ ) {
+        case user_reactor::e_upd_price: {
+          upd_price( m.px_[0], m.px_[1], m.price_, m.conf_, m.st_ );
+          break;
+        }
+        case user_reactor::e_request: {
+          rtr_map_t::iterator it = rmap_.find( m.id_ );
+          if ( it != rmap_.end() ) {
+            it->second->parse_msg( m.buf_.data(), m.buf_.size() );
+          }
+          rtr->done( m.id_ );
+          break;
+        }
+        case user_reactor::e_del_user: {
+          rtr_map_t::iterator it = rmap_.find( m.id_ );
+          if ( it != rmap_.end() ) {
+            it->second->teardown();
+            rmap_.erase( it );
+          }
+          break;
+        }
+        default: break;
+      }
+    }
+  }
+}
+
 void manager::accept( int fd )
 {
+  if ( !rvec_.empty() ) {
+    // hand socket to reactor and keep manager-side user for
+    // subscriptions and requests that need manager state
+    user_reactor *rtr = rvec_[rtr_idx_++ % rvec_.size()];
+    user *usr = new user;
+    usr->set_rpc_client( &clnt_ );
+    usr->set_manager( this );
+    usr->set_reactor( rtr, ++rtr_id_ );
+    olist_.add( usr );
+    rmap_[rtr_id_] = usr;
+    rtr->add_user( rtr_id_, fd );
+    PC_LOG_DBG( "new_user" ).add("fd", fd ).add( "id", rtr_id_ ).end();
+    return;
+  }
+
   // create and add new user
   user *usr = new user;
   usr->set_rpc_client( &clnt_ );
@@ -822,6 +1322,19 @@ void manager::del_user( user *usr )
   dlist_.add( usr );
 }
 
+void manager::upd_price( price *sptr, price *sptr2, int64_t px,
+                          uint64_t conf, symbol_status st )
+{
+  if ( sptr ) {
+    sptr->update_no_send( px, conf, st, false );
+    add_dirty_price( sptr );
+  }
+  if ( sptr2 ) {
+    sptr2->update_no_send( px, conf, st, false );
+    get_secondary()->add_dirty_price( sptr2 );
+  }
+}
+
 void manager::schedule( price_sched *kptr )
 {
   kvec_.push_back( kptr );
@@ -834,34 +1347,125 @@ void manager::schedule( price_sched *kptr )
 
 void manager::on_response( rpc::get_slot *res )
 {
-  // check error
+  // check error. hedge endpoint errors are not fatal
+  rpc_endpoint *ep = get_endpoint( res->get_rpc_client() );
   if ( PC_UNLIKELY( res->get_is_err() ) ) {
+    if ( ep ) {
+      PC_LOG_WRN( "rpc_endpoint_get_slot" )
+        .add( "secondary", get_is_secondary() )
+        .add( "host", ep->get_rpc_host() )
+        .add( "error", res->get_err_msg() )
+        .end();
+      return;
+    }
+    if ( res->get_err_code() == PC_RPC_ERROR_TIMEOUT ) {
+      // polled again on the next poll
+      return;
+    }
     set_err_msg( "failed to get slot ["
         + res->get_err_msg()  + "]" );
     return;
   }
 
-  // ignore slots that go back in time
+  // ignore slots that go back in time. whichever endpoint reports a
+  // slot first wins
   uint64_t slot = res->get_current_slot();
-  int64_t ts = res->get_recv_time();
+  int64_t ack_ts = res->get_recv_time() - res->get_sent_time();
+  if ( ep ) {
+    ep->add_reply( slot, ack_ts );
+  }
   if ( slot <= slot_ ) {
     return;
   }
+  if ( ep ) {
+    ep->add_win();
+  }
+
+  PC_LOG_DBG( "received get_slot" )
+    .add( "slot", slot )
+    .add( "round_trip_time(ms)", 1e-6*ack_ts )
+    .add( "host", ep ? ep->get_rpc_host() : rhost_ )
+    .add( "secondary", get_is_secondary() )
+    .end();
+
+  on_slot( slot, res->get_recv_time() );
+}
+
+void manager::on_response( rpc::slot_subscribe *res )
+{
+  // check error
+  if ( PC_UNLIKELY( res->get_is_err() ) ) {
+    if ( res->get_err_code() == PC_RPC_ERROR_TIMEOUT ) {
+      reset_ws( "slot_subscribe timed out" );
+      return;
+    }
+    set_err_msg( "failed to slot_subscribe ["
+        + res->get_err_msg()  + "]" );
+    return;
+  }
+
+  // ignore slots that go back in time
+  uint64_t slot = res->get_slot();
+  if ( slot <= slot_ ) {
+    return;
+  }
+
+  PC_LOG_DBG( "received slot_subscribe" )
+    .add( "slot", slot )
+    .add( "slot_interval(ms)", 1e-6*sclk_.get_slot_interval() )
+    .add( "secondary", get_is_secondary() )
+    .end();
+
+  on_slot( slot, res->get_recv_time() );
+}
+
+void manager::on_slot( uint64_t slot, int64_t ts )
+{
   slot_ = slot;
   slot_ts_ = ts;
+  sclk_.update( slot, ts );
 
-  int64_t ack_ts = res->get_recv_time() - res->get_sent_time();
+  // pick batch size and flush deadline for this slot
+  bool is_resize = bpol_.on_slot( slot, ts, sclk_.get_slot_interval() );
 
-  PC_LOG_DBG( "received get_slot" )
-    .add( "slot", slot_ )
-    .add( "round_trip_time(ms)", 1e-6*ack_ts )
+  // send priority symbols first while more updates wait than fit in a
+  // batch, otherwise oldest first
+  pq_.set_order( pq_.size() > bpol_.get_batch_size() ?
+    pending_queue<price>::e_priority_first :
+    pending_queue<price>::e_oldest_first );
+  PC_LOG_DBG( "batch_policy" )
     .add( "secondary", get_is_secondary() )
+    .add( "slot", slot )
+    .add( "batch_size", bpol_.get_batch_size() )
+    .add( "is_resize", is_resize )
+    .add( "num_pending", pq_.size() )
+    .add( "num_priority", pq_.get_num_priority() )
+    .add( "flush_lead(ms)", 1e-6*bpol_.get_flush_lead() )
+    .add( "ack_rate", bpol_.get_ack_rate() )
+    .add( "ack_latency(ms)", 1e-6*bpol_.get_ack_latency() )
     .end();
 
-  // submit block hash every N slots
-  if ( slot_cnt_++ % PC_BLOCKHASH_TIMEOUT == 0 ) {
+  // refresh block hash on every slot unless a request is outstanding
+  if ( breq_->get_is_recv() ) {
     clnt_.send( breq_ );
   }
+  for( rpc_endpoint *ep: evec_ ) {
+    ep->send_block_hash();
+  }
+
+  // hedge transactions across endpoints that keep up, best score first
+  if ( !evec_.empty() ) {
+    std::sort( evec_.begin(), evec_.end(),
+      [slot]( const rpc_endpoint *a, const rpc_endpoint *b ) {
+        return a->get_score( slot ) < b->get_score( slot );
+      } );
+    clnt_.clear_hedge_conn();
+    for( rpc_endpoint *ep: evec_ ) {
+      if ( ep->get_is_fresh( slot, PC_HEDGE_MAX_LAG ) ) {
+        clnt_.add_hedge_conn( ep->get_http_conn() );
+      }
+    }
+  }
 
   // flush capture
   if ( do_cap_ ) {
@@ -879,12 +1483,37 @@ void manager::on_response( rpc::get_slot *res )
 
 void manager::on_response( rpc::get_recent_block_hash *m )
 {
+  rpc_endpoint *ep = get_endpoint( m->get_rpc_client() );
   if ( m->get_is_err() ) {
+    if ( ep ) {
+      PC_LOG_WRN( "rpc_endpoint_get_recent_block_hash" )
+        .add( "secondary", get_is_secondary() )
+        .add( "host", ep->get_rpc_host() )
+        .add( "error", m->get_err_msg() )
+        .end();
+      return;
+    }
+    if ( m->get_err_code() == PC_RPC_ERROR_TIMEOUT ) {
+      // requested again on the next slot
+      return;
+    }
     set_err_msg( "failed to get recent block hash ["
         + m->get_err_msg()  + "]" );
     return;
   }
+
+  // keep the hash from the most recent slot across endpoints
   int64_t ack_ts = m->get_recv_time() - m->get_sent_time();
+  if ( ep ) {
+    ep->add_reply( m->get_slot(), ack_ts );
+  }
+  if ( bring_.add( *m->get_block_hash(), m->get_slot(),
+                   m->get_recv_time() ) ) {
+    bhash_ = *bring_.get_hash();
+    if ( ep ) {
+      ep->add_win();
+    }
+  }
   if ( has_status( PC_PYTH_HAS_BLOCK_HASH ) ) {
     return;
   }
@@ -902,6 +1531,10 @@ void manager::on_response( rpc::get_recent_block_hash *m )
 void manager::on_response( rpc::account_update *m )
 {
   if ( m->get_is_err() ) {
+    if ( m->get_err_code() == PC_RPC_ERROR_TIMEOUT ) {
+      reset_ws( "program_subscribe timed out" );
+      return;
+    }
     set_err_msg( "account update failed ["
         + m->get_err_msg()  + "]" );
     return;
@@ -931,6 +1564,234 @@ void manager::on_response( rpc::account_update *m )
   }
 }
 
+void manager::on_response( rpc::get_multiple_accounts *m )
+{
+  if ( m->get_data_slice_len() ) {
+    on_probe( m );
+    return;
+  }
+  if ( m->get_is_err() && m->get_err_code() == PC_RPC_ERROR_TIMEOUT ) {
+    // fetch the accounts again in a new batch
+    PC_LOG_WRN( "bootstrap batch timed out" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_accounts", m->get_num_accounts() )
+      .end();
+    for( size_t i=0; i != m->get_num_accounts(); ++i ) {
+      fetch_account( m->get_request_account( i ) );
+    }
+    return;
+  }
+  if ( m->get_is_err() && m->get_err_code() != PC_RPC_ERROR_NOT_FOUND ) {
+    // fail every account in the batch
+    PC_LOG_ERR( "bootstrap batch failed" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_accounts", m->get_num_accounts() )
+      .add( "error", m->get_err_msg() )
+      .end();
+    for( size_t i=0; i != m->get_num_accounts(); ++i ) {
+      acc_map_t::iter_t it = amap_.find( m->get_request_account( i ) );
+      if ( it ) {
+        amap_.obj( it )->on_response( m );
+      }
+    }
+    return;
+  }
+
+  if ( m->get_is_err() ) {
+    PC_LOG_ERR( "account not found" )
+      .add( "secondary", get_is_secondary() )
+      .add( "account", *m->get_account() )
+      .end();
+  }
+  PC_LOG_DBG( "received bootstrap account" )
+    .add( "secondary", get_is_secondary() )
+    .add( "account", *m->get_account() )
+    .add( "slot", m->get_slot() )
+    .add( "round_trip_time(ms)",
+        1e-6*( m->get_recv_time() - m->get_sent_time() ) )
+    .end();
+  acc_map_t::iter_t it = amap_.find( *m->get_account() );
+  if ( it ) {
+    amap_.obj( it )->on_response( m );
+  }
+}
+
+void manager::poll_accounts()
+{
+  // start a new sweep once the previous one has drained
+  if ( qidx_ != qvec_.size() || bidx_ != bvec_.size() ) {
+    return;
+  }
+  for( rpc::get_multiple_accounts& mreq: mreq_ ) {
+    if ( !mreq.get_is_recv() ) {
+      return;
+    }
+  }
+
+  // probe mapping and price headers. products have no header field
+  // that tracks attribute edits so they are fetched in full but only
+  // every few sweeps
+  bool do_prod = 0 == num_sweep_++ % PC_POLL_PRODUCT_SWEEPS;
+  for( get_mapping *mptr: mvec_ ) {
+    if ( mptr->get_is_done() && mptr->get_is_recv() ) {
+      probe_account( *mptr->get_mapping_key() );
+    }
+  }
+  for( product *ptr: svec_ ) {
+    if ( do_prod && ptr->get_is_done() && ptr->get_is_recv() ) {
+      fetch_account( *ptr->get_account() );
+    }
+    for( unsigned i=0; i != ptr->get_num_price(); ++i ) {
+      price *qptr = ptr->get_price( i );
+      if ( qptr->get_is_done() && qptr->get_is_recv() ) {
+        probe_account( *qptr->get_account() );
+      }
+    }
+  }
+  poll_fetch();
+}
+
+void manager::on_probe( rpc::get_multiple_accounts *m )
+{
+  if ( m->get_is_err() && m->get_err_code() == PC_RPC_ERROR_NOT_FOUND ) {
+    // full fetch reports the missing account to its owner
+    fetch_account( *m->get_account() );
+    ++num_stale_;
+    return;
+  }
+  if ( m->get_is_err() ) {
+    // fall back to fetching every account in the batch
+    PC_LOG_ERR( "probe batch failed" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_accounts", m->get_num_accounts() )
+      .add( "error", m->get_err_msg() )
+      .end();
+    for( size_t i=0; i != m->get_num_accounts(); ++i ) {
+      fetch_account( m->get_request_account( i ) );
+    }
+    num_stale_ += m->get_num_accounts();
+    return;
+  }
+  acc_map_t::iter_t it = amap_.find( *m->get_account() );
+  if ( !it ) {
+    return;
+  }
+  char *buf;
+  size_t len = m->get_data_ref( buf, PC_PROBE_SIZE );
+  if ( amap_.obj( it )->get_is_stale( buf, len ) ) {
+    fetch_account( *m->get_account() );
+    ++num_stale_;
+  }
+}
+
+void manager::fetch_account( const pub_key& acc )
+{
+  bvec_.push_back( acc );
+}
+
+void manager::probe_account( const pub_key& acc )
+{
+  qvec_.push_back( acc );
+}
+
+void manager::resync()
+{
+  // accounts received on a previous connection keep their state (and
+  // keep publishing) while they are checked for changes missed during
+  // the disconnect. anything else is bootstrapped from scratch
+  if ( mvec_.empty() ) {
+    return;
+  }
+  uint64_t num_probe = 0, num_fetch = 0, num_reset = 0;
+  add_map_sub();
+  for( get_mapping *mptr: mvec_ ) {
+    if ( mptr->get_is_done() && mptr->get_is_recv() ) {
+      probe_account( *mptr->get_mapping_key() );
+      ++num_probe;
+    } else {
+      mptr->reset();
+      submit( mptr );
+      add_map_sub();
+      ++num_reset;
+    }
+  }
+  for( product *ptr: svec_ ) {
+    if ( ptr->get_is_done() && ptr->get_is_recv() ) {
+      // attribute edits do not show in the header so refetch in full
+      fetch_account( *ptr->get_account() );
+      ++num_fetch;
+    } else {
+      ptr->reset();
+      submit( ptr );
+      add_map_sub();
+      ++num_reset;
+    }
+    for( unsigned i=0; i != ptr->get_num_price(); ++i ) {
+      price *qptr = ptr->get_price( i );
+      if ( qptr->get_is_done() && qptr->get_is_recv() ) {
+        probe_account( *qptr->get_account() );
+        ++num_probe;
+      } else {
+        qptr->reset();
+        submit( qptr );
+        add_map_sub();
+        ++num_reset;
+      }
+    }
+  }
+  if ( num_probe || num_fetch ) {
+    PC_LOG_INF( "rpc_resync" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_probe", num_probe )
+      .add( "num_fetch", num_fetch )
+      .add( "num_reset", num_reset )
+      .end();
+  }
+  // mapping is complete now unless something had to be bootstrapped
+  del_map_sub();
+}
+
+void manager::poll_fetch()
+{
+  // fill idle batches from the queues bounding the number in flight.
+  // full fetches go first since probes only lead to more of them
+  const size_t max_acc = rpc::get_multiple_accounts::max_accounts;
+  for( rpc::get_multiple_accounts& mreq: mreq_ ) {
+    if ( bidx_ == bvec_.size() && qidx_ == qvec_.size() ) {
+      break;
+    }
+    if ( !mreq.get_is_recv() ) {
+      continue;
+    }
+    mreq.reset_err();
+    mreq.clear_accounts();
+    mreq.set_commitment( get_commitment() );
+    if ( bidx_ != bvec_.size() ) {
+      mreq.set_data_slice( 0UL, 0UL );
+      for( ; bidx_ != bvec_.size() &&
+             mreq.get_num_accounts() != max_acc; ++bidx_ ) {
+        mreq.add_account( bvec_[bidx_] );
+      }
+    } else {
+      mreq.set_data_slice( 0UL, PC_PROBE_SIZE );
+      for( ; qidx_ != qvec_.size() &&
+             mreq.get_num_accounts() != max_acc; ++qidx_ ) {
+        mreq.add_account( qvec_[qidx_] );
+      }
+      num_probe_ += mreq.get_num_accounts();
+    }
+    clnt_.send( &mreq );
+  }
+  if ( bidx_ == bvec_.size() ) {
+    bvec_.clear();
+    bidx_ = 0;
+  }
+  if ( qidx_ == qvec_.size() ) {
+    qvec_.clear();
+    qidx_ = 0;
+  }
+}
+
 void manager::submit( request *req )
 {
   if ( PC_UNLIKELY( req->get_is_submit() ) ) {
@@ -1009,6 +1870,9 @@ void manager::add_product( const pub_key&acc )
     submit( ptr );
     // add mapping subscription count
     add_map_sub();
+    if ( is_replay_ ) {
+      replay( ptr, acc );
+    }
   }
 }
 
@@ -1026,11 +1890,17 @@ void manager::add_price( const pub_key&acc, product *prod )
     // get info for new price account
     price *ptr = new price( acc, prod );
     amap_.ref( amap_.add( acc ) ) = ptr;
+    if ( pidx_.get_is_init() && !pidx_.add( acc, ptr ) ) {
+      PC_LOG_WRN( "price index full - reactors defer lookups" ).end();
+    }
     submit( ptr );
     // add price to product
     prod->add_price( ptr );
     // add mapping subscription count
     add_map_sub();
+    if ( is_replay_ ) {
+      replay( ptr, acc );
+    }
   }
 }
 
@@ -1047,8 +1917,25 @@ void manager::add_dirty_price(price* sptr)
     return;
   }
 
-  if( std::find(pending_upds_.begin(), pending_upds_.end(), sptr) == pending_upds_.end() ) {
-    pending_upds_.emplace_back( sptr );
+  // resolve priority once the product symbol is known
+  if ( PC_UNLIKELY( !sptr->get_has_priority() ) && !psym_.empty() ) {
+    str sym = sptr->get_symbol();
+    if ( sym.len_ ) {
+      bool is_prio = false;
+      for( const std::string& psym: psym_ ) {
+        is_prio = is_prio || sym == str( psym );
+      }
+      sptr->set_is_priority( is_prio );
+    }
+  }
+  pq_.add( sptr );
+}
+
+void manager::add_priority_symbol( const std::string& sym )
+{
+  psym_.push_back( sym );
+  if ( secondary_ ) {
+    secondary_->add_priority_symbol( sym );
   }
 }
 
@@ -2,18 +2,38 @@
 
 #include <pc/net_socket.hpp>
 #include <pc/rpc_client.hpp>
+#include <pc/rpc_endpoint.hpp>
+#include <pc/sign_pipeline.hpp>
 #include <pc/request.hpp>
 #include <pc/user.hpp>
+#include <pc/user_reactor.hpp>
 #include <pc/key_store.hpp>
 #include <pc/dbl_list.hpp>
 #include <pc/hash_map.hpp>
 #include <pc/capture.hpp>
+#include <pc/account_cache.hpp>
+#include <pc/slot_clock.hpp>
+#include <pc/block_hash_ring.hpp>
+#include <pc/batch_policy.hpp>
+#include <pc/pending_queue.hpp>
 
 // status bits
 #define PC_PYTH_RPC_CONNECTED    (1<<0)
 #define PC_PYTH_HAS_BLOCK_HASH   (1<<1)
 #define PC_PYTH_HAS_MAPPING      (1<<2)
 
+// maximum getMultipleAccounts requests in flight during bootstrap
+#define PC_BOOTSTRAP_REQS        4
+
+// account sweeps between full product fetches when polling without a
+// websocket subscription
+#define PC_POLL_PRODUCT_SWEEPS   25
+
+// leading account bytes fetched to check for changes on resync and when
+// polling. covers the mapping table header and the price header up to
+// valid_slot_
+#define PC_PROBE_SIZE            56UL
+
 namespace pc
 {
   class manager;
@@ -52,8 +72,10 @@ namespace pc
                   public tx_sub,
                   public rpc_sub,
                   public rpc_sub_i<rpc::get_slot>,
+                  public rpc_sub_i<rpc::slot_subscribe>,
                   public rpc_sub_i<rpc::get_recent_block_hash>,
-                  public rpc_sub_i<rpc::account_update>
+                  public rpc_sub_i<rpc::account_update>,
+                  public rpc_sub_i<rpc::get_multiple_accounts>
   {
   public:
 
@@ -64,6 +86,11 @@ namespace pc
     void set_rpc_host( const std::string& );
     std::string get_rpc_host() const;
 
+    // additional rpc http hosts that slot, block hash and transaction
+    // requests are hedged across. the first reply to deliver new state wins
+    void add_rpc_hedge_host( const std::string& );
+    unsigned get_num_rpc_hedge() const;
+
     // pyth transaction proxy host
     void set_tx_host( const std::string& );
     std::string get_tx_host() const;
@@ -76,6 +103,20 @@ namespace pc
     void set_do_tx( bool );
     bool get_do_tx() const;
 
+    // use io_uring instead of epoll for socket polling (if supported)
+    void set_do_uring( bool );
+    bool get_do_uring() const;
+
+    // number of reactor threads servicing user connections. with the
+    // default of zero users are serviced by the manager poll loop
+    void set_num_reactor( unsigned );
+    unsigned get_num_reactor() const;
+
+    // number of threads signing upd_price transactions. with the default
+    // of zero transactions are signed by the manager poll loop
+    void set_num_signer( unsigned );
+    unsigned get_num_signer() const;
+
     // server listening port
     void set_listen_port( int port );
     int get_listen_port() const;
@@ -96,6 +137,22 @@ namespace pc
     void set_capture_file( const std::string& cap_file );
     std::string get_capture_file() const;
 
+    // warm start from and maintain the on-disk account cache in the key
+    // store directory (off by default)
+    void set_do_cache( bool );
+    bool get_do_cache() const;
+    std::string get_account_cache_file() const;
+
+    // publish from cached price images no older than this many slots
+    // until the chain responds (default 150)
+    void set_cache_max_age( uint64_t slots );
+    uint64_t get_cache_max_age() const;
+
+    // write price images to the account cache at most once per this
+    // many slots and at teardown (default 32)
+    void set_cache_interval( uint64_t slots );
+    uint64_t get_cache_interval() const;
+
     // override default publish interval (in milliseconds)
     void set_publish_interval( int64_t mill_secs );
     int64_t get_publish_interval() const;
@@ -112,6 +169,10 @@ namespace pc
     void set_max_batch_size( unsigned batch_size );
     unsigned get_max_batch_size() const;
 
+    // price updates per batch currently chosen by the batch policy
+    unsigned get_batch_size() const;
+    batch_policy *get_batch_policy();
+
     // event subscription callback
     void set_manager_sub( manager_sub * );
     manager_sub *get_manager_sub() const;
@@ -128,6 +189,9 @@ namespace pc
     // get most recently processed slot
     uint64_t get_slot() const;
 
+    // slot interval and boundary estimates between slot updates
+    slot_clock *get_slot_clock();
+
     // add and subscribe to new mapping account
     void add_mapping( const pub_key& );
 
@@ -137,6 +201,14 @@ namespace pc
     // add new price account in product
     void add_price( const pub_key&, product * );
 
+    // queue account for batched getMultipleAccounts retrieval. the
+    // result is dispatched to the request registered for the account
+    void fetch_account( const pub_key& );
+
+    // queue account for a batched probe of its leading bytes. the account
+    // is fetched in full only if its request reports the probe as stale
+    void probe_account( const pub_key& );
+
     // iterate through products
     unsigned get_num_product() const;
     product *get_product( unsigned i ) const;
@@ -146,6 +218,16 @@ namespace pc
     // adds dirty price to pending updates buffer
     void add_dirty_price(price* sptr);
 
+    // symbol whose updates are sent first when pending updates back up
+    void add_priority_symbol( const std::string& );
+
+    // apply component price update to primary and/or secondary price
+    void upd_price( price *, price *secondary, int64_t px, uint64_t conf,
+                    symbol_status );
+
+    // price accounts lookup readable from reactor threads
+    price_index *get_price_index();
+
     // submit pyth client api request
     void submit( request * );
     void submit( net_wtr& );
@@ -185,6 +267,8 @@ namespace pc
     void del_map_sub();
     void schedule( price_sched* );
     void write( pc_pub_key_t *, pc_acc_t *ptr );
+    void cache_account( const pub_key&, uint64_t slot, uint64_t lamports,
+                        const void *data, size_t len );
 
     // tx_sub callbacks
     void on_connect() override;
@@ -194,8 +278,10 @@ namespace pc
 
     // rpc callbacks
     void on_response( rpc::get_slot * ) override;
+    void on_response( rpc::slot_subscribe * ) override;
     void on_response( rpc::get_recent_block_hash * ) override;
     void on_response( rpc::account_update * ) override;
+    void on_response( rpc::get_multiple_accounts * ) override;
     void set_status( int );
     get_mapping *get_last_mapping() const;
     bool get_is_rpc_send() const;
@@ -234,10 +320,28 @@ namespace pc
     typedef std::vector<price_sched*> kpx_vec_t;
     typedef hash_map<trait_account>   acc_map_t;
 
+    typedef std::vector<pub_key>      key_vec_t;
+    typedef std::vector<rpc_endpoint*> ept_vec_t;
+
+    typedef std::vector<user_reactor*>      rtr_vec_t;
+    typedef std::unordered_map<uint64_t,user*> rtr_map_t;
+
     void reconnect_rpc();
     void log_disconnect();
+    void reset_ws( const std::string& );
+    void log_stuck();
     void teardown_users();
+    void poll_reactors();
     void poll_schedule();
+    void poll_fetch();
+    void resync();
+    void on_slot( uint64_t slot, int64_t ts );
+    void poll_accounts();
+    void on_probe( rpc::get_multiple_accounts * );
+    void poll_endpoints( bool do_poll );
+    rpc_endpoint *get_endpoint( rpc_client * );
+    void warm_start();
+    void replay( request *, const pub_key& );
     void reset_status( int );
 
     // send a batch of pending price updates. This function eagerly sends any complete batches.
@@ -246,11 +350,13 @@ namespace pc
     // time this function is invoked.
     void send_pending_ups();
 
-    net_loop     nl_;       // epoll loop
+    net_loop     nl_;       // epoll or io_uring loop
     tcp_connect  hconn_;    // rpc http connection
     ws_connect  *wconn_;    // rpc websocket sonnection
     tcp_listen   lsvr_;     // listening socket
     rpc_client   clnt_;     // rpc api
+    rpc_client::stats_vec_t rstats_; // rpc request stats
+    ept_vec_t    evec_;     // hedge rpc endpoints
     tx_connect   tconn_;    // tx proxy connection
     user_list_t  olist_;    // open users list
     user_list_t  dlist_;    // to-be-deleted users list
@@ -268,38 +374,71 @@ namespace pc
     int64_t      cts_;      // (re)connect timestamp
     int64_t      ctimeout_; // connection timeout
     uint64_t     slot_;     // current slot
-    uint64_t     slot_cnt_; // slot count
     int64_t      slot_ts_;  // current slot time
+    slot_clock   sclk_;     // slot interval estimator
     int64_t      curr_ts_;  // current time
+    int64_t      rpc_ts_;   // last check for stuck rpc requests
     int64_t      pub_ts_;   // start publish time
     int64_t      pub_int_;  // publish interval
     kpx_vec_t    kvec_;     // symbol price scheduling
     bool         wait_conn_;// waiting on connection
     bool         do_cap_;   // do capture flag
+    bool         do_cache_; // do account cache flag
+    uint64_t     cage_;     // max age of publishable cached prices
+    uint64_t     cint_;     // price cache write interval (slots)
+    bool         is_replay_;// replaying account cache
     bool         do_ws_;    // do ws subscriptions
     bool         do_tx_;    // do tx proxy connectivity
     bool         is_pub_;   // is publishing mode
     capture      cap_;      // aggregate price capture
+    account_cache acache_;  // last known account images
     tx_parser    txp_;      // handle unexpected errors
     commitment   cmt_;      // account get/subscribe commitment
-    unsigned     max_batch_;// maximum number of price updates that can be sent in a single batch
+    batch_policy bpol_;     // price update batch size and flush timing
     unsigned     requested_upd_price_cu_units_; // amount of requested CU units per upd_price transaction
     unsigned     requested_upd_price_cu_price_; // price per CU for upd_price transaction
 
     // requests
-    rpc::get_slot              sreq_[1]; // slot subscription
+    rpc::get_slot              sreq_[1]; // slot polling fallback
+    rpc::slot_subscribe        ureq_[1]; // slot subscription
     rpc::get_recent_block_hash breq_[1]; // block hash request
     rpc::program_subscribe     preq_[1]; // program account subscription
-    rpc::get_program_accounts  areq_[1]; // alternative to program_subscribe
+    hash         bhash_;      // freshest block hash from any endpoint
+    block_hash_ring bring_;   // recent block hashes
+    latency_hist bage_;       // block hash age when sending price updates
+    uint64_t     bage_slot_;  // worst block hash age in slots
+    uint64_t     num_expire_; // price update batches dropped on expired hash
+
+    // batched account bootstrap
+    key_vec_t   bvec_;        // accounts waiting to be requested
+    size_t      bidx_;        // next account in bvec_ to request
+    key_vec_t   qvec_;        // accounts waiting to be probed
+    size_t      qidx_;        // next account in qvec_ to probe
+    uint64_t    num_sweep_;   // account polling sweeps without websocket
+    uint64_t    num_probe_;   // accounts probed
+    uint64_t    num_stale_;   // probed accounts fetched in full
+    rpc::get_multiple_accounts mreq_[PC_BOOTSTRAP_REQS]; // batches in flight
 
     // price updates that have not been sent yet
-    std::vector<price*> pending_upds_;
+    pending_queue<price> pq_;
+    std::vector<price*>  pbuf_;   // batch popped from pq_
+    std::vector<std::string> psym_; // priority symbols
 
     // Timestamp of the last batch
     int64_t last_upd_ts_= 0;
 
     manager    *secondary_;   // manager for secondary network
     bool       is_secondary_; // flag tracking whether we are a secondary manager
+
+    // reactor threads owning user sockets
+    unsigned    num_rtr_;     // number of reactors requested
+    unsigned    rtr_idx_;     // round-robin assignment of new users
+    uint64_t    rtr_id_;      // last user connection id
+    rtr_vec_t   rvec_;        // reactors
+    unsigned    num_sgn_;     // number of sign workers requested
+    sign_pipeline spipe_;     // transaction signing workers
+    rtr_map_t   rmap_;        // manager-side users by connection id
+    price_index pidx_;        // price lookup for reactor threads
   };
 
   inline bool manager::get_is_tx_connect() const
@@ -314,4 +453,12 @@ namespace pc
     }
   }
 
+  inline void manager::cache_account( const pub_key& key, uint64_t slot,
+      uint64_t lamports, const void *data, size_t len )
+  {
+    if ( do_cache_ ) {
+      acache_.write( key, slot, lamports, data, len );
+    }
+  }
+
 }
@@ -3,6 +3,10 @@
 #include <assert.h>
 #include <ctype.h>
 #include <time.h>
+#include <atomic>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace pc
 {
@@ -31,7 +35,7 @@ const char ALPHABET_MAP[256] = {
 const double iFactor = 1.36565823730976103695740418120764243208481439700722980119458355862779176747360903943915516885072037696111192757109;
 
 // reslen is the allocated length for result, feel free to overallocate
-int enc_base58(const uint8_t *source, int len, char result[], int reslen)
+int enc_base58_generic(const uint8_t *source, int len, char result[], int reslen)
 {
   assert( source );
   assert( len >= 0 );
@@ -67,7 +71,7 @@ int enc_base58(const uint8_t *source, int len, char result[], int reslen)
 }
 
 // result must be declared (for the worst case): char result[len * 2];
-int dec_base58( const uint8_t *str, int len, uint8_t *result)
+int dec_base58_generic( const uint8_t *str, int len, uint8_t *result)
 {
   assert( str );
   assert( len >= 0 );
@@ -104,6 +108,181 @@ int dec_base58( const uint8_t *str, int len, uint8_t *result)
   return resultlen;
 }
 
+//////////////////////////////////////////////////////////////////
+// fixed-width base58 for 32 and 64 byte values. the binary value is
+// held as N big-endian 32-bit limbs and the base58 value as M limbs
+// of 5 base58 digits (58^5 < 2^32). conversion in either direction is
+// a sum of limb products against a table of powers of the other base,
+// normalized every few rows so that 64-bit accumulators cannot overflow
+
+namespace {
+
+  const uint64_t b58_r = 58UL*58UL*58UL*58UL*58UL;
+
+  template<size_t N, size_t M>
+  struct b58_fixed
+  {
+    static const size_t bytes = 4 * N;
+    static const size_t digits = 5 * M;
+
+    b58_fixed();
+    int enc( const uint8_t *src, char *result, int reslen ) const;
+    bool dec( const uint8_t *str, int len, uint8_t *result ) const;
+
+    uint32_t etab_[N][M];   // 2^(32*(N-1-i)) in base 58^5
+    uint32_t dtab_[M][N];   // 58^(5*(M-1-i)) in base 2^32
+  };
+
+  template<size_t N, size_t M>
+  b58_fixed<N,M>::b58_fixed()
+  {
+    uint64_t val[M] = {};
+    val[M-1] = 1;
+    for( size_t i=N; i--; ) {
+      for( size_t j=0; j != M; ++j ) {
+        etab_[i][j] = (uint32_t)val[j];
+      }
+      uint64_t carry = 0;
+      for( size_t j=M; j--; ) {
+        uint64_t v = ( val[j] << 32 ) + carry;
+        val[j] = v % b58_r;
+        carry = v / b58_r;
+      }
+    }
+    uint64_t bin[N] = {};
+    bin[N-1] = 1;
+    for( size_t i=M; i--; ) {
+      for( size_t j=0; j != N; ++j ) {
+        dtab_[i][j] = (uint32_t)bin[j];
+      }
+      uint64_t carry = 0;
+      for( size_t j=N; j--; ) {
+        uint64_t v = bin[j] * b58_r + carry;
+        bin[j] = v & 0xffffffffUL;
+        carry = v >> 32;
+      }
+    }
+  }
+
+  template<size_t N, size_t M>
+  int b58_fixed<N,M>::enc(
+      const uint8_t *src, char *result, int reslen ) const
+  {
+    uint32_t bin[N];
+    for( size_t i=0; i != N; ++i ) {
+      __builtin_memcpy( &bin[i], &src[4*i], sizeof( bin[i] ) );
+      bin[i] = __builtin_bswap32( bin[i] );
+    }
+    uint64_t acc[M] = {};
+    for( size_t i=0; i != N; ++i ) {
+      for( size_t j=0; j != M; ++j ) {
+        acc[j] += (uint64_t)bin[i] * etab_[i][j];
+      }
+      if ( ( i & 3 ) == 3 || i == N - 1 ) {
+        for( size_t j=M-1; j; --j ) {
+          acc[j-1] += acc[j] / b58_r;
+          acc[j] %= b58_r;
+        }
+      }
+    }
+    uint8_t raw[digits];
+    for( size_t j=0; j != M; ++j ) {
+      uint32_t v = (uint32_t)acc[j];
+      for( size_t k=5; k--; ) {
+        raw[5*j+k] = (uint8_t)( v % 58 );
+        v /= 58;
+      }
+    }
+
+    // leading zero bytes are encoded as leading '1' (digit zero)
+    size_t zeros = 0, skip = 0;
+    while( zeros != bytes && !src[zeros] ) ++zeros;
+    while( skip != digits && !raw[skip] ) ++skip;
+    skip = skip < zeros ? 0 : skip - zeros;
+    int rlen = (int)( digits - skip );
+    if ( rlen + 1 > reslen ) return 0;
+    for( size_t j=skip; j != digits; ++j ) {
+      *result++ = ALPHABET[raw[j]];
+    }
+    *result = 0;
+    return rlen;
+  }
+
+  template<size_t N, size_t M>
+  bool b58_fixed<N,M>::dec(
+      const uint8_t *str, int len, uint8_t *result ) const
+  {
+    if ( len < (int)bytes || len > (int)digits ) {
+      return false;
+    }
+    uint8_t raw[digits] = {};
+    size_t off = digits - (size_t)len;
+    size_t ones = 0;
+    for( size_t i=0; i != (size_t)len; ++i ) {
+      int8_t v = ALPHABET_MAP[str[i]];
+      if ( v < 0 ) return false;
+      raw[off+i] = (uint8_t)v;
+      if ( v == 0 && ones == i ) ++ones;
+    }
+    uint64_t acc[N] = {};
+    for( size_t i=0; i != M; ++i ) {
+      const uint8_t *d = &raw[5*i];
+      uint64_t lim = (((( d[0]*58UL + d[1] )*58UL + d[2] )*58UL + d[3] )*58UL
+                     + d[4] );
+      for( size_t j=0; j != N; ++j ) {
+        acc[j] += lim * dtab_[i][j];
+      }
+      if ( ( i & 3 ) == 3 || i == M - 1 ) {
+        for( size_t j=N-1; j; --j ) {
+          acc[j-1] += acc[j] >> 32;
+          acc[j] &= 0xffffffffUL;
+        }
+      }
+    }
+    if ( acc[0] >> 32 ) {
+      return false;
+    }
+
+    // require exactly as many leading zero bytes as leading '1's
+    uint8_t bin[bytes];
+    for( size_t j=0; j != N; ++j ) {
+      uint32_t v = __builtin_bswap32( (uint32_t)acc[j] );
+      __builtin_memcpy( &bin[4*j], &v, sizeof( v ) );
+    }
+    size_t zeros = 0;
+    while( zeros != bytes && !bin[zeros] ) ++zeros;
+    if ( zeros != ones || zeros == bytes ) {
+      return false;
+    }
+    __builtin_memcpy( result, bin, bytes );
+    return true;
+  }
+
+  const b58_fixed<8,9>   b58_32_;
+  const b58_fixed<16,18> b58_64_;
+
+}
+
+int enc_base58( const uint8_t *src, int len, char *result, int reslen )
+{
+  switch( len ) {
+    case 32: return b58_32_.enc( src, result, reslen );
+    case 64: return b58_64_.enc( src, result, reslen );
+    default: return enc_base58_generic( src, len, result, reslen );
+  }
+}
+
+int dec_base58( const uint8_t *str, int len, uint8_t *result )
+{
+  if ( b58_32_.dec( str, len, result ) ) {
+    return 32;
+  }
+  if ( b58_64_.dec( str, len, result ) ) {
+    return 64;
+  }
+  return dec_base58_generic( str, len, result );
+}
+
 char *uint_to_str( uint64_t val, char *cptr )
 {
   if ( val ) {
@@ -215,7 +394,7 @@ size_t enc_base64_len( const size_t n )
   return (n + 2 - ((n + 2) % 3)) / 3 * 4;
 }
 
-size_t enc_base64( const uint8_t *inp, int len, char *out )
+static size_t enc_base64_scalar( const uint8_t *inp, int len, char *out )
 {
   int i = 0, j = 0;
   size_t encLen = 0;
@@ -249,7 +428,7 @@ size_t enc_base64( const uint8_t *inp, int len, char *out )
   return encLen;
 }
 
-size_t dec_base64( const char *inp, int len, uint8_t *out )
+static size_t dec_base64_scalar( const char *inp, int len, uint8_t *out )
 {
   int i = 0, j = 0;
   size_t decLen = 0;
@@ -288,6 +467,218 @@ size_t dec_base64( const char *inp, int len, uint8_t *out )
   return decLen;
 }
 
+//////////////////////////////////////////////////////////////////
+// vectorized base64 after W. Mula and D. Lemire, "Faster Base64
+// Encoding and Decoding using AVX2 Instructions". full blocks are
+// converted with simd and the remainder (or any block containing
+// padding or invalid characters) by the scalar code above
+
+#if defined(__x86_64__)
+
+// 3-byte groups spread into 4 32-bit lanes of 6-bit indices
+#define PC_B64_ENC_SHUF \
+  10, 11,  9, 10,  7,  8,  6,  7,  4,  5,  3,  4,  1,  2,  0,  1
+#define PC_B64_ENC_LUT \
+  'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, \
+  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, \
+  '/' - 63, 'A', 0, 0
+#define PC_B64_DEC_LO \
+  0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, \
+  0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a
+#define PC_B64_DEC_HI \
+  0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, \
+  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define PC_B64_DEC_ROLL \
+  0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+#define PC_B64_DEC_PACK \
+  2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+
+__attribute__((target("ssse3")))
+static inline __m128i enc_base64_ssse3( __m128i in )
+{
+  in = _mm_shuffle_epi8( in, _mm_set_epi8( PC_B64_ENC_SHUF ) );
+  __m128i t0 = _mm_and_si128( in, _mm_set1_epi32( 0x0fc0fc00 ) );
+  __m128i t1 = _mm_mulhi_epu16( t0, _mm_set1_epi32( 0x04000040 ) );
+  __m128i t2 = _mm_and_si128( in, _mm_set1_epi32( 0x003f03f0 ) );
+  __m128i t3 = _mm_mullo_epi16( t2, _mm_set1_epi32( 0x01000010 ) );
+  __m128i idx = _mm_or_si128( t1, t3 );
+  __m128i res = _mm_subs_epu8( idx, _mm_set1_epi8( 51 ) );
+  __m128i lt = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), idx );
+  res = _mm_or_si128( res, _mm_and_si128( lt, _mm_set1_epi8( 13 ) ) );
+  res = _mm_shuffle_epi8( _mm_setr_epi8( PC_B64_ENC_LUT ), res );
+  return _mm_add_epi8( res, idx );
+}
+
+__attribute__((target("ssse3")))
+static size_t enc_base64_ssse3( const uint8_t *inp, size_t len, char *out )
+{
+  // reads 16 bytes per 12 converted
+  size_t i = 0, j = 0;
+  for( ; i + 16 <= len; i += 12, j += 16 ) {
+    __m128i in = _mm_loadu_si128( (const __m128i*)&inp[i] );
+    _mm_storeu_si128( (__m128i*)&out[j], enc_base64_ssse3( in ) );
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t enc_base64_avx2( const uint8_t *inp, size_t len, char *out )
+{
+  // reads 28 bytes per 24 converted
+  const __m256i shuf = _mm256_set_epi8( PC_B64_ENC_SHUF, PC_B64_ENC_SHUF );
+  const __m256i lut  = _mm256_setr_epi8( PC_B64_ENC_LUT, PC_B64_ENC_LUT );
+  size_t i = 0, j = 0;
+  for( ; i + 28 <= len; i += 24, j += 32 ) {
+    __m256i in = _mm256_inserti128_si256( _mm256_castsi128_si256(
+          _mm_loadu_si128( (const __m128i*)&inp[i] ) ),
+        _mm_loadu_si128( (const __m128i*)&inp[i+12] ), 1 );
+    in = _mm256_shuffle_epi8( in, shuf );
+    __m256i t0 = _mm256_and_si256( in, _mm256_set1_epi32( 0x0fc0fc00 ) );
+    __m256i t1 = _mm256_mulhi_epu16( t0, _mm256_set1_epi32( 0x04000040 ) );
+    __m256i t2 = _mm256_and_si256( in, _mm256_set1_epi32( 0x003f03f0 ) );
+    __m256i t3 = _mm256_mullo_epi16( t2, _mm256_set1_epi32( 0x01000010 ) );
+    __m256i idx = _mm256_or_si256( t1, t3 );
+    __m256i res = _mm256_subs_epu8( idx, _mm256_set1_epi8( 51 ) );
+    __m256i lt = _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), idx );
+    res = _mm256_or_si256(
+        res, _mm256_and_si256( lt, _mm256_set1_epi8( 13 ) ) );
+    res = _mm256_add_epi8( _mm256_shuffle_epi8( lut, res ), idx );
+    _mm256_storeu_si256( (__m256i*)&out[j], res );
+  }
+  return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t dec_base64_ssse3( const char *inp, size_t len, uint8_t *out )
+{
+  const __m128i lut_lo = _mm_setr_epi8( PC_B64_DEC_LO );
+  const __m128i lut_hi = _mm_setr_epi8( PC_B64_DEC_HI );
+  const __m128i roll = _mm_setr_epi8( PC_B64_DEC_ROLL );
+  const __m128i pack = _mm_setr_epi8( PC_B64_DEC_PACK );
+  const __m128i m2f = _mm_set1_epi8( 0x2f );
+  size_t i = 0, j = 0;
+  for( ; i + 16 <= len; i += 16, j += 12 ) {
+    __m128i in = _mm_loadu_si128( (const __m128i*)&inp[i] );
+    __m128i hi_nib = _mm_and_si128( _mm_srli_epi32( in, 4 ), m2f );
+    __m128i lo_nib = _mm_and_si128( in, m2f );
+    __m128i lo = _mm_shuffle_epi8( lut_lo, lo_nib );
+    __m128i hi = _mm_shuffle_epi8( lut_hi, hi_nib );
+    if ( _mm_movemask_epi8( _mm_cmpeq_epi8(
+            _mm_and_si128( lo, hi ), _mm_setzero_si128() ) ) != 0xffff ) {
+      break;
+    }
+    __m128i eq2f = _mm_cmpeq_epi8( in, m2f );
+    __m128i val = _mm_add_epi8( in, _mm_shuffle_epi8(
+          roll, _mm_add_epi8( eq2f, hi_nib ) ) );
+    val = _mm_maddubs_epi16( val, _mm_set1_epi32( 0x01400140 ) );
+    val = _mm_madd_epi16( val, _mm_set1_epi32( 0x00011000 ) );
+    val = _mm_shuffle_epi8( val, pack );
+    uint8_t buf[16];
+    _mm_storeu_si128( (__m128i*)buf, val );
+    __builtin_memcpy( &out[j], buf, 12 );
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t dec_base64_avx2( const char *inp, size_t len, uint8_t *out )
+{
+  const __m256i lut_lo = _mm256_setr_epi8( PC_B64_DEC_LO, PC_B64_DEC_LO );
+  const __m256i lut_hi = _mm256_setr_epi8( PC_B64_DEC_HI, PC_B64_DEC_HI );
+  const __m256i roll = _mm256_setr_epi8( PC_B64_DEC_ROLL, PC_B64_DEC_ROLL );
+  const __m256i pack = _mm256_setr_epi8( PC_B64_DEC_PACK, PC_B64_DEC_PACK );
+  const __m256i perm = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, -1, -1 );
+  const __m256i m2f = _mm256_set1_epi8( 0x2f );
+  size_t i = 0, j = 0;
+  for( ; i + 32 <= len; i += 32, j += 24 ) {
+    __m256i in = _mm256_loadu_si256( (const __m256i*)&inp[i] );
+    __m256i hi_nib = _mm256_and_si256( _mm256_srli_epi32( in, 4 ), m2f );
+    __m256i lo_nib = _mm256_and_si256( in, m2f );
+    __m256i lo = _mm256_shuffle_epi8( lut_lo, lo_nib );
+    __m256i hi = _mm256_shuffle_epi8( lut_hi, hi_nib );
+    if ( !_mm256_testz_si256( lo, hi ) ) {
+      break;
+    }
+    __m256i eq2f = _mm256_cmpeq_epi8( in, m2f );
+    __m256i val = _mm256_add_epi8( in, _mm256_shuffle_epi8(
+          roll, _mm256_add_epi8( eq2f, hi_nib ) ) );
+    val = _mm256_maddubs_epi16( val, _mm256_set1_epi32( 0x01400140 ) );
+    val = _mm256_madd_epi16( val, _mm256_set1_epi32( 0x00011000 ) );
+    val = _mm256_shuffle_epi8( val, pack );
+    val = _mm256_permutevar8x32_epi32( val, perm );
+    uint8_t buf[32];
+    _mm256_storeu_si256( (__m256i*)buf, val );
+    __builtin_memcpy( &out[j], buf, 24 );
+  }
+  return i;
+}
+
+static unsigned get_best_base64_simd()
+{
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports( "avx2" ) ) {
+    return 2;
+  }
+  if ( __builtin_cpu_supports( "ssse3" ) ) {
+    return 1;
+  }
+  return 0;
+}
+
+#else
+
+static unsigned get_best_base64_simd()
+{
+  return 0;
+}
+
+#endif
+
+static std::atomic<unsigned> b64_simd_( get_best_base64_simd() );
+
+void set_base64_simd( unsigned val )
+{
+  unsigned best = get_best_base64_simd();
+  b64_simd_.store( val < best ? val : best, std::memory_order_relaxed );
+}
+
+unsigned get_base64_simd()
+{
+  return b64_simd_.load( std::memory_order_relaxed );
+}
+
+size_t enc_base64( const uint8_t *inp, int len, char *out )
+{
+  size_t i = 0;
+#if defined(__x86_64__)
+  if ( len > 0 ) {
+    switch( get_base64_simd() ) {
+      case 2: i = enc_base64_avx2( inp, (size_t)len, out ); break;
+      case 1: i = enc_base64_ssse3( inp, (size_t)len, out ); break;
+      default: break;
+    }
+  }
+#endif
+  return i / 3 * 4 +
+    enc_base64_scalar( &inp[i], len - (int)i, &out[i / 3 * 4] );
+}
+
+size_t dec_base64( const char *inp, int len, uint8_t *out )
+{
+  size_t i = 0;
+#if defined(__x86_64__)
+  if ( len > 0 ) {
+    switch( get_base64_simd() ) {
+      case 2: i = dec_base64_avx2( inp, (size_t)len, out ); break;
+      case 1: i = dec_base64_ssse3( inp, (size_t)len, out ); break;
+      default: break;
+    }
+  }
+#endif
+  return i / 4 * 3 +
+    dec_base64_scalar( &inp[i], len - (int)i, &out[i / 4 * 3] );
+}
+
 int64_t get_now()
 {
   struct timespec ts[1];
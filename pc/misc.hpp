@@ -12,16 +12,26 @@
 namespace pc
 {
 
-  // base58 encoding from base-x conversion impl.
+  // base58 encoding from base-x conversion impl. 32 and 64 byte values
+  // (keys, hashes and signatures) use fixed-width kernels
   int enc_base58( const uint8_t *src, int len, char *result, int rlen);
   int dec_base58( const uint8_t *str, int len, uint8_t *result );
 
+  // generic base-x conversion for any length
+  int enc_base58_generic( const uint8_t *src, int len, char *result, int rlen);
+  int dec_base58_generic( const uint8_t *str, int len, uint8_t *result );
+
   // base64 encoding courtesy of
   // Adam Rudd per licence: github.com/adamvr/arduino-base64
   size_t enc_base64_len( size_t len );
   size_t enc_base64( const uint8_t *src, int len, char *result );
   size_t dec_base64( const char *str, int len, uint8_t *result );
 
+  // limit simd used by base64 (0=scalar, 1=ssse3, 2=avx2). defaults to
+  // the best supported by the cpu
+  void set_base64_simd( unsigned );
+  unsigned get_base64_simd();
+
   // integer to string encoding
   char *uint_to_str( uint64_t val, char *end_ptr );
   uint64_t str_to_uint( const char *str, unsigned len );
@@ -9,7 +9,15 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <poll.h>
-
+#include <limits.h>
+#include <sys/uio.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <thread>
 #include <cctype>
 #include <iostream>
 
@@ -17,16 +25,131 @@
 
 namespace pc
 {
-  // net_buf allocation and caching scheme
+  // net_buf allocation and caching scheme. each thread allocates from
+  // and frees to its own cache without atomics. caches exchange
+  // fixed-size magazines (chains of free buffers) with a global
+  // lock-free depot, which releases magazines back to the system once
+  // it holds more than the high-water mark of free buffers
   struct net_buf_alloc
   {
   public:
-    net_buf_alloc();
-    ~net_buf_alloc();
+    static const uint32_t mag_len = 64;          // buffers per magazine
+    static const size_t   slab_len = 2UL << 20;  // hugepage slab size
+
     net_buf *alloc();
     void dealloc( net_buf * );
+    void flush();
+    void release();
+
   private:
-    net_buf *ptr_;
+    void refill();
+    void spill();
+    void drop( net_buf *hd );
+    void retire( net_buf *hd, net_buf *tl, uint32_t num );
+    void reclaim( bool do_wait );
+
+    net_buf *ptr_;   // free list
+    uint32_t num_;   // buffers in free list
+    uint64_t nal_;   // allocations not yet added to global stats
+    net_buf *rtr_;   // buffers waiting to be released to the system
+    uint32_t nrt_;   // buffers in rtr_
+  };
+
+  // returns thread cache to depot on thread exit
+  struct net_buf_guard
+  {
+    ~net_buf_guard();
+  };
+
+  // io_uring rings accessed through the raw syscall interface.
+  // net_connect sockets are read with one multishot recv each into a
+  // shared ring of provided buffers and written with sendmsg requests
+  // built straight from the send queue. other sockets (and all
+  // sockets on kernels without provided buffer rings) are tracked with
+  // one multishot poll plus a one-shot write poll armed only while a
+  // socket has queued output. all requests made between two calls to
+  // net_loop::poll() are submitted in the same io_uring_enter call
+  // that reaps completions
+  struct net_uring
+  {
+    static const unsigned num_entries = 256;
+    static const unsigned num_bufs = 512;    // provided recv buffers
+    static const unsigned buf_size = 8192;   // provided recv buffer size
+    static const unsigned max_iov = 64;      // iov entries per sendmsg
+
+    // request type in low bits of user_data
+    static const uint64_t rd_tag = 0UL;      // read poll
+    static const uint64_t wr_tag = 1UL;      // write poll
+    static const uint64_t rv_tag = 2UL;      // recv
+    static const uint64_t sd_tag = 3UL;      // sendmsg
+    static const uint64_t tag_mask = 3UL;
+
+    // per-socket registration. outlives the socket until the kernel
+    // has posted the final completion for every request it referenced
+    struct entry
+    {
+      net_socket  *sp_;     // owning socket or null if deleted
+      net_connect *nc_;     // sp_ if read and written through the ring
+      uint32_t     events_; // requested events
+      bool         rd_;     // multishot read poll armed
+      bool         wr_;     // one-shot write poll armed
+      bool         rv_;     // multishot recv armed
+      bool         sd_;     // sendmsg in flight
+      msghdr       msg_;    // sendmsg arguments
+      iovec        iov_[max_iov];
+      entry       *next_;   // free list
+    };
+
+    net_uring();
+    ~net_uring();
+
+    bool init();
+    bool init_bufs();
+    bool add( net_socket *, uint32_t events );
+    bool del( net_socket * );
+    bool poll( int timeout );
+    void drain();
+
+    entry *alloc_entry();
+    void   free_entry( entry * );
+    io_uring_sqe *get_sqe();
+    bool   poll_add( entry *, uint32_t events, bool is_wr );
+    bool   poll_remove( entry *, bool is_wr );
+    bool   recv_add( entry * );
+    bool   send_add( entry * );
+    int    cancel( int fd, uint32_t flags );
+    void   recycle( unsigned bid );
+    int    enter( unsigned to_submit, unsigned min_complete, int timeout );
+    unsigned get_to_submit() const;
+    void   on_completion( io_uring_cqe * );
+    void   on_recv( entry *, io_uring_cqe * );
+    void   on_send( entry *, io_uring_cqe * );
+    bool   rearm( entry * );
+
+    int           fd_;
+    unsigned      sq_tail_;
+    unsigned     *sq_head_;
+    unsigned     *sq_ktail_;
+    unsigned     *sq_mask_;
+    unsigned     *sq_array_;
+    unsigned      sq_entries_;
+    io_uring_sqe *sqes_;
+    unsigned     *cq_head_;
+    unsigned     *cq_tail_;
+    unsigned     *cq_mask_;
+    io_uring_cqe *cqes_;
+    void         *sq_ptr_;
+    void         *cq_ptr_;
+    size_t        sq_len_;
+    size_t        cq_len_;
+    size_t        sqe_len_;
+    io_uring_buf_ring *br_;    // provided buffer ring
+    char         *bufs_;       // provided buffers
+    uint16_t      br_tail_;    // provided buffer ring tail
+    bool          is_io_;      // connections read and written via ring
+    bool          stop_;       // draining - do not issue new requests
+    entry        *free_;
+    std::vector<entry*> evec_; // all allocated entries
   };
 
 }
@@ -36,30 +159,268 @@ using namespace pc;
 ///////////////////////////////////////////////////////////////////////////
 // net_buf_alloc
 
-net_buf_alloc::net_buf_alloc()
-: ptr_( nullptr )
+// magazines in the depot are linked through the payload of their first
+// buffer, which also holds their length. the depot head packs a 48-bit pointer with a 16-bit tag
+// incremented on every update to prevent ABA. a pop may still read the
+// link of a magazine that another thread has just popped, so buffers
+// are only deleted once no pop is in flight
+static_assert( sizeof( net_buf ) == 1280, "unexpected net_buf size");
+
+static const uint64_t depot_ptr_mask = ( 1UL << 48 ) - 1UL;
+static std::atomic<uint64_t> depot_hd_( 0 );
+static std::atomic<uint64_t> num_pop_( 0 );
+static std::atomic<uint64_t> num_depot_( 0 );
+static std::atomic<uint64_t> num_sys_( 0 );
+static std::atomic<uint64_t> num_rel_( 0 );
+static std::atomic<uint64_t> num_peak_( 0 );
+static std::atomic<uint64_t> num_alloc_( 0 );
+static std::atomic<uint64_t> num_huge_( 0 );
+static std::atomic<uint64_t> high_water_( 1UL << 14 );
+static std::atomic<bool>     use_huge_( false );
+
+// 2MB aligned base addresses of hugepage slabs. buffers carved from a
+// slab cannot be released on their own and are told apart by address
+static const size_t slab_tab_len = 4096;
+static std::atomic<uint64_t> slab_tab_[slab_tab_len];
+
+static thread_local net_buf_alloc mem_;
+static thread_local net_buf_guard guard_;
+
+static net_buf *&depot_next( net_buf *mag )
+{
+  return *reinterpret_cast<net_buf**>( mag->buf_ );
+}
+
+static uint32_t& depot_num( net_buf *mag )
+{
+  return *reinterpret_cast<uint32_t*>( mag->buf_ + sizeof( net_buf* ) );
+}
+
+static void depot_push( net_buf *mag, uint32_t num )
+{
+  depot_num( mag ) = num;
+  uint64_t hd = depot_hd_.load( std::memory_order_relaxed );
+  uint64_t val;
+  do {
+    depot_next( mag ) = reinterpret_cast<net_buf*>( hd & depot_ptr_mask );
+    val = ( ( hd & ~depot_ptr_mask ) + ( 1UL << 48 ) ) |
+      reinterpret_cast<uint64_t>( mag );
+  } while( !depot_hd_.compare_exchange_weak(
+        hd, val, std::memory_order_release, std::memory_order_relaxed ) );
+  num_depot_.fetch_add( num, std::memory_order_relaxed );
+}
+
+static net_buf *depot_pop( uint32_t& num )
+{
+  // the in-flight count is sequentially consistent with the head so
+  // that a thread seeing no pop in flight after a magazine left the
+  // depot knows no pop can still read its link
+  num_pop_.fetch_add( 1, std::memory_order_seq_cst );
+  uint64_t hd = depot_hd_.load( std::memory_order_seq_cst );
+  net_buf *mag;
+  uint64_t val;
+  do {
+    mag = reinterpret_cast<net_buf*>( hd & depot_ptr_mask );
+    if ( !mag ) {
+      break;
+    }
+    val = ( ( hd & ~depot_ptr_mask ) + ( 1UL << 48 ) ) |
+      reinterpret_cast<uint64_t>( depot_next( mag ) );
+  } while( !depot_hd_.compare_exchange_weak(
+        hd, val, std::memory_order_seq_cst, std::memory_order_seq_cst ) );
+  num_pop_.fetch_sub( 1, std::memory_order_release );
+  if ( mag ) {
+    num = depot_num( mag );
+    num_depot_.fetch_sub( num, std::memory_order_relaxed );
+  }
+  return mag;
+}
+
+static size_t slab_idx( uint64_t base )
 {
-  static_assert( sizeof( net_buf ) == 1280, "unexpected net_buf size");
+  return ( ( base >> 21 ) * 0x9e3779b97f4a7c15UL >> 32 ) & ( slab_tab_len - 1 );
 }
 
-net_buf_alloc::~net_buf_alloc()
+static bool add_slab( void *ptr )
 {
-  while( ptr_ ) {
-    net_buf *nxt = ptr_->next_;
-    delete ptr_;
-    ptr_ = nxt;
+  uint64_t base = reinterpret_cast<uint64_t>( ptr );
+  size_t idx = slab_idx( base );
+  for( size_t i = 0; i != slab_tab_len; ++i ) {
+    uint64_t val = 0UL;
+    if ( slab_tab_[idx].compare_exchange_strong(
+           val, base, std::memory_order_release ) ) {
+      return true;
+    }
+    idx = ( idx + 1 ) & ( slab_tab_len - 1 );
   }
+  return false;
 }
 
-net_buf *net_buf_alloc::alloc()
+static bool is_slab( net_buf *ptr )
 {
-  net_buf *res;
-  if ( ptr_ ) {
-    res  = ptr_;
-    ptr_ = res->next_;
+  if ( !num_huge_.load( std::memory_order_relaxed ) ) {
+    return false;
+  }
+  uint64_t base = reinterpret_cast<uint64_t>( ptr ) &
+    ~( net_buf_alloc::slab_len - 1 );
+  size_t idx = slab_idx( base );
+  for( size_t i = 0; i != slab_tab_len; ++i ) {
+    uint64_t val = slab_tab_[idx].load( std::memory_order_acquire );
+    if ( val == base ) {
+      return true;
+    }
+    if ( !val ) {
+      return false;
+    }
+    idx = ( idx + 1 ) & ( slab_tab_len - 1 );
+  }
+  return false;
+}
+
+static void add_sys( uint64_t num )
+{
+  uint64_t used = num_sys_.fetch_add( num, std::memory_order_relaxed ) + num -
+    num_rel_.load( std::memory_order_relaxed );
+  uint64_t peak = num_peak_.load( std::memory_order_relaxed );
+  while( used > peak && !num_peak_.compare_exchange_weak(
+        peak, used, std::memory_order_relaxed ) );
+}
+
+// carve hugepage slab into buffers or return null if unavailable
+static net_buf *alloc_slab( uint32_t& num )
+{
+  void *ptr = ::mmap( nullptr, net_buf_alloc::slab_len,
+      PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0 );
+  if ( ptr == MAP_FAILED ) {
+    return nullptr;
+  }
+  if ( !add_slab( ptr ) ) {
+    ::munmap( ptr, net_buf_alloc::slab_len );
+    return nullptr;
+  }
+  num_huge_.fetch_add( 1, std::memory_order_relaxed );
+  net_buf *vec = static_cast<net_buf*>( ptr );
+  num = static_cast<uint32_t>( net_buf_alloc::slab_len / sizeof( net_buf ) );
+  for( uint32_t i=1; i != num; ++i ) {
+    vec[i-1].next_ = &vec[i];
+  }
+  vec[num-1].next_ = nullptr;
+  return vec;
+}
+
+void net_buf_alloc::refill()
+{
+  uint32_t num = 0;
+  net_buf *mag = depot_pop( num );
+  if ( mag ) {
+    ptr_ = mag;
+    num_ = num;
+    return;
+  }
+  if ( use_huge_.load( std::memory_order_relaxed ) ) {
+    net_buf *ptr = alloc_slab( num );
+    if ( ptr ) {
+      ptr_ = ptr;
+      num_ = num;
+      add_sys( num );
+      return;
+    }
+  }
+  for( uint32_t i=0; i != mag_len; ++i ) {
+    net_buf *ptr = new net_buf;
+    ptr->next_ = ptr_;
+    ptr_ = ptr;
+  }
+  num_ = mag_len;
+  add_sys( mag_len );
+}
+
+void net_buf_alloc::spill()
+{
+  // detach one magazine from the front of the free list
+  net_buf *mag = ptr_, *tl = ptr_;
+  for( uint32_t i=1; i != mag_len; ++i ) {
+    tl = tl->next_;
+  }
+  ptr_ = tl->next_;
+  tl->next_ = nullptr;
+  num_ -= mag_len;
+  num_alloc_.fetch_add( nal_, std::memory_order_relaxed );
+  nal_ = 0;
+
+  // release instead of caching once above the high-water mark
+  if ( num_depot_.load( std::memory_order_relaxed ) >=
+         high_water_.load( std::memory_order_relaxed ) ) {
+    drop( mag );
   } else {
-    res = new net_buf;
+    depot_push( mag, mag_len );
   }
+}
+
+void net_buf_alloc::drop( net_buf *hd )
+{
+  // release heap buffers. buffers carved from hugepage slabs are never
+  // released and go back to the depot
+  net_buf *hhd = nullptr, *htl = nullptr, *shd = nullptr;
+  uint32_t hnum = 0, snum = 0;
+  while( hd ) {
+    net_buf *nxt = hd->next_;
+    if ( is_slab( hd ) ) {
+      hd->next_ = shd;
+      shd = hd;
+      ++snum;
+    } else {
+      hd->next_ = hhd;
+      hhd = hd;
+      htl = htl ? htl : hd;
+      ++hnum;
+    }
+    hd = nxt;
+  }
+  if ( hnum ) {
+    retire( hhd, htl, hnum );
+    reclaim( false );
+  }
+  if ( snum ) {
+    depot_push( shd, snum );
+  }
+}
+
+void net_buf_alloc::retire( net_buf *hd, net_buf *tl, uint32_t num )
+{
+  tl->next_ = rtr_;
+  rtr_ = hd;
+  nrt_ += num;
+  num_rel_.fetch_add( num, std::memory_order_relaxed );
+}
+
+void net_buf_alloc::reclaim( bool do_wait )
+{
+  // delete retired buffers once no depot pop is in flight. a pop that
+  // starts later cannot find them as they are no longer in the depot
+  while( nrt_ && num_pop_.load( std::memory_order_seq_cst ) ) {
+    if ( !do_wait ) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+  while( rtr_ ) {
+    net_buf *nxt = rtr_->next_;
+    delete rtr_;
+    rtr_ = nxt;
+  }
+  nrt_ = 0;
+}
+
+net_buf *net_buf_alloc::alloc()
+{
+  if ( !ptr_ ) {
+    refill();
+  }
+  net_buf *res = ptr_;
+  ptr_ = res->next_;
+  --num_;
+  ++nal_;
   res->next_ = nullptr;
   res->size_ = 0;
   return res;
@@ -69,26 +430,75 @@ void net_buf_alloc::dealloc( net_buf *ptr )
 {
   ptr->next_ = ptr_;
   ptr_ = ptr;
+  if ( ++num_ >= 2*mag_len ) {
+    spill();
+  }
+}
+
+void net_buf_alloc::flush()
+{
+  while( num_ >= mag_len ) {
+    spill();
+  }
+  num_alloc_.fetch_add( nal_, std::memory_order_relaxed );
+  nal_ = 0;
 }
 
-static net_buf_alloc mem_;
+void net_buf_alloc::release()
+{
+  // full magazines go to the depot, a partial one back to the system
+  // unless it was carved from a slab
+  flush();
+  drop( ptr_ );
+  ptr_ = nullptr;
+  num_ = 0;
+  reclaim( true );
+}
+
+net_buf_guard::~net_buf_guard()
+{
+  mem_.release();
+}
 
 net_buf *net_buf::alloc()
 {
+  (void)guard_;
   return mem_.alloc();
 }
 
 void net_buf::dealloc()
 {
+  // threads that only free buffers still flush their cache on exit
+  (void)guard_;
   mem_.dealloc( this );
 }
 
+void net_buf::set_high_water( uint64_t num )
+{
+  high_water_.store( num, std::memory_order_relaxed );
+}
+
+void net_buf::set_use_hugepage( bool val )
+{
+  use_huge_.store( val, std::memory_order_relaxed );
+}
+
+void net_buf::get_stats( net_buf_stats& st )
+{
+  st.num_alloc_ = num_alloc_.load( std::memory_order_relaxed );
+  st.num_sys_   = num_sys_.load( std::memory_order_relaxed );
+  st.num_rel_   = num_rel_.load( std::memory_order_relaxed );
+  st.num_depot_ = num_depot_.load( std::memory_order_relaxed );
+  st.num_peak_  = num_peak_.load( std::memory_order_relaxed );
+  st.num_huge_  = num_huge_.load( std::memory_order_relaxed );
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // net_wtr
 
 
 net_wtr::net_wtr()
-: hd_( mem_.alloc() ),
+: hd_( net_buf::alloc() ),
   tl_( hd_ ),
   sz_( 0 )
 {
@@ -102,7 +512,7 @@ net_wtr::~net_wtr()
 void net_wtr::reset()
 {
   dealloc();
-  hd_ = tl_ = mem_.alloc();
+  hd_ = tl_ = net_buf::alloc();
   sz_ = 0;
 }
 
@@ -126,7 +536,7 @@ void net_wtr::detach( net_buf *&hd, net_buf *&tl )
 
 void net_wtr::alloc()
 {
-  net_buf *ptr = mem_.alloc();
+  net_buf *ptr = net_buf::alloc();
   tl_->next_ = ptr;
   sz_ += tl_->size_;
   tl_ = ptr;
@@ -216,11 +626,533 @@ void net_wtr::print() const
   std::cout << std::endl;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// net_uring
+
+net_uring::net_uring()
+: fd_( -1 ),
+  sq_tail_( 0 ),
+  sq_head_( nullptr ),
+  sq_ktail_( nullptr ),
+  sq_mask_( nullptr ),
+  sq_array_( nullptr ),
+  sq_entries_( 0 ),
+  sqes_( nullptr ),
+  cq_head_( nullptr ),
+  cq_tail_( nullptr ),
+  cq_mask_( nullptr ),
+  cqes_( nullptr ),
+  sq_ptr_( MAP_FAILED ),
+  cq_ptr_( MAP_FAILED ),
+  sq_len_( 0 ),
+  cq_len_( 0 ),
+  sqe_len_( 0 ),
+  br_( nullptr ),
+  bufs_( nullptr ),
+  br_tail_( 0 ),
+  is_io_( false ),
+  stop_( false ),
+  free_( nullptr )
+{
+}
+
+net_uring::~net_uring()
+{
+  if ( is_io_ ) {
+    // make sure no recv is still writing to the provided buffers
+    cancel( -1, IORING_ASYNC_CANCEL_ANY );
+  }
+  if ( sqes_ ) {
+    ::munmap( sqes_, sqe_len_ );
+  }
+  if ( cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_ ) {
+    ::munmap( cq_ptr_, cq_len_ );
+  }
+  if ( sq_ptr_ != MAP_FAILED ) {
+    ::munmap( sq_ptr_, sq_len_ );
+  }
+  if ( fd_ >= 0 ) {
+    ::close( fd_ );
+  }
+  if ( bufs_ ) {
+    ::munmap( bufs_, (size_t)num_bufs * buf_size );
+  }
+  if ( br_ ) {
+    ::munmap( br_, num_bufs * sizeof( io_uring_buf ) );
+  }
+  for( entry *eptr: evec_ ) {
+    delete eptr;
+  }
+}
+
+bool net_uring::init()
+{
+  io_uring_params par[1];
+  __builtin_memset( par, 0, sizeof( par ) );
+  fd_ = (int)::syscall( __NR_io_uring_setup, num_entries, par );
+  if ( fd_ < 0 ) {
+    return false;
+  }
+  // need single mmap, no-drop completions and timed waits
+  uint32_t feat = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP |
+                  IORING_FEAT_EXT_ARG;
+  if ( ( par->features & feat ) != feat ) {
+    return false;
+  }
+  sq_len_ = par->sq_off.array + par->sq_entries * sizeof( unsigned );
+  cq_len_ = par->cq_off.cqes + par->cq_entries * sizeof( io_uring_cqe );
+  sq_len_ = cq_len_ = std::max( sq_len_, cq_len_ );
+  sq_ptr_ = ::mmap( nullptr, sq_len_, PROT_READ|PROT_WRITE,
+      MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_SQ_RING );
+  if ( sq_ptr_ == MAP_FAILED ) {
+    return false;
+  }
+  cq_ptr_ = sq_ptr_;
+  sqe_len_ = par->sq_entries * sizeof( io_uring_sqe );
+  void *sqes = ::mmap( nullptr, sqe_len_, PROT_READ|PROT_WRITE,
+      MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_SQES );
+  if ( sqes == MAP_FAILED ) {
+    return false;
+  }
+  char *sptr = (char*)sq_ptr_;
+  sqes_       = (io_uring_sqe*)sqes;
+  sq_head_    = (unsigned*)( sptr + par->sq_off.head );
+  sq_ktail_   = (unsigned*)( sptr + par->sq_off.tail );
+  sq_mask_    = (unsigned*)( sptr + par->sq_off.ring_mask );
+  sq_array_   = (unsigned*)( sptr + par->sq_off.array );
+  sq_entries_ = par->sq_entries;
+  sq_tail_    = *sq_ktail_;
+  cq_head_    = (unsigned*)( sptr + par->cq_off.head );
+  cq_tail_    = (unsigned*)( sptr + par->cq_off.tail );
+  cq_mask_    = (unsigned*)( sptr + par->cq_off.ring_mask );
+  cqes_       = (io_uring_cqe*)( sptr + par->cq_off.cqes );
+
+  // connections fall back to readiness polls without buffer rings
+  is_io_ = init_bufs();
+  return true;
+}
+
+bool net_uring::init_bufs()
+{
+  // synchronous cancel is needed before freeing send queues on close
+  int rc = cancel( -1, IORING_ASYNC_CANCEL_ANY );
+  if ( rc != 0 && rc != -ENOENT ) {
+    return false;
+  }
+  void *ptr = ::mmap( nullptr, num_bufs * sizeof( io_uring_buf ),
+      PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0 );
+  if ( ptr == MAP_FAILED ) {
+    return false;
+  }
+  br_ = (io_uring_buf_ring*)ptr;
+  ptr = ::mmap( nullptr, (size_t)num_bufs * buf_size,
+      PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0 );
+  if ( ptr == MAP_FAILED ) {
+    return false;
+  }
+  bufs_ = (char*)ptr;
+  io_uring_buf_reg reg[1];
+  __builtin_memset( reg, 0, sizeof( reg ) );
+  reg->ring_addr    = (uint64_t)br_;
+  reg->ring_entries = num_bufs;
+  reg->bgid         = 0;
+  if ( ::syscall( __NR_io_uring_register, fd_,
+         IORING_REGISTER_PBUF_RING, reg, 1 ) < 0 ) {
+    return false;
+  }
+  for( unsigned bid = 0; bid != num_bufs; ++bid ) {
+    recycle( bid );
+  }
+  return true;
+}
+
+net_uring::entry *net_uring::alloc_entry()
+{
+  entry *eptr = free_;
+  if ( eptr ) {
+    free_ = eptr->next_;
+  } else {
+    eptr = new entry;
+    evec_.push_back( eptr );
+  }
+  eptr->sp_     = nullptr;
+  eptr->nc_     = nullptr;
+  eptr->events_ = 0;
+  eptr->rd_     = false;
+  eptr->wr_     = false;
+  eptr->rv_     = false;
+  eptr->sd_     = false;
+  eptr->next_   = nullptr;
+  return eptr;
+}
+
+void net_uring::free_entry( entry *eptr )
+{
+  eptr->next_ = free_;
+  free_ = eptr;
+}
+
+unsigned net_uring::get_to_submit() const
+{
+  return sq_tail_ - *sq_ktail_;
+}
+
+int net_uring::enter( unsigned to_submit, unsigned min_complete, int timeout )
+{
+  // publish queued submissions
+  __atomic_store_n( sq_ktail_, sq_tail_, __ATOMIC_RELEASE );
+  unsigned flags = 0;
+  io_uring_getevents_arg arg[1];
+  __kernel_timespec ts[1];
+  if ( min_complete ) {
+    flags |= IORING_ENTER_GETEVENTS;
+    if ( timeout >= 0 ) {
+      __builtin_memset( arg, 0, sizeof( arg ) );
+      ts->tv_sec  = timeout / 1000;
+      ts->tv_nsec = ( timeout % 1000 ) * PC_NSECS_IN_MSEC;
+      arg->sigmask_sz = _NSIG / 8;
+      arg->ts = (uint64_t)ts;
+      flags |= IORING_ENTER_EXT_ARG;
+    }
+  }
+  return (int)::syscall( __NR_io_uring_enter, fd_, to_submit, min_complete,
+      flags, ( flags & IORING_ENTER_EXT_ARG ) ? (void*)arg : nullptr,
+      ( flags & IORING_ENTER_EXT_ARG ) ? sizeof( arg ) : 0UL );
+}
+
+io_uring_sqe *net_uring::get_sqe()
+{
+  unsigned head = __atomic_load_n( sq_head_, __ATOMIC_ACQUIRE );
+  if ( sq_tail_ - head >= sq_entries_ ) {
+    // submission queue full - flush without waiting
+    enter( get_to_submit(), 0, 0 );
+    head = __atomic_load_n( sq_head_, __ATOMIC_ACQUIRE );
+    if ( sq_tail_ - head >= sq_entries_ ) {
+      return nullptr;
+    }
+  }
+  unsigned idx = sq_tail_ & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[idx];
+  __builtin_memset( sqe, 0, sizeof( io_uring_sqe ) );
+  sq_array_[idx] = idx;
+  ++sq_tail_;
+  return sqe;
+}
+
+bool net_uring::poll_add( entry *eptr, uint32_t events, bool is_wr )
+{
+  io_uring_sqe *sqe = get_sqe();
+  if ( !sqe ) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = eptr->sp_->get_fd();
+  sqe->poll32_events = events & ~(uint32_t)EPOLLET;
+  sqe->user_data = (uint64_t)eptr | ( is_wr ? wr_tag : rd_tag );
+  if ( is_wr ) {
+    eptr->wr_ = true;
+  } else {
+    sqe->len = IORING_POLL_ADD_MULTI;
+    eptr->rd_ = true;
+  }
+  return true;
+}
+
+bool net_uring::poll_remove( entry *eptr, bool is_wr )
+{
+  io_uring_sqe *sqe = get_sqe();
+  if ( !sqe ) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = (uint64_t)eptr | ( is_wr ? wr_tag : rd_tag );
+  sqe->user_data = 0UL;
+  return true;
+}
+
+bool net_uring::recv_add( entry *eptr )
+{
+  // multishot recv picking buffers from the provided buffer ring
+  io_uring_sqe *sqe = get_sqe();
+  if ( !sqe ) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = eptr->sp_->get_fd();
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->buf_group = 0;
+  sqe->user_data = (uint64_t)eptr | rv_tag;
+  eptr->rv_ = true;
+  return true;
+}
+
+bool net_uring::send_add( entry *eptr )
+{
+  // one sendmsg in flight per socket covering the head of its queue
+  size_t tot = 0;
+  size_t num = eptr->nc_->get_send_iov( eptr->iov_, max_iov, tot );
+  if ( !num ) {
+    return true;
+  }
+  io_uring_sqe *sqe = get_sqe();
+  if ( !sqe ) {
+    return false;
+  }
+  __builtin_memset( &eptr->msg_, 0, sizeof( msghdr ) );
+  eptr->msg_.msg_iov    = eptr->iov_;
+  eptr->msg_.msg_iovlen = num;
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = eptr->sp_->get_fd();
+  sqe->addr = (uint64_t)&eptr->msg_;
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = (uint64_t)eptr | sd_tag;
+  eptr->sd_ = true;
+  return true;
+}
+
+int net_uring::cancel( int fd, uint32_t flags )
+{
+  // returns once the kernel has posted completions for all matching
+  // requests and no longer references their buffers
+  io_uring_sync_cancel_reg reg[1];
+  __builtin_memset( reg, 0, sizeof( reg ) );
+  reg->fd    = fd;
+  reg->flags = flags;
+  reg->timeout.tv_sec  = -1;
+  reg->timeout.tv_nsec = -1;
+  if ( ::syscall( __NR_io_uring_register, fd_,
+         IORING_REGISTER_SYNC_CANCEL, reg, 1 ) < 0 ) {
+    return -errno;
+  }
+  return 0;
+}
+
+void net_uring::recycle( unsigned bid )
+{
+  // hand buffer back to the kernel. entries are indexed from the ring
+  // start as br_->bufs is misplaced by the uapi flex array in c++
+  io_uring_buf *buf = &( (io_uring_buf*)br_ )[br_tail_ & ( num_bufs - 1 )];
+  buf->addr = (uint64_t)( bufs_ + (size_t)bid * buf_size );
+  buf->len  = buf_size;
+  buf->bid  = (uint16_t)bid;
+  ++br_tail_;
+  __atomic_store_n( &br_->tail, br_tail_, __ATOMIC_RELEASE );
+}
+
+bool net_uring::rearm( entry *eptr )
+{
+  // issue whatever requests the socket is missing
+  bool is_ok = true;
+  if ( eptr->nc_ ) {
+    if ( !eptr->rv_ ) {
+      is_ok = recv_add( eptr );
+    }
+    if ( is_ok && !eptr->sd_ && eptr->nc_->get_is_send() ) {
+      is_ok = send_add( eptr );
+    }
+  } else {
+    if ( !eptr->rd_ ) {
+      is_ok = poll_add( eptr, eptr->events_ & ~(uint32_t)EPOLLOUT, false );
+    }
+    if ( is_ok && !eptr->wr_ && ( eptr->events_ & EPOLLOUT ) ) {
+      is_ok = poll_add( eptr, POLLOUT, true );
+    }
+  }
+  return is_ok;
+}
+
+bool net_uring::add( net_socket *sptr, uint32_t events )
+{
+  // returns false if a request could not be queued. the socket stays
+  // registered with the requested events so that net_loop can move it
+  // to epoll
+  entry *eptr = (entry*)sptr->get_loop_ent();
+  if ( !eptr ) {
+    eptr = alloc_entry();
+    eptr->sp_ = sptr;
+    if ( is_io_ ) {
+      eptr->nc_ = dynamic_cast<net_connect*>( sptr );
+    }
+    if ( eptr->nc_ ) {
+      eptr->nc_->set_in_ring( true );
+    }
+    sptr->set_loop_ent( eptr );
+    sptr->set_in_loop( true );
+  }
+  eptr->events_ = events;
+  return stop_ || rearm( eptr );
+}
+
+bool net_uring::del( net_socket *sptr )
+{
+  // returns false if a request could not be removed, in which case
+  // the kernel keeps its reference to the file until the ring is closed
+  entry *eptr = (entry*)sptr->get_loop_ent();
+  if ( !eptr ) {
+    return true;
+  }
+  eptr->sp_ = nullptr;
+  sptr->set_loop_ent( nullptr );
+  sptr->set_in_loop( false );
+  if ( eptr->nc_ ) {
+    eptr->nc_->set_in_ring( false );
+    eptr->nc_ = nullptr;
+    if ( stop_ || ( !eptr->rv_ && !eptr->sd_ ) ) {
+      return true;
+    }
+    // submit anything still queued then wait until the kernel is done
+    // with the socket and its send queue before they are closed
+    enter( get_to_submit(), 0, 0 );
+    int rc = cancel( sptr->get_fd(),
+        IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL );
+    return rc == 0 || rc == -ENOENT;
+  }
+  bool is_ok = true;
+  if ( eptr->rd_ ) {
+    is_ok = poll_remove( eptr, false );
+  }
+  if ( eptr->wr_ ) {
+    is_ok = poll_remove( eptr, true ) && is_ok;
+  }
+  if ( eptr->rd_ || eptr->wr_ ) {
+    // submit now so the kernel drops its file reference before close
+    enter( get_to_submit(), 0, 0 );
+  }
+  // otherwise entry is released by on_completion once idle
+  return is_ok;
+}
+
+void net_uring::on_recv( entry *eptr, io_uring_cqe *cqe )
+{
+  if ( !( cqe->flags & IORING_CQE_F_MORE ) ) {
+    eptr->rv_ = false;
+  }
+  net_connect *nc = eptr->nc_;
+  int res = cqe->res;
+  if ( cqe->flags & IORING_CQE_F_BUFFER ) {
+    unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+    if ( nc && res > 0 ) {
+      nc->on_recv( bufs_ + (size_t)bid * buf_size, (size_t)res );
+    }
+    recycle( bid );
+  }
+  // out of buffers or interrupted recv is re-armed by on_completion
+  if ( nc && res <= 0 && res != -ENOBUFS &&
+       res != -EAGAIN && res != -ECANCELED ) {
+    nc->set_err_msg( "fail to read", res ? -res : ECONNRESET );
+  }
+}
+
+void net_uring::on_send( entry *eptr, io_uring_cqe *cqe )
+{
+  eptr->sd_ = false;
+  net_connect *nc = eptr->nc_;
+  int res = cqe->res;
+  if ( !nc ) {
+    return;
+  }
+  if ( res >= 0 ) {
+    nc->on_send( (size_t)res );
+  } else if ( res != -EAGAIN && res != -ECANCELED ) {
+    nc->set_err_msg( "fail to write", -res );
+  }
+}
+
+void net_uring::on_completion( io_uring_cqe *cqe )
+{
+  if ( !cqe->user_data ) {
+    return;
+  }
+  uint64_t tag = cqe->user_data & tag_mask;
+  entry *eptr = (entry*)( cqe->user_data & ~tag_mask );
+  if ( tag == rv_tag ) {
+    on_recv( eptr, cqe );
+  } else if ( tag == sd_tag ) {
+    on_send( eptr, cqe );
+  } else {
+    if ( tag == wr_tag ) {
+      eptr->wr_ = false;
+    } else if ( !( cqe->flags & IORING_CQE_F_MORE ) ) {
+      eptr->rd_ = false;
+    }
+    if ( eptr->sp_ && cqe->res != -ECANCELED ) {
+      eptr->sp_->poll();
+    }
+  }
+  net_socket *sp = eptr->sp_;
+  if ( sp && sp->get_is_err() ) {
+    sp->get_net_loop()->del( sp );
+    sp->teardown();
+  }
+  if ( eptr->sp_ ) {
+    // multishot request terminated by kernel (e.g. cq overflow or out
+    // of recv buffers) or send completed - re-arm
+    if ( !stop_ && !rearm( eptr ) ) {
+      eptr->sp_->get_net_loop()->switch_to_epoll();
+    }
+  } else if ( !eptr->rd_ && !eptr->wr_ && !eptr->rv_ && !eptr->sd_ ) {
+    free_entry( eptr );
+  }
+}
+
+bool net_uring::poll( int timeout )
+{
+  unsigned head = *cq_head_;
+  unsigned tail = __atomic_load_n( cq_tail_, __ATOMIC_ACQUIRE );
+  unsigned to_submit = get_to_submit();
+  if ( head == tail && ( to_submit || timeout != 0 ) ) {
+    // single syscall to submit pending requests and wait for events
+    enter( to_submit, timeout != 0 ? 1 : 0, timeout );
+    tail = __atomic_load_n( cq_tail_, __ATOMIC_ACQUIRE );
+  } else if ( to_submit ) {
+    enter( to_submit, 0, 0 );
+  }
+  if ( head == tail ) {
+    return false;
+  }
+  for( unsigned num = tail - head; num; --num ) {
+    // re-read head as a callback may have drained the ring
+    head = *cq_head_;
+    if ( head == __atomic_load_n( cq_tail_, __ATOMIC_ACQUIRE ) ) {
+      break;
+    }
+    io_uring_cqe cqe = cqes_[head & *cq_mask_];
+    // release slot before callbacks may queue more requests
+    __atomic_store_n( cq_head_, head + 1, __ATOMIC_RELEASE );
+    on_completion( &cqe );
+  }
+  return true;
+}
+
+void net_uring::drain()
+{
+  // cancel everything in flight and dispatch the final completions
+  // without issuing new requests, so no recv or send is left behind
+  // when the sockets move elsewhere. polls are simply dropped when
+  // the ring is closed
+  stop_ = true;
+  if ( !is_io_ ) {
+    return;
+  }
+  enter( get_to_submit(), 0, 0 );
+  cancel( -1, IORING_ASYNC_CANCEL_ANY );
+  do {
+    // flush any overflowed completions into the ring
+    enter( 0, 1, 0 );
+  } while( poll( 0 ) );
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // net_loop
 
 net_loop::net_loop()
-: fd_(-1)
+: fd_(-1),
+  use_uring_( false ),
+  ur_( nullptr ),
+  old_( nullptr )
 {
   __builtin_memset( ev_, 0, sizeof( ev_ ) );
   __builtin_memset( evarr_, 0, sizeof( evarr_ ) );
@@ -232,10 +1164,37 @@ net_loop::~net_loop()
     ::close( fd_ );
     fd_ = -1;
   }
+  delete ur_;
+  ur_ = nullptr;
+  delete old_;
+  old_ = nullptr;
+}
+
+void net_loop::set_use_uring( bool use_uring )
+{
+  use_uring_ = use_uring;
+}
+
+bool net_loop::get_use_uring() const
+{
+  return use_uring_;
+}
+
+bool net_loop::get_is_uring() const
+{
+  return ur_ != nullptr;
+}
+
+bool net_loop::get_is_uring_io() const
+{
+  return ur_ && ur_->is_io_;
 }
 
 bool net_loop::init()
 {
+  if ( use_uring_ && init_uring() ) {
+    return true;
+  }
   fd_ = ::epoll_create( 1 );
   if ( fd_ < 0 ) {
     return set_err_msg( "failed to create epoll", errno );
@@ -243,8 +1202,58 @@ bool net_loop::init()
   return true;
 }
 
-void net_loop::add( net_socket *eptr, uint32_t events )
+bool net_loop::init_uring()
+{
+  ur_ = new net_uring;
+  if ( !ur_->init() ) {
+    delete ur_;
+    ur_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool net_loop::switch_to_epoll()
 {
+  if ( !ur_ ) {
+    return true;
+  }
+  int fd = ::epoll_create( 1 );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to create epoll", errno );
+  }
+  fd_ = fd;
+
+  // finish ring transfers and move registered sockets over. the ring
+  // is closed (dropping its polls) on the next poll as completions may
+  // still be dispatching
+  net_uring *ur = ur_;
+  ur->drain();
+  ur_ = nullptr;
+  old_ = ur;
+  bool is_ok = true;
+  for( net_uring::entry *eptr: ur->evec_ ) {
+    net_socket *sptr = eptr->sp_;
+    if ( sptr ) {
+      eptr->sp_ = nullptr;
+      if ( eptr->nc_ ) {
+        eptr->nc_->set_in_ring( false );
+        eptr->nc_ = nullptr;
+      }
+      sptr->set_loop_ent( nullptr );
+      sptr->set_in_loop( false );
+      is_ok = add( sptr, eptr->events_ ) && is_ok;
+    }
+  }
+  return is_ok;
+}
+
+bool net_loop::add( net_socket *eptr, uint32_t events )
+{
+  if ( ur_ ) {
+    // submission queue stuck full
+    return ur_->add( eptr, events ) || switch_to_epoll();
+  }
   ev_->events = events;
   ev_->data.ptr = eptr;
   int evop = EPOLL_CTL_ADD;
@@ -253,11 +1262,18 @@ void net_loop::add( net_socket *eptr, uint32_t events )
   } else {
     eptr->set_in_loop( true );
   }
-  epoll_ctl( fd_, evop, eptr->get_fd(), ev_ );
+  return 0 == epoll_ctl( fd_, evop, eptr->get_fd(), ev_ );
 }
 
 void net_loop::del( net_socket *eptr )
 {
+  if ( ur_ ) {
+    if ( !ur_->del( eptr ) ) {
+      // closing the ring is the only way left to drop its polls
+      switch_to_epoll();
+    }
+    return;
+  }
   if ( eptr->get_in_loop() ) {
     ev_->events   = 0;
     ev_->data.ptr = eptr;
@@ -268,6 +1284,13 @@ void net_loop::del( net_socket *eptr )
 
 bool net_loop::poll( int timeout )
 {
+  if ( ur_ ) {
+    return ur_->poll( timeout );
+  }
+  if ( PC_UNLIKELY( old_ != nullptr ) ) {
+    delete old_;
+    old_ = nullptr;
+  }
   int nfds = epoll_wait( fd_, evarr_, max_events_, timeout );
   if ( nfds > 0 ) {
     for(int i=0; i != nfds; ++i ) {
@@ -286,12 +1309,85 @@ bool net_loop::poll( int timeout )
 }
 
 ///////////////////////////////////////////////////////////////////////////
-// net_socket
+// net_ring
 
 net_parser::~net_parser()
 {
 }
 
+net_ring::net_ring()
+: ptr_( nullptr ),
+  len_( 0 ),
+  pos_( 0 ),
+  sz_( 0 )
+{
+}
+
+net_ring::~net_ring()
+{
+  dealloc();
+}
+
+void net_ring::dealloc()
+{
+  if ( ptr_ ) {
+    ::munmap( ptr_, 2 * len_ );
+    ptr_ = nullptr;
+  }
+  len_ = pos_ = sz_ = 0;
+}
+
+bool net_ring::init( size_t len )
+{
+  dealloc();
+  size_t pgsz = static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+  len = ( ( len + pgsz - 1 ) / pgsz ) * pgsz;
+  int fd = ::memfd_create( "net_ring", MFD_CLOEXEC );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to create ring buffer", errno );
+  }
+  if ( 0 != ::ftruncate( fd, static_cast< off_t >( len ) ) ) {
+    ::close( fd );
+    return set_err_msg( "failed to size ring buffer", errno );
+  }
+  // reserve address range then map the file into both halves
+  void *ptr = ::mmap( nullptr, 2 * len, PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( ptr == MAP_FAILED ) {
+    ::close( fd );
+    return set_err_msg( "failed to map ring buffer", errno );
+  }
+  char *cptr = static_cast< char* >( ptr );
+  void *lo = ::mmap( cptr, len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_FIXED, fd, 0 );
+  void *hi = ::mmap( cptr + len, len, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_FIXED, fd, 0 );
+  ::close( fd );
+  if ( lo == MAP_FAILED || hi == MAP_FAILED ) {
+    ::munmap( ptr, 2 * len );
+    return set_err_msg( "failed to map ring buffer", errno );
+  }
+  ptr_ = cptr;
+  len_ = len;
+  return true;
+}
+
+bool net_ring::grow( size_t len )
+{
+  net_ring tmp;
+  if ( !tmp.init( len ) ) {
+    return set_err_msg( tmp.get_err_msg() );
+  }
+  __builtin_memcpy( tmp.ptr_, get_data(), sz_ );
+  std::swap( ptr_, tmp.ptr_ );
+  std::swap( len_, tmp.len_ );
+  pos_ = 0;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// net_socket
+
 net_socket::~net_socket()
 {
 }
@@ -299,7 +1395,8 @@ net_socket::~net_socket()
 net_socket::net_socket()
 : fd_(-1),
   inl_( false ),
-  lp_( nullptr )
+  lp_( nullptr ),
+  lent_( nullptr )
 {
 }
 
@@ -333,6 +1430,16 @@ bool net_socket::get_in_loop() const
   return inl_;
 }
 
+void net_socket::set_loop_ent( void *lent )
+{
+  lent_ = lent;
+}
+
+void *net_socket::get_loop_ent() const
+{
+  return lent_;
+}
+
 void net_socket::close()
 {
   if ( fd_ > 0 ) {
@@ -372,8 +1479,8 @@ bool net_socket::set_block( bool block )
 
 bool net_socket::init()
 {
-  if ( lp_ ) {
-    lp_->add( this, PC_EPOLL_FLAGS );
+  if ( lp_ && !lp_->add( this, PC_EPOLL_FLAGS ) ) {
+    return set_err_msg( "failed to add socket to net_loop" );
   }
   return true;
 }
@@ -384,9 +1491,11 @@ bool net_socket::init()
 net_connect::net_connect()
 : whd_( nullptr ),
   wtl_( nullptr ),
-  rsz_( 0 ),
   wsz_( 0 ),
-  np_( nullptr )
+  np_( nullptr ),
+  nsc_( 0UL ),
+  nsb_( 0UL ),
+  inr_( false )
 {
 }
 
@@ -405,6 +1514,16 @@ bool net_connect::get_is_send() const
   return whd_ != nullptr;
 }
 
+uint64_t net_connect::get_num_send_calls() const
+{
+  return nsc_;
+}
+
+uint64_t net_connect::get_num_send_bytes() const
+{
+  return nsb_;
+}
+
 void net_connect::add_send( net_wtr& msg )
 {
   net_buf *hd, *tl;
@@ -413,8 +1532,9 @@ void net_connect::add_send( net_wtr& msg )
     wtl_->next_ = hd;
   } else {
     whd_ = hd;
-    if ( get_net_loop() ) {
-      get_net_loop()->add( this, PC_EPOLL_FLAGS | EPOLLOUT );
+    if ( get_net_loop() &&
+         !get_net_loop()->add( this, PC_EPOLL_FLAGS | EPOLLOUT ) ) {
+      set_err_msg( "failed to add socket to net_loop" );
     }
   }
   wtl_ = tl;
@@ -428,37 +1548,104 @@ void net_connect::poll()
   poll_recv();
 }
 
+void net_connect::set_in_ring( bool in_ring )
+{
+  inr_ = in_ring;
+}
+
+bool net_connect::get_in_ring() const
+{
+  return inr_;
+}
+
+size_t net_connect::get_send_iov( iovec *iov, size_t max, size_t& tot ) const
+{
+  size_t num = 0;
+  uint16_t off = wsz_;
+  tot = 0;
+  for( net_buf *ptr = whd_; ptr && num != max; ptr = ptr->next_ ) {
+    iov[num].iov_base = &ptr->buf_[off];
+    iov[num].iov_len  = static_cast< size_t >( ptr->size_ - off );
+    tot += iov[num++].iov_len;
+    off = 0;
+  }
+  return num;
+}
+
+void net_connect::release_send( size_t len )
+{
+  // release fully written buffers and resume mid-buffer if partial
+  for( size_t left = len; whd_; ) {
+    size_t blen = static_cast< size_t >( whd_->size_ - wsz_ );
+    if ( left < blen ) {
+      wsz_ += static_cast< uint16_t >( left );
+      break;
+    }
+    left -= blen;
+    net_buf *nxt = whd_->next_;
+    whd_->dealloc();
+    wsz_ = 0;
+    whd_ = nxt;
+  }
+  if ( !whd_ ) {
+    wtl_ = nullptr;
+    if ( get_net_loop() &&
+         !get_net_loop()->add( this, PC_EPOLL_FLAGS ) ) {
+      set_err_msg( "failed to add socket to net_loop" );
+    }
+  }
+}
+
+void net_connect::on_send( size_t len )
+{
+  ++nsc_;
+  nsb_ += static_cast< uint64_t >( len );
+  release_send( len );
+}
+
 void net_connect::poll_send()
 {
-  if ( !whd_ || get_is_err() ) {
+  if ( !whd_ || inr_ || get_is_err() ) {
     return;
   }
+  iovec iov[IOV_MAX];
   for(;;) {
-    // write current buffer to ssl socket
-    char *ptr = &whd_->buf_[wsz_];
-    uint16_t len = whd_->size_ - wsz_;
-    int rc = ::send( get_fd(), ptr, len, MSG_NOSIGNAL );
-    if ( rc > 0 ) {
-      wsz_ += rc;
-
-      // advance to next buffer in list
-      if ( wsz_ == whd_->size_ ) {
-        net_buf *nxt = whd_->next_;
-        whd_->dealloc();
-        wsz_ = 0;
-        if ( ! ( whd_ = nxt ) ) {
-          wtl_ = nullptr;
-          if ( get_net_loop() ) {
-            get_net_loop()->add( this, PC_EPOLL_FLAGS );
-          }
-          break;
+    // gather as much of the writer queue as fits in one sendmsg
+    size_t tot = 0;
+    size_t num = get_send_iov( iov, IOV_MAX, tot );
+    ssize_t rc = 0;
+    if ( tot ) {
+      msghdr msg[1];
+      __builtin_memset( msg, 0, sizeof( msg ) );
+      msg->msg_iov    = iov;
+      msg->msg_iovlen = num;
+      rc = ::sendmsg( get_fd(), msg, MSG_NOSIGNAL );
+      ++nsc_;
+      if ( rc <= 0 ) {
+        // check if this is not a try again sort of error
+        if ( rc == 0 || errno != EAGAIN ) {
+          poll_error( true );
         }
+        break;
       }
+      nsb_ += static_cast< uint64_t >( rc );
+    }
+    release_send( static_cast< size_t >( rc ) );
+    if ( !whd_ || static_cast< size_t >( rc ) < tot ) {
+      // done or socket buffer is full - wait for next writable event
+      break;
+    }
+  }
+}
+
+void net_connect::parse_recv()
+{
+  // parse content in place
+  while( !get_is_err() && rdr_.size() ) {
+    size_t rlen = 0;
+    if ( np_->parse( rdr_.get_data(), rdr_.size(), rlen ) ) {
+      rdr_.consume( rlen );
     } else {
-      // check if this is not a try again sort of error
-      if ( rc == 0 || errno != EAGAIN ) {
-        poll_error( true );
-      }
       break;
     }
   }
@@ -466,36 +1653,67 @@ void net_connect::poll_send()
 
 void net_connect::poll_recv()
 {
+  if ( inr_ ) {
+    return;
+  }
+  if ( !rdr_.capacity() && !rdr_.init( buf_len ) ) {
+    set_err_msg( rdr_.get_err_msg() );
+    return;
+  }
   while( !get_is_err() ) {
-    // extend read buffer as required
-    size_t len = rdr_.size() - rsz_;
-    if ( len < buf_len ) {
-      rdr_.resize( rdr_.size() + buf_len );
+    // grow only if a single message exceeds the current capacity
+    if ( !rdr_.space() && !rdr_.grow( 2 * rdr_.capacity() ) ) {
+      set_err_msg( rdr_.get_err_msg() );
+      break;
     }
-    // read up to buf_len at a time
-    ssize_t rc = ::recv( get_fd(), &rdr_[rsz_], buf_len, MSG_NOSIGNAL );
+    ssize_t rc = ::recv(
+        get_fd(), rdr_.get_space(), rdr_.space(), MSG_NOSIGNAL );
     if ( rc > 0 ) {
-      rsz_ += static_cast< size_t >( rc );
+      rdr_.commit( static_cast< size_t >( rc ) );
     } else {
       if ( rc == 0 || errno != EAGAIN ) {
         poll_error( true );
       }
       break;
     }
-    // parse content
-    for( size_t idx=0; !get_is_err() && rsz_; ) {
-      size_t rlen = 0;
-      if ( np_->parse( &rdr_[idx], rsz_, rlen ) ) {
-        idx  += rlen;
-        rsz_ -= rlen;
-      } else {
-        // shuffle remaining bytes to beginning of buffer
-        if ( idx ) {
-          __builtin_memmove( &rdr_[0], &rdr_[idx], rsz_ );
-        }
-        break;
-      }
+    parse_recv();
+  }
+  // return to default footprint once an oversized message is consumed
+  if ( !rdr_.size() && rdr_.capacity() > buf_len ) {
+    rdr_.init( buf_len );
+  }
+}
+
+void net_connect::on_recv( char *buf, size_t len )
+{
+  // parse straight out of the kernel-filled buffer unless part of a
+  // message is already waiting in the read buffer
+  while( !rdr_.size() && len && !get_is_err() ) {
+    size_t rlen = 0;
+    if ( !np_->parse( buf, len, rlen ) ) {
+      break;
     }
+    buf += rlen;
+    len -= rlen;
+  }
+  if ( !len || get_is_err() ) {
+    return;
+  }
+  // keep remainder for when more data arrives
+  if ( !rdr_.capacity() && !rdr_.init( buf_len ) ) {
+    set_err_msg( rdr_.get_err_msg() );
+    return;
+  }
+  if ( rdr_.space() < len &&
+       !rdr_.grow( std::max( 2 * rdr_.capacity(), rdr_.size() + len ) ) ) {
+    set_err_msg( rdr_.get_err_msg() );
+    return;
+  }
+  __builtin_memcpy( rdr_.get_space(), buf, len );
+  rdr_.commit( len );
+  parse_recv();
+  if ( !rdr_.size() && rdr_.capacity() > buf_len ) {
+    rdr_.init( buf_len );
   }
 }
 
@@ -516,7 +1734,7 @@ void net_connect::teardown()
   }
   wtl_ = nullptr;
   rdr_.clear();
-  rsz_ = wsz_ = 0;
+  wsz_ = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////
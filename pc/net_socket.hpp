@@ -4,11 +4,23 @@
 #include <pc/key_pair.hpp>
 #include <pc/misc.hpp>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <vector>
 
 namespace pc
 {
 
+  // net_buf allocator statistics
+  struct net_buf_stats
+  {
+    uint64_t num_alloc_;  // allocations (flushed from thread caches)
+    uint64_t num_sys_;    // buffers obtained from the system
+    uint64_t num_rel_;    // buffers released to the system
+    uint64_t num_depot_;  // free buffers held in global depot
+    uint64_t num_peak_;   // peak of buffers obtained and not released
+    uint64_t num_huge_;   // hugepage slabs mapped
+  };
+
   // network message buffer
   struct net_buf
   {
@@ -18,6 +30,16 @@ namespace pc
     char     buf_[len];
     void dealloc();
     static net_buf *alloc();
+
+    // number of free buffers kept in the global depot before
+    // buffers are released to the system (default 16384)
+    static void set_high_water( uint64_t );
+
+    // carve buffers from 2MB hugepage slabs where available. slab
+    // buffers are never released
+    static void set_use_hugepage( bool );
+
+    static void get_stats( net_buf_stats& );
   };
 
   // network message writer
@@ -51,24 +73,90 @@ namespace pc
   public:
     virtual ~net_parser();
 
-    // parse inbound message
+    // parse inbound message in place. buf points directly into the
+    // connection's receive buffer, holds all sz unconsumed bytes
+    // contiguously and may be modified by the parser. on success
+    // set len to the number of bytes consumed and return true.
+    // return false if more data is required, in which case the same
+    // bytes are presented again once more data has arrived
     virtual bool parse( const char *buf, size_t sz, size_t& len ) = 0;
   };
 
+  // receive ring buffer with the same pages mapped twice back-to-back
+  // so that unconsumed data is always contiguous without shifting
+  class net_ring : public error
+  {
+  public:
+    net_ring();
+    ~net_ring();
+
+    // allocate ring of (page-rounded) capacity
+    bool init( size_t len );
+
+    // re-allocate to larger capacity keeping unconsumed data
+    bool grow( size_t len );
+
+    // unconsumed data
+    char *get_data() const;
+    size_t size() const;
+
+    // free space following unconsumed data
+    char *get_space() const;
+    size_t space() const;
+
+    // total capacity
+    size_t capacity() const;
+
+    // append len bytes written to get_space()
+    void commit( size_t len );
+
+    // consume len bytes from get_data()
+    void consume( size_t len );
+
+    // drop all data
+    void clear();
+
+  private:
+    void dealloc();
+
+    char  *ptr_; // start of double mapping
+    size_t len_; // capacity
+    size_t pos_; // offset of first unconsumed byte
+    size_t sz_;  // unconsumed size
+  };
+
   class net_socket;
+  struct net_uring;
 
-  // epoll-based loop
+  // epoll or io_uring based loop
   class net_loop : public error
   {
   public:
     net_loop();
     ~net_loop();
 
+    // request io_uring backend (default off). falls back to epoll
+    // at init() time if io_uring is not supported by the kernel
+    void set_use_uring( bool );
+    bool get_use_uring() const;
+
+    // is io_uring backend active
+    bool get_is_uring() const;
+
+    // are connections read and written through io_uring completions
+    // (multishot recv into provided buffers and queued sendmsg) rather
+    // than readiness polls. requires linux 6.0 or later
+    bool get_is_uring_io() const;
+
+    // move an io_uring loop and its sockets over to epoll. done
+    // automatically when io_uring cannot queue a request
+    bool switch_to_epoll();
+
     // initialize
     bool init();
 
-    // add/delete sockets to epoll loop
-    void add( net_socket *, uint32_t events );
+    // add/delete sockets to loop. add returns false on failure
+    bool add( net_socket *, uint32_t events );
     void del( net_socket * );
 
     // poll all connected sockets
@@ -78,7 +166,13 @@ namespace pc
 
     static const int max_events_ = 128;
 
+    bool init_uring();
+    bool poll_uring( int timeout );
+
     int         fd_;                 // epoll file descriptor
+    bool        use_uring_;          // io_uring requested
+    net_uring  *ur_;                 // io_uring state if active
+    net_uring  *old_;                // io_uring state to close on poll
     epoll_event ev_[1];              // event used in epoll_ctl
     epoll_event evarr_[max_events_]; // receive events
   };
@@ -109,6 +203,10 @@ namespace pc
     void set_in_loop( bool );
     bool get_in_loop() const;
 
+    // net_loop backend registration state
+    void set_loop_ent( void * );
+    void *get_loop_ent() const;
+
     // initialize
     virtual bool init();
 
@@ -122,6 +220,7 @@ namespace pc
     int        fd_;  // socket
     bool       inl_; // in-loop flag
     net_loop  *lp_;  // optional event_loop
+    void      *lent_;// loop backend registration
   };
 
   // read/write client connection
@@ -145,21 +244,43 @@ namespace pc
     // any messages in the send queue
     bool get_is_send() const;
 
+    // number of send syscalls and bytes flushed since construction
+    uint64_t get_num_send_calls() const;
+    uint64_t get_num_send_bytes() const;
+
     // drop all outbound messages
     void teardown() override;
 
+    // recv and send are completed by the io_uring backend instead of
+    // poll_recv() and poll_send(), which do nothing while this is set
+    void set_in_ring( bool );
+    bool get_in_ring() const;
+
+    // io_uring backend completions. on_recv parses len bytes received
+    // into buf, which may be modified. on_send releases len bytes sent
+    // from the iov entries last gathered by get_send_iov
+    void on_recv( char *buf, size_t len );
+    void on_send( size_t len );
+
+    // gather up to max entries of the send queue. returns the number
+    // of entries and sets tot to their total length
+    size_t get_send_iov( iovec *iov, size_t max, size_t& tot ) const;
+
   protected:
 
-    typedef std::vector<char> buf_t;
-    static const size_t buf_len = 2048;
+    static const size_t buf_len = 65536;
     void poll_error( bool );
+    void parse_recv();
+    void release_send( size_t len );
 
-    buf_t       rdr_; // inbound message read buffer
+    net_ring    rdr_; // inbound message read buffer
     net_buf    *whd_; // head of writer queue
     net_buf    *wtl_; // tail of writer queue
-    size_t      rsz_; // current read position
     uint16_t    wsz_; // current write position
     net_parser *np_;  // message parser
+    uint64_t    nsc_; // number of send syscalls
+    uint64_t    nsb_; // number of bytes sent
+    bool        inr_; // recv and send driven by io_uring
   };
 
   // new client acceptor for net_listen
@@ -478,6 +599,50 @@ namespace pc
   /////////////////////////////////////////////////////////////////////////
   // inline impl.
 
+  inline char *net_ring::get_data() const
+  {
+    return &ptr_[pos_];
+  }
+
+  inline size_t net_ring::size() const
+  {
+    return sz_;
+  }
+
+  inline char *net_ring::get_space() const
+  {
+    return &ptr_[pos_ + sz_];
+  }
+
+  inline size_t net_ring::space() const
+  {
+    return len_ - sz_;
+  }
+
+  inline size_t net_ring::capacity() const
+  {
+    return len_;
+  }
+
+  inline void net_ring::commit( size_t len )
+  {
+    sz_ += len;
+  }
+
+  inline void net_ring::consume( size_t len )
+  {
+    sz_  -= len;
+    pos_ += len;
+    if ( pos_ >= len_ ) {
+      pos_ -= len_;
+    }
+  }
+
+  inline void net_ring::clear()
+  {
+    pos_ = sz_ = 0;
+  }
+
   inline bool ip_addr::operator==( const ip_addr& obj ) const
   {
     return i_[0] == obj.i_[0] && i_[1] == obj.i_[1];
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace pc
+{
+
+  // set of items waiting to be sent kept in arrival order. a flag in the
+  // item itself (get_is_pending/set_is_pending) makes queueing, dedup and
+  // popping O(1) per item. items for which get_is_priority() is true are
+  // kept in a separate ring so that they can be sent ahead of the others
+  template<class T>
+  class pending_queue
+  {
+  public:
+
+    typedef enum { e_oldest_first, e_priority_first } order_t;
+
+    pending_queue();
+
+    // order in which items are popped (default oldest first)
+    void set_order( order_t );
+    order_t get_order() const;
+
+    // queue item unless already queued. returns false if it was
+    bool add( T * );
+
+    // replace vec with up to num items in pop order
+    void pop( std::vector<T*>& vec, size_t num );
+
+    // number of queued items
+    size_t size() const;
+    size_t get_num_priority() const;
+
+  private:
+
+    struct ent {
+      T       *ptr_;
+      uint64_t seq_;  // arrival order
+    };
+
+    // power of two ring buffer that doubles when full
+    class ring
+    {
+    public:
+      ring();
+      void push( const ent& );
+      const ent& front() const;
+      void pop_front();
+      size_t size() const;
+    private:
+      std::vector<ent> vec_;
+      size_t           hd_;
+      size_t           num_;
+    };
+
+    ring     prio_;  // priority items
+    ring     norm_;  // other items
+    uint64_t seq_;   // next arrival number
+    order_t  ord_;
+  };
+
+  template<class T>
+  pending_queue<T>::ring::ring()
+  : vec_( 64 ),
+    hd_( 0 ),
+    num_( 0 )
+  {
+  }
+
+  template<class T>
+  void pending_queue<T>::ring::push( const ent& e )
+  {
+    size_t mask = vec_.size() - 1;
+    if ( num_ == vec_.size() ) {
+      // unwrap into a buffer twice the size
+      std::vector<ent> vec( 2 * vec_.size() );
+      for( size_t i = 0; i != num_; ++i ) {
+        vec[i] = vec_[( hd_ + i ) & mask];
+      }
+      vec_.swap( vec );
+      hd_ = 0;
+      mask = vec_.size() - 1;
+    }
+    vec_[( hd_ + num_++ ) & mask] = e;
+  }
+
+  template<class T>
+  const typename pending_queue<T>::ent& pending_queue<T>::ring::front() const
+  {
+    return vec_[hd_];
+  }
+
+  template<class T>
+  void pending_queue<T>::ring::pop_front()
+  {
+    hd_ = ( hd_ + 1 ) & ( vec_.size() - 1 );
+    --num_;
+  }
+
+  template<class T>
+  size_t pending_queue<T>::ring::size() const
+  {
+    return num_;
+  }
+
+  template<class T>
+  pending_queue<T>::pending_queue()
+  : seq_( 0UL ),
+    ord_( e_oldest_first )
+  {
+  }
+
+  template<class T>
+  void pending_queue<T>::set_order( order_t ord )
+  {
+    ord_ = ord;
+  }
+
+  template<class T>
+  typename pending_queue<T>::order_t pending_queue<T>::get_order() const
+  {
+    return ord_;
+  }
+
+  template<class T>
+  bool pending_queue<T>::add( T *ptr )
+  {
+    if ( ptr->get_is_pending() ) {
+      return false;
+    }
+    ptr->set_is_pending( true );
+    ent e = { ptr, seq_++ };
+    if ( ptr->get_is_priority() ) {
+      prio_.push( e );
+    } else {
+      norm_.push( e );
+    }
+    return true;
+  }
+
+  template<class T>
+  void pending_queue<T>::pop( std::vector<T*>& vec, size_t num )
+  {
+    vec.clear();
+    for( ; num && ( prio_.size() || norm_.size() ); --num ) {
+      // take from the priority ring if it is preferred or holds the
+      // oldest item
+      ring *rptr = &norm_;
+      if ( prio_.size() && ( !norm_.size() || ord_ == e_priority_first ||
+           prio_.front().seq_ < norm_.front().seq_ ) ) {
+        rptr = &prio_;
+      }
+      T *ptr = rptr->front().ptr_;
+      rptr->pop_front();
+      ptr->set_is_pending( false );
+      vec.push_back( ptr );
+    }
+  }
+
+  template<class T>
+  size_t pending_queue<T>::size() const
+  {
+    return prio_.size() + norm_.size();
+  }
+
+  template<class T>
+  size_t pending_queue<T>::get_num_priority() const
+  {
+    return prio_.size();
+  }
+
+}
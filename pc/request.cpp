@@ -153,6 +153,19 @@ void request::on_response( rpc::account_update * )
 {
 }
 
+void request::on_response( rpc::get_multiple_accounts * )
+{
+}
+
+void request::on_response( cached_account * )
+{
+}
+
+bool request::get_is_stale( const char *, size_t ) const
+{
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // get_mapping
 
@@ -160,6 +173,7 @@ get_mapping::get_mapping()
 : st_( e_new ),
   num_sym_( 0 )
 {
+  next_.zero();
 }
 
 void get_mapping::set_mapping_key( const pub_key& mkey )
@@ -192,19 +206,38 @@ void get_mapping::reset()
 void get_mapping::submit()
 {
   st_ = e_new;
-  areq_->set_commitment( get_manager()->get_commitment() );
-  areq_->set_account( &mkey_ );
-  areq_->set_sub( this );
   // get account data
-  get_rpc_client()->send( areq_ );
+  get_manager()->fetch_account( mkey_ );
 }
 
-void get_mapping::on_response( rpc::get_account_info *res )
+bool get_mapping::get_is_done() const
+{
+  return st_ == e_init;
+}
+
+static_assert( PC_PROBE_SIZE >= offsetof( pc_map_table_t, prod_ ), "" );
+static_assert( PC_PROBE_SIZE >= offsetof( pc_price_t, twap_ ), "" );
+
+bool get_mapping::get_is_stale( const char *buf, size_t len ) const
+{
+  // new or removed products change the count or the chain link
+  const pc_map_table_t *tab = (const pc_map_table_t*)buf;
+  return len < offsetof( pc_map_table_t, prod_ ) ||
+         tab->num_ != num_sym_ ||
+         next_ != *(const pub_key*)&tab->next_;
+}
+
+void get_mapping::on_response( rpc::get_multiple_accounts *res )
 {
   set_is_recv( true );
   update( res );
 }
 
+void get_mapping::on_response( cached_account *res )
+{
+  update( res );
+}
+
 void get_mapping::on_response( rpc::account_update *res )
 {
   if ( get_is_recv( )) {
@@ -222,8 +255,8 @@ void get_mapping::update( T *res )
     return;
   }
   pc_map_table_t *tab;
-  if ( sizeof( pc_map_table_t ) > res->get_data_ref( tab ) ||
-       tab->magic_ != PC_MAGIC ) {
+  size_t tlen = res->get_data_ref( tab );
+  if ( sizeof( pc_map_table_t ) > tlen || tab->magic_ != PC_MAGIC ) {
     cptr->set_err_msg( "invalid or corrupt mapping account" );
     return;
   }
@@ -231,9 +264,12 @@ void get_mapping::update( T *res )
     cptr->set_err_msg( "invalid mapping account version=" +
         std::to_string( tab->ver_ ) );
   }
+  cptr->cache_account(
+      mkey_, res->get_slot(), res->get_lamports(), tab, tlen );
 
   // check and get any new product accounts in mapping table
   num_sym_ = tab->num_;
+  next_ = *(pub_key*)&tab->next_;
   PC_LOG_INF( "add_mapping" )
     .add( "secondary", cptr->get_is_secondary() )
     .add( "account", mkey_ )
@@ -267,8 +303,6 @@ product::product( const pub_key& acc )
 : acc_( acc ),
   st_( e_subscribe )
 {
-  areq_->set_account( &acc_ );
-  areq_->set_sub( this );
 }
 
 product::~product()
@@ -324,18 +358,21 @@ void product::add_price( price *px )
 
 void product::submit()
 {
-  rpc_client  *cptr = get_rpc_client();
-  areq_->set_commitment( get_manager()->get_commitment() );
   st_ = e_subscribe;
-  cptr->send( areq_ );
+  get_manager()->fetch_account( acc_ );
 }
 
-void product::on_response( rpc::get_account_info *res )
+void product::on_response( rpc::get_multiple_accounts *res )
 {
   set_is_recv( true );
   update( res );
 }
 
+void product::on_response( cached_account *res )
+{
+  update( res );
+}
+
 void product::on_response( rpc::account_update *res )
 {
   if ( get_is_recv() ) {
@@ -355,7 +392,8 @@ void product::update( T *res )
   }
   pc_prod_t *prod;
   size_t plen = std::max( ZSTD_UPPER_BOUND, (size_t)PC_PROD_ACC_SIZE );
-  if ( sizeof( pc_prod_t ) > res->get_data_ref( prod, plen ) ||
+  plen = res->get_data_ref( prod, plen );
+  if ( sizeof( pc_prod_t ) > plen ||
        prod->magic_ != PC_MAGIC ||
        !init_from_account( prod ) ) {
     cptr->set_err_msg( "invalid or corrupt product account" );
@@ -369,6 +407,9 @@ void product::update( T *res )
     return;
   }
 
+  cptr->cache_account(
+      acc_, res->get_slot(), res->get_lamports(), prod, plen );
+
   // subscribe to firstprice account in chain
   if ( !pc_pub_key_is_zero( &prod->px_acc_ ) ) {
     cptr->add_price( *(pub_key*)&prod->px_acc_, this );
@@ -449,21 +490,26 @@ void product::dump_json( json_wtr& wtr ) const
 
 price::price( const pub_key& acc, product *prod )
 : init_( false ),
+  is_warm_( false ),
   isched_( false ),
   st_( e_subscribe ),
   pub_idx_( (unsigned)-1 ),
   apub_( acc ),
   lamports_( 0UL ),
   pub_slot_( 0UL ),
+  acc_slot_( 0UL ),
+  cache_slot_( 0UL ),
+  acc_len_( 0 ),
   prod_( prod ),
   sched_( this ),
   pinit_( this ),
   pptr_(nullptr),
-  last_attempted_update_slot_( 0UL )
+  last_attempted_update_slot_( 0UL ),
+  is_pend_( false ),
+  is_prio_( false ),
+  has_prio_( false )
 {
-  areq_->set_account( &apub_ );
   preq_->set_account( &apub_ );
-  areq_->set_sub( this );
   preq_->set_sub( this );
   size_t tlen = ZSTD_compressBound( ZSTD_UPPER_BOUND );
   pptr_ = (pc_price_t*)new char[tlen];
@@ -569,6 +615,32 @@ void price::set_last_attempted_update_slot( uint64_t slot )
   last_attempted_update_slot_ = slot;
 }
 
+bool price::get_is_pending() const
+{
+  return is_pend_;
+}
+
+void price::set_is_pending( bool is_pend )
+{
+  is_pend_ = is_pend;
+}
+
+bool price::get_is_priority() const
+{
+  return is_prio_;
+}
+
+bool price::get_has_priority() const
+{
+  return has_prio_;
+}
+
+void price::set_is_priority( bool is_prio )
+{
+  is_prio_ = is_prio;
+  has_prio_ = true;
+}
+
 uint64_t price::get_prev_slot() const
 {
   return pptr_->prev_slot_;
@@ -628,7 +700,14 @@ bool price::get_is_ready_publish() const
 {
   if ( st_ != e_publish )
     return false;
+
+  // publishing needs only the account key and our component index, so
+  // a price served from the account cache may be published while the
+  // cached image is recent
   manager *cptr = get_manager();
+  if ( is_warm_ && ( !cptr->get_slot() ||
+         cptr->get_slot() > acc_slot_ + cptr->get_cache_max_age() ) )
+    return false;
   if ( cptr->get_do_tx() ) {
     return cptr->get_is_tx_connect();
   } else {
@@ -636,6 +715,15 @@ bool price::get_is_ready_publish() const
   }
 }
 
+void price::flush_cache()
+{
+  if ( acc_slot_ > cache_slot_ ) {
+    get_manager()->cache_account(
+        apub_, acc_slot_, lamports_, pptr_, acc_len_ );
+    cache_slot_ = acc_slot_;
+  }
+}
+
 void price::reset()
 {
   st_ = e_subscribe;
@@ -796,7 +884,7 @@ bool price::send( price *prices[], const unsigned n )
     // If the batch is full, or we have reached the end, send the upd_price requests in upds_.
     // These correspond to the valid prices[j..i], inclusive.
     if (
-      upds_.size() >= mgr->get_max_batch_size()
+      upds_.size() >= mgr->get_batch_size()
       || ( upds_.size() && ( i + 1 ) == n )
     ) {
       if ( mgr->get_do_tx() ) {
@@ -814,34 +902,10 @@ bool price::send( price *prices[], const unsigned n )
         }
       }
       else {
+        // each price records the transaction id once it is signed.
+        // only these sends are acknowledged back to the batch policy
         p->get_rpc_client()->send( &upds_[ 0 ], upds_.size(), mgr->get_requested_upd_price_cu_units(), mgr->get_requested_upd_price_cu_price() );
-        p->tvec_.emplace_back(
-          std::string( 100, '\0' ), p->preq_->get_sent_time()
-        );
-        p->preq_->get_signature()->enc_base58( p->tvec_.back().first );
-        for ( unsigned k = j; k <= i; ++k ) {
-          price *const p1 = prices[ k ];
-          PC_LOG_DBG( "sent price update" )
-            .add( "secondary", mgr->get_is_secondary() )
-            .add( "price_account", *p1->get_account() )
-            .add( "product_account", *p1->prod_->get_account() )
-            .add( "symbol", p1->get_symbol() )
-            .add( "price_type", price_type_to_str( p1->get_price_type() ) )
-            .add( "sig", p->tvec_.back().first )
-            .add( "pub_slot", p->preq_->get_slot() )
-            .end();
-          if ( PC_UNLIKELY( p1->tvec_.size() >= 100 ) ) {
-            PC_LOG_WRN( "too many unacked price update transactions" )
-              .add( "secondary", mgr->get_is_secondary() )
-              .add( "price_account", *p1->get_account() )
-              .add( "product_account", *p1->prod_->get_account() )
-              .add( "symbol", p1->get_symbol() )
-              .add( "price_type", price_type_to_str( p1->get_price_type() ) )
-              .add( "num_txid", p1->tvec_.size() )
-              .end();
-            p1->tvec_.erase( p1->tvec_.begin(), p1->tvec_.begin() + 50 );
-          }
-        }
+        mgr->get_batch_policy()->add_sent( (unsigned)upds_.size() );
       }
 
       for ( unsigned k = j; k <= i; ++k ) {
@@ -861,9 +925,7 @@ void price::submit()
 {
   if ( st_ == e_subscribe ) {
     // subscribe first
-    areq_->set_commitment( get_manager()->get_commitment() );
-    rpc_client  *cptr = get_rpc_client();
-    cptr->send( areq_ );
+    get_manager()->fetch_account( apub_ );
     st_ = e_sent_subscribe;
   }
 }
@@ -875,6 +937,12 @@ bool price::has_unacked_updates() const
 
 void price::on_response( rpc::upd_price *res )
 {
+  rpc_request *rptr = res;
+  if ( rptr->get_is_err() ) {
+    get_manager()->get_batch_policy()->add_err();
+    rptr->reset_err();
+    return;
+  }
   std::string txid = res->get_ack_signature().as_string();
   const auto it = std::find_if( tvec_.begin(), tvec_.end(),
       [&] ( const std::pair<std::string,int64_t>& m ) { return m.first == txid; } );
@@ -882,6 +950,7 @@ void price::on_response( rpc::upd_price *res )
     return;
   const int64_t ack_dur = res->get_recv_time() - it->second;
   tvec_.erase( it );
+  get_manager()->get_batch_policy()->add_ack( ack_dur );
   PC_LOG_DBG( "received price update transaction ack" )
     .add( "secondary", get_manager()->get_is_secondary() )
     .add( "price_account", *get_account() )
@@ -893,10 +962,53 @@ void price::on_response( rpc::upd_price *res )
     .end();
 }
 
-void price::on_response( rpc::get_account_info *res )
+void price::on_sign( rpc::upd_price *res )
+{
+  manager *mgr = get_manager();
+  tvec_.emplace_back( std::string( 100, '\0' ), res->get_sent_time() );
+  res->get_signature()->enc_base58( tvec_.back().first );
+  PC_LOG_DBG( "sent price update" )
+    .add( "secondary", mgr->get_is_secondary() )
+    .add( "price_account", *get_account() )
+    .add( "product_account", *prod_->get_account() )
+    .add( "symbol", get_symbol() )
+    .add( "price_type", price_type_to_str( get_price_type() ) )
+    .add( "sig", tvec_.back().first )
+    .add( "pub_slot", res->get_slot() )
+    .end();
+  if ( PC_UNLIKELY( tvec_.size() >= 100 ) ) {
+    PC_LOG_WRN( "too many unacked price update transactions" )
+      .add( "secondary", mgr->get_is_secondary() )
+      .add( "price_account", *get_account() )
+      .add( "product_account", *prod_->get_account() )
+      .add( "symbol", get_symbol() )
+      .add( "price_type", price_type_to_str( get_price_type() ) )
+      .add( "num_txid", tvec_.size() )
+      .end();
+    tvec_.erase( tvec_.begin(), tvec_.begin() + 50 );
+  }
+}
+
+void price::on_response( rpc::get_multiple_accounts *res )
 {
   set_is_recv( true );
   update( res );
+  is_warm_ = false;
+}
+
+void price::on_response( cached_account *res )
+{
+  // serve the cached image until the chain responds
+  st_ = e_sent_subscribe;
+  update( res );
+  is_warm_ = true;
+}
+
+bool price::get_is_stale( const char *buf, size_t len ) const
+{
+  // aggregation advances the slots at the end of the header
+  return len < offsetof( pc_price_t, twap_ ) ||
+         0 != __builtin_memcmp( buf, pptr_, offsetof( pc_price_t, twap_ ) );
 }
 
 void price::on_response( rpc::account_update *res )
@@ -939,13 +1051,14 @@ void price::init_subscribe()
     mgr->add_price( *(pub_key*)&pptr_->next_, prod_ );
   }
 
-  // log new price object
-  log_update( "add_price" );
-
-  // callback users on new symbol update
-  manager_sub *sub = mgr->get_manager_sub();
-  if ( sub ) {
-    sub->on_add_symbol( mgr, this );
+  // log new price object and callback users on new symbol. a price
+  // added from the account cache was announced already
+  if ( !is_warm_ ) {
+    log_update( "add_price" );
+    manager_sub *sub = mgr->get_manager_sub();
+    if ( sub ) {
+      sub->on_add_symbol( mgr, this );
+    }
   }
 
   // reduce subscription count after we subscribe to next symbol in chain
@@ -965,12 +1078,21 @@ void price::update( T *res )
 
   // get account data
   size_t tlen = ZSTD_compressBound( ZSTD_UPPER_BOUND );
-  res->get_data_val( pptr_, tlen );
+  tlen = res->get_data_val( pptr_, tlen );
   if ( PC_UNLIKELY( pptr_->magic_ != PC_MAGIC ) ) {
     on_error_sub( "bad price account header", this );
     st_ = e_error;
     return;
   }
+  manager *mgr = get_manager();
+  lamports_ = res->get_lamports();
+  acc_slot_ = res->get_slot();
+  acc_len_ = tlen;
+
+  // account images change every slot so are cached on a slower cadence
+  if ( acc_slot_ >= cache_slot_ + mgr->get_cache_interval() ) {
+    flush_cache();
+  }
 
   // price account was (re) initialized
   if ( PC_UNLIKELY( pptr_->agg_.pub_slot_ == 0L ) ) {
@@ -985,8 +1107,6 @@ void price::update( T *res )
 
   // update publishers
   update_pub();
-  lamports_ = res->get_lamports();
-  manager *mgr = get_manager();
 
   // update aggregate price and status if changed
   if ( pub_slot_ != pptr_->agg_.pub_slot_ || pub_slot_ == 0UL ) {
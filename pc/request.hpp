@@ -4,6 +4,7 @@
 #include <pc/dbl_list.hpp>
 #include <pc/attr_id.hpp>
 #include <pc/pub_stats.hpp>
+#include <pc/account_cache.hpp>
 #include <oracle/oracle.h>
 
 namespace pc
@@ -60,7 +61,8 @@ namespace pc
   class request : public prev_next<request>,
                   public error,
                   public rpc_sub,
-                  public rpc_sub_i<rpc::account_update>
+                  public rpc_sub_i<rpc::account_update>,
+                  public rpc_sub_i<rpc::get_multiple_accounts>
   {
   public:
 
@@ -101,6 +103,16 @@ namespace pc
     bool get_is_recv() const;
     void on_response( rpc::account_update * ) override;
 
+    // account data from batched (re)bootstrap
+    void on_response( rpc::get_multiple_accounts * ) override;
+
+    // last known account data from the account cache on warm start
+    virtual void on_response( cached_account * );
+
+    // does a leading slice of the account on chain differ from the
+    // last account update received (default true)
+    virtual bool get_is_stale( const char *, size_t ) const;
+
   protected:
 
     template<class T> void on_error_sub( const std::string&, T * );
@@ -119,8 +131,7 @@ namespace pc
   };
 
   // mapping account subsciption and update
-  class get_mapping : public request,
-                      public rpc_sub_i<rpc::get_account_info>
+  class get_mapping : public request
   {
   public:
     get_mapping();
@@ -132,8 +143,11 @@ namespace pc
   public:
     void reset();
     void submit() override;
-    void on_response( rpc::get_account_info * ) override;
+    bool get_is_done() const override;
+    void on_response( rpc::get_multiple_accounts * ) override;
     void on_response( rpc::account_update * ) override;
+    void on_response( cached_account * ) override;
+    bool get_is_stale( const char *, size_t ) const override;
   private:
     typedef enum { e_new, e_init } state_t;
 
@@ -141,14 +155,13 @@ namespace pc
 
     state_t  st_;
     pub_key  mkey_;
+    pub_key  next_;
     uint32_t num_sym_;
-    rpc::get_account_info areq_[1];
   };
 
   // product symbol and other reference-data attributes
   class product : public request,
-                  public attr_dict,
-                  public rpc_sub_i<rpc::get_account_info>
+                  public attr_dict
   {
   public:
     // product account number
@@ -177,8 +190,9 @@ namespace pc
     virtual ~product();
     void reset();
     void submit() override;
-    void on_response( rpc::get_account_info * ) override;
+    void on_response( rpc::get_multiple_accounts * ) override;
     void on_response( rpc::account_update * ) override;
+    void on_response( cached_account * ) override;
     bool get_is_done() const override;
     void add_price( price * );
 
@@ -191,7 +205,6 @@ namespace pc
     pub_key                acc_;
     prices_t               pvec_;
     state_t                st_;
-    rpc::get_account_info  areq_[1];
   };
 
   // price submission schedule
@@ -233,8 +246,8 @@ namespace pc
   // price subscriber and publisher
   class price : public request,
                 public pub_stats,
-                public rpc_sub_i<rpc::get_account_info>,
-                public rpc_sub_i<rpc::upd_price>
+                public rpc_sub_i<rpc::upd_price>,
+                public rpc_sign_sub
   {
   public:
 
@@ -269,6 +282,15 @@ namespace pc
     uint64_t get_last_attempted_update_slot() const;
     void set_last_attempted_update_slot( uint64_t );
 
+    // queued in the manager's pending updates
+    bool get_is_pending() const;
+    void set_is_pending( bool );
+
+    // sent ahead of other pending updates when the queue backs up
+    bool get_is_priority() const;
+    bool get_has_priority() const;
+    void set_is_priority( bool );
+
     // submit new price update and update aggregate
     // will fail with false if in error (check get_is_err() )
     // or because symbol is not ready to publish (get_is_ready_publish())
@@ -328,11 +350,15 @@ namespace pc
   public:
     void reset();
     void unsubscribe();
+    void flush_cache();
     void submit() override;
     void on_response( rpc::upd_price * ) override;
-    void on_response( rpc::get_account_info * ) override;
+    void on_sign( rpc::upd_price * ) override;
+    void on_response( rpc::get_multiple_accounts * ) override;
     void on_response( rpc::account_update * ) override;
+    void on_response( cached_account * ) override;
     bool get_is_done() const override;
+    bool get_is_stale( const char *, size_t ) const override;
 
   private:
 
@@ -350,20 +376,26 @@ namespace pc
     bool update( int64_t price, uint64_t conf, symbol_status, bool aggr );
 
     bool                   init_;
+    bool                   is_warm_;
     bool                   isched_;
     state_t                st_;
     uint32_t               pub_idx_;
     pub_key                apub_;
     uint64_t               lamports_;
     uint64_t               pub_slot_;
+    uint64_t               acc_slot_;   // slot of account image
+    uint64_t               cache_slot_; // slot of image last cached
+    size_t                 acc_len_;
     product               *prod_;
     price_sched            sched_;
     price_init             pinit_;
-    rpc::get_account_info  areq_[1];
     rpc::upd_price         preq_[1];
     pc_price_t            *pptr_;
     txid_vec_t             tvec_;
     uint64_t               last_attempted_update_slot_;
+    bool                   is_pend_;
+    bool                   is_prio_;
+    bool                   has_prio_;
   };
 
   template<class T>
@@ -1,8 +1,17 @@
 #include "rpc_client.hpp"
 #include "bincode.hpp"
+#include "sign_pipeline.hpp"
 #include <unistd.h>
 #include "log.hpp"
 #include <zstd.h>
+#include <cxxabi.h>
+#include <stdlib.h>
+
+// interval between scans for timed out requests
+#define PC_RPC_SCAN_INTERVAL (10L*PC_NSECS_IN_MSEC)
+
+// upd_price transaction templates kept per rpc_client (power of two)
+#define PC_TX_CACHE_SIZE 64
 
 using namespace pc;
 
@@ -87,12 +96,75 @@ namespace pc
 
 }
 
+///////////////////////////////////////////////////////////////////////////
+// latency_hist
+
+latency_hist::latency_hist()
+{
+  clear();
+}
+
+void latency_hist::clear()
+{
+  cnt_ = 0UL;
+  max_ = 0L;
+  __builtin_memset( hist_, 0, sizeof( hist_ ) );
+}
+
+void latency_hist::add( int64_t ns )
+{
+  uint64_t us = ns > 0 ? static_cast<uint64_t>( ns ) / 1000UL : 0UL;
+  unsigned idx;
+  if ( us < 4UL ) {
+    idx = static_cast<unsigned>( us );
+  } else {
+    unsigned b = 63U - static_cast<unsigned>( __builtin_clzl( us ) );
+    idx = 4U*( b - 1U ) + static_cast<unsigned>( ( us >> ( b - 2U ) ) & 3UL );
+    idx = idx < num_buckets ? idx : num_buckets - 1U;
+  }
+  hist_[idx]++;
+  cnt_++;
+  max_ = ns > max_ ? ns : max_;
+}
+
+uint64_t latency_hist::get_count() const
+{
+  return cnt_;
+}
+
+int64_t latency_hist::get_max() const
+{
+  return max_;
+}
+
+int64_t latency_hist::get_quantile( double q ) const
+{
+  // rank of the quantile sample counting from one
+  double rank = __builtin_ceil( q * static_cast<double>( cnt_ ) );
+  uint64_t tgt = rank < 1. ? 1UL : static_cast<uint64_t>( rank );
+  uint64_t sum = 0UL;
+  for( unsigned idx = 0; cnt_ && idx != num_buckets; ++idx ) {
+    sum += hist_[idx];
+    if ( sum >= tgt ) {
+      uint64_t up = idx < 4U ? idx + 1U :
+        ( 5UL + ( idx & 3U ) ) << ( idx/4U - 1U );
+      int64_t ns = static_cast<int64_t>( up * 1000UL );
+      return ns < max_ ? ns : max_;
+    }
+  }
+  return 0L;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // rpc_client
 
 rpc_client::rpc_client()
 : hptr_( nullptr ),
   wptr_( nullptr ),
+  sp_( nullptr ),
+  gen_( 0UL ),
+  num_( 0UL ),
+  scan_ts_( 0L ),
   id_( 0UL ),
   cxt_( nullptr )
 {
@@ -136,26 +208,215 @@ net_connect *rpc_client::get_ws_conn() const
 
 void rpc_client::reset()
 {
-  rv_.clear();
+  for( id_ent& ent: itab_ ) {
+    ent.rvec_.clear();
+  }
+  for( method_ent& ment: mvec_ ) {
+    ment.num_ = 0UL;
+  }
   smap_.clear();
   reuse_.clear();
+  hold_.clear();
+  num_ = 0UL;
   id_ = 0;
+  ++gen_;
 }
 
-void rpc_client::send( rpc_request *rptr )
+uint64_t rpc_client::get_gen() const
+{
+  return gen_;
+}
+
+uint64_t rpc_client::get_id()
 {
-  // get request id
   uint64_t id;
   if ( !reuse_.empty() ) {
     id = reuse_.back();
     reuse_.pop_back();
   } else {
     id = ++id_;
+    if ( id >= itab_.size() ) {
+      itab_.resize( id + 1 );
+    }
+  }
+  return id;
+}
+
+unsigned rpc_client::get_method( const std::type_info& type )
+{
+  // few request types so a linear scan beats hashing
+  unsigned i = 0;
+  for( ; i != mvec_.size(); ++i ) {
+    if ( *mvec_[i].type_ == type ) {
+      return i;
+    }
+  }
+  method_ent ment;
+  ment.type_        = &type;
+  ment.num_         = 0UL;
+  ment.timeout_     = 0L;
+  ment.max_retry_   = 0;
+  ment.num_reply_   = 0UL;
+  ment.num_retry_   = 0UL;
+  ment.num_timeout_ = 0UL;
+  int st = 0;
+  char *name = abi::__cxa_demangle( type.name(), nullptr, nullptr, &st );
+  ment.name_ = st == 0 && name ? name : type.name();
+  free( name );
+  size_t pos = ment.name_.rfind( "::" );
+  if ( pos != std::string::npos ) {
+    ment.name_ = ment.name_.substr( pos + 2 );
+  }
+  mvec_.push_back( ment );
+  return i;
+}
+
+void rpc_client::set_timeout(
+    const std::type_info& type, int64_t timeout, unsigned max_retry )
+{
+  method_ent& ment = mvec_[get_method( type )];
+  ment.timeout_   = timeout;
+  ment.max_retry_ = max_retry;
+}
+
+void rpc_client::add_request( uint64_t id, rpc_request *rptr, unsigned retry )
+{
+  id_ent& ent = itab_[id];
+  if ( ent.rvec_.empty() ) {
+    ent.midx_  = get_method( typeid( *rptr ) );
+    ent.retry_ = retry;
+  }
+  ent.rvec_.push_back( rptr );
+  mvec_[ent.midx_].num_++;
+  num_++;
+}
+
+void rpc_client::del_request( uint64_t id, int64_t hold_ts )
+{
+  // move requests out for dispatch and release id for reuse, after
+  // hold_ts if given
+  id_ent& ent = itab_[id];
+  mvec_[ent.midx_].num_ -= ent.rvec_.size();
+  num_ -= ent.rvec_.size();
+  dvec_.swap( ent.rvec_ );
+  if ( hold_ts ) {
+    hold_.push_back( { id, hold_ts } );
+  } else {
+    reuse_.push_back( id );
+  }
+}
+
+void rpc_client::on_timeout( rpc_request *rptr )
+{
+  // fail request through its error reply path
+  static const std::string txt = "{\"error\":{\"code\":" +
+    std::to_string( PC_RPC_ERROR_TIMEOUT ) +
+    ",\"message\":\"rpc request timed out\"}}";
+  jp_.parse( txt.c_str(), txt.size() );
+  rptr->response( jp_ );
+}
+
+void rpc_client::poll( int64_t now )
+{
+  if ( sp_ && sp_->get_depth() ) {
+    poll_sign();
   }
+  if ( now - scan_ts_ < PC_RPC_SCAN_INTERVAL ) {
+    return;
+  }
+  scan_ts_ = now;
+
+  // release timed out ids once late replies to them are unlikely
+  size_t j = 0;
+  for( const hold_ent& hent: hold_ ) {
+    if ( now >= hent.ts_ ) {
+      reuse_.push_back( hent.id_ );
+    } else {
+      hold_[j++] = hent;
+    }
+  }
+  hold_.resize( j );
+
+  for( uint64_t id = 1; id < itab_.size(); ++id ) {
+    id_ent& ent = itab_[id];
+    if ( ent.rvec_.empty() ) {
+      continue;
+    }
+    method_ent& ment = mvec_[ent.midx_];
+    rpc_request *rptr = ent.rvec_[0];
+    if ( !ment.timeout_ ||
+         now - rptr->get_sent_time() < ( ment.timeout_ << ent.retry_ ) ) {
+      continue;
+    }
+    unsigned retry = ent.retry_;
+    del_request( id, now + ( ment.timeout_ << retry ) );
+    for( rpc_request *dptr: dvec_ ) {
+      if ( dptr->get_id() != id ) {
+        // already resent with another id
+        continue;
+      }
+      if ( retry < ment.max_retry_ && dvec_.size() == 1 ) {
+        ment.num_retry_++;
+        send( dptr, retry + 1 );
+      } else {
+        ment.num_timeout_++;
+        PC_LOG_WRN( "rpc_timeout" )
+          .add( "method", ment.name_ )
+          .add( "id", id )
+          .add( "age(ms)", 1e-6*( now - dptr->get_sent_time() ) )
+          .end();
+        on_timeout( dptr );
+      }
+    }
+    dvec_.clear();
+  }
+}
+
+void rpc_client::get_stats( stats_vec_t& res ) const
+{
+  res.clear();
+  for( const method_ent& ment: mvec_ ) {
+    method_stats st;
+    st.method_       = ment.name_;
+    st.num_inflight_ = ment.num_;
+    st.sent_ts_      = 0L;
+    st.num_reply_    = ment.num_reply_;
+    st.num_retry_    = ment.num_retry_;
+    st.num_timeout_  = ment.num_timeout_;
+    st.p50_          = ment.hist_.get_quantile( .5 );
+    st.p99_          = ment.hist_.get_quantile( .99 );
+    st.max_          = ment.hist_.get_max();
+    res.push_back( st );
+  }
+  for( const id_ent& ent: itab_ ) {
+    if ( !ent.rvec_.empty() ) {
+      method_stats& st = res[ent.midx_];
+      int64_t ts = ent.rvec_[0]->get_sent_time();
+      if ( !st.sent_ts_ || ts < st.sent_ts_ ) {
+        st.sent_ts_ = ts;
+      }
+    }
+  }
+}
+
+uint64_t rpc_client::get_num_inflight() const
+{
+  return num_;
+}
+
+void rpc_client::send( rpc_request *rptr )
+{
+  send( rptr, 0 );
+}
+
+void rpc_client::send( rpc_request *rptr, unsigned retry )
+{
+  // get request id
+  uint64_t id = get_id();
   rptr->set_id( id );
   rptr->set_rpc_client( this );
   rptr->set_sent_time( get_now() );
-  rv_.emplace( id, rptr );
+  add_request( id, rptr, retry );
 
   // construct json message
   json_wtr jw;
@@ -190,32 +451,102 @@ void rpc_client::send( rpc::upd_price *upds[], const unsigned n, unsigned cu_uni
     return;
   }
 
-  // get request id
-  uint64_t id;
-  if ( !reuse_.empty() ) {
-    id = reuse_.back();
-    reuse_.pop_back();
-  } else {
-    id = ++id_;
+  // drop the batch rather than reorder it if the signing workers fall
+  // behind
+  if ( sp_ && sp_->get_is_full() ) {
+    PC_LOG_WRN( "sign_queue_full" )
+      .add( "depth", sp_->get_depth() )
+      .add( "num_upd", n )
+      .end();
+    return;
   }
+
+  // get request id
+  uint64_t id = get_id();
   const auto now = get_now();
   for ( unsigned i = 0; i < n; ++i ) {
     rpc_request *const rptr = upds[ i ];
     rptr->set_id( id );
     rptr->set_rpc_client( this );
     rptr->set_sent_time( now );
-    rv_.emplace( id, rptr );
+    add_request( id, rptr, 0 );
+  }
+
+  // hand unsigned transaction to the signing workers
+  net_buf *bptr = net_buf::alloc();
+  bincode tx( bptr->buf_ );
+  rpc::upd_price_layout lay;
+  tc_.build_unsigned_tx( tx, upds, n, cu_units, cu_price, lay );
+  if ( sp_ ) {
+    sign_pipeline::job jb;
+    jb.buf_ = bptr;
+    jb.sig_ = lay.sig_idx_;
+    jb.msg_ = lay.msg_idx_;
+    jb.len_ = tx.size();
+    jb.key_ = upds[0]->get_pubcache();
+    jb.id_  = id;
+    jb.gen_ = gen_;
+    sp_->submit( jb );
+    return;
   }
 
+  // sign transaction inline
+  tx.sign( lay.sig_idx_, lay.msg_idx_, *upds[0]->get_pubcache() );
+  signature sig;
+  sig.init_from_buf( (const uint8_t*)&tx.get_buf()[lay.sig_idx_] );
+  send_tx( id, str( tx.get_buf(), tx.size() ), upds[0]->get_is_http() );
+  bptr->dealloc();
+  for ( unsigned i = 0; i < n; ++i ) {
+    on_sign( upds[i], sig );
+  }
+}
+
+void rpc_client::on_sign( rpc::upd_price *upd, const signature& sig )
+{
+  // every update in a batch shares the transaction signature
+  *upd->get_signature() = sig;
+  rpc_sign_sub *sub = dynamic_cast<rpc_sign_sub*>( upd->get_sub() );
+  if ( sub ) {
+    sub->on_sign( upd );
+  }
+}
+
+void rpc_client::poll_sign()
+{
+  sign_pipeline::job jb;
+  while( sp_->pop( jb ) ) {
+    // drop transactions whose requests were abandoned by a reset
+    if ( jb.gen_ != gen_ || jb.id_ >= itab_.size() ||
+         itab_[jb.id_].rvec_.empty() ) {
+      jb.buf_->dealloc();
+      continue;
+    }
+    signature sig;
+    sig.init_from_buf( (const uint8_t*)&jb.buf_->buf_[jb.sig_] );
+    rpc_request *first = itab_[jb.id_].rvec_[0];
+    send_tx( jb.id_, str( jb.buf_->buf_, jb.len_ ), first->get_is_http() );
+    jb.buf_->dealloc();
+
+    // subscribers may send further requests while being notified
+    dvec_ = itab_[jb.id_].rvec_;
+    for( rpc_request *rptr: dvec_ ) {
+      on_sign( static_cast<rpc::upd_price*>( rptr ), sig );
+    }
+    dvec_.clear();
+  }
+}
+
+void rpc_client::send_tx( uint64_t id, str txt, bool is_http )
+{
   // construct json message
   json_wtr jw;
   jw.add_val( json_wtr::e_obj );
   jw.add_key( "jsonrpc", "2.0" );
   jw.add_key( "id", id );
-  rpc::upd_price::request( jw, upds, n, cu_units, cu_price );
+  rpc::upd_price::request( jw, txt );
   jw.pop();
 //  jw.print();
-  if ( upds[ 0 ]->get_is_http() ) {
+  if ( is_http ) {
     // submit http POST request
     http_request msg;
     msg.init( "POST", "/" );
@@ -232,6 +563,45 @@ void rpc_client::send( rpc::upd_price *upds[], const unsigned n, unsigned cu_uni
   else {
     PC_LOG_WRN( "no ws connection to send msg" ).end();
   }
+
+  // hedge the same signed transaction across the other endpoints
+  for( tcp_connect *cptr: hvec_ ) {
+    if ( cptr->get_is_err() || cptr->get_is_wait() ) {
+      continue;
+    }
+    json_wtr hw;
+    hw.add_val( json_wtr::e_obj );
+    hw.add_key( "jsonrpc", "2.0" );
+    hw.add_key( "id", 0UL );
+    rpc::upd_price::request( hw, txt );
+    hw.pop();
+    http_request msg;
+    msg.init( "POST", "/" );
+    msg.add_hdr( "Host", cptr->get_host() );
+    msg.add_hdr( "Content-Type", "application/json" );
+    msg.commit( hw );
+    cptr->add_send( msg );
+  }
+}
+
+void rpc_client::set_sign_pipeline( sign_pipeline *sp )
+{
+  sp_ = sp;
+}
+
+sign_pipeline *rpc_client::get_sign_pipeline() const
+{
+  return sp_;
+}
+
+void rpc_client::add_hedge_conn( tcp_connect *cptr )
+{
+  hvec_.push_back( cptr );
+}
+
+void rpc_client::clear_hedge_conn()
+{
+  hvec_.clear();
 }
 
 void rpc_client::rpc_http::parse_content( const char *txt, size_t len )
@@ -244,25 +614,42 @@ void rpc_client::rpc_ws::parse_msg( const char *txt, size_t len )
   cp_->parse_response( txt, len );
 }
 
+// cached paths into rpc responses and notifications. all rpc handling
+// happens on the manager thread but keep one copy per thread regardless
+static thread_local jpath p_id{ "id" };
+static thread_local jpath p_sub_id{ "params", "subscription" };
+static thread_local jpath p_result{ "result" };
+static thread_local jpath p_notify_result{ "params", "result" };
+static thread_local jpath p_slot{ "context", "slot" };
+static thread_local jpath p_value{ "value" };
+static thread_local jpath p_pubkey{ "pubkey" };
+static thread_local jpath p_account{ "account" };
+static thread_local jpath p_data{ "data" };
+static thread_local jpath p_lamports{ "lamports" };
+
 void rpc_client::parse_response( const char *txt, size_t len )
 {
   // parse and redirect response to corresponding request
   jp_.parse( txt, len );
-  uint32_t idtok = jp_.find_val( 1, "id" );
+  uint32_t idtok = jp_.find_val( 1, p_id );
   if ( idtok ) {
     // response to http request
     const uint64_t id = jp_.get_uint( idtok );
-    const auto range = rv_.equal_range( id );
-    for ( auto it = range.first; it != range.second; ++it ) {
-      rpc_request *const rptr = it->second;
+    if ( id >= itab_.size() || itab_[id].rvec_.empty() ) {
+      return;
+    }
+    // release id before the callbacks as they may send new requests
+    method_ent& ment = mvec_[itab_[id].midx_];
+    del_request( id, 0L );
+    ment.num_reply_ += dvec_.size();
+    ment.hist_.add( get_now() - dvec_[0]->get_sent_time() );
+    for ( rpc_request *rptr: dvec_ ) {
       rptr->response( jp_ );
     }
-    reuse_.push_back( id );
-    rv_.erase( range.first, range.second );
+    dvec_.clear();
   } else {
     // websocket notification
-    uint32_t ptok = jp_.find_val( 1, "params" );
-    uint32_t stok = jp_.find_val( ptok, "subscription" );
+    uint32_t stok = jp_.find_val( 1, p_sub_id );
     if ( stok ) {
       uint64_t id = jp_.get_uint( stok );
       sub_map_t::iter_t i = smap_.find( id );
@@ -286,27 +673,81 @@ void rpc_client::remove_notify( rpc_request *rptr )
   }
 }
 
-size_t rpc_client::get_data_ref(
-    const char *dptr, size_t dlen, size_t tlen, char *&ptr )
+// base64 characters decoded per step of the base64 -> zstd pipeline.
+// large enough that price and product accounts decode in a single step
+#define PC_RPC_B64_BLOCK 8192UL
+
+// decode base64 text straight into tgt, truncating to tlen bytes
+static size_t dec_base64_into(
+    const char *dptr, size_t dlen, size_t tlen, uint8_t *tgt )
+{
+  size_t len = std::min( dlen, tlen / 3 * 4 );
+  size_t res = dec_base64( dptr, (int)len, tgt );
+  if ( len < dlen && res < tlen ) {
+    // bounce the one group straddling the end of tgt
+    uint8_t tmp[3];
+    size_t num = dec_base64( &dptr[len], (int)std::min( dlen-len, 4UL ), tmp );
+    num = std::min( num, tlen - res );
+    __builtin_memcpy( &tgt[res], tmp, num );
+    res += num;
+  }
+  return res;
+}
+
+size_t rpc_client::get_data(
+    const char *dptr, size_t dlen, bool is_zstd, size_t tlen, char *tgt )
 {
-  tlen = ZSTD_compressBound( tlen );
-  abuf_.resize( dlen );
-  zbuf_.resize( tlen );
+  if ( !is_zstd ) {
+    return dec_base64_into( dptr, dlen, tlen, (uint8_t*)tgt );
+  }
+
+  // base64 decode one block at a time into a stack buffer that zstd
+  // consumes while it is still in cache
+  uint8_t blk[PC_RPC_B64_BLOCK/4*3];
   ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
-  dlen = dec_base64( dptr, dlen, (uint8_t*)&abuf_[0] );
-  tlen = ZSTD_decompressDCtx( cxt, &zbuf_[0], tlen, &abuf_[0], dlen );
+  if ( dlen <= PC_RPC_B64_BLOCK ) {
+    size_t blen = dec_base64( dptr, (int)dlen, blk );
+    size_t res = ZSTD_decompressDCtx( cxt, tgt, tlen, blk, blen );
+    return ZSTD_isError( res ) ? 0 : res;
+  }
+  ZSTD_DCtx_reset( cxt, ZSTD_reset_session_only );
+  ZSTD_outBuffer out = { tgt, tlen, 0 };
+  ZSTD_inBuffer in = { blk, 0, 0 };
+  for( size_t i = 0; ; ) {
+    if ( in.pos == in.size ) {
+      size_t len = std::min( dlen - i, PC_RPC_B64_BLOCK );
+      in.size = dec_base64( &dptr[i], (int)len, blk );
+      in.pos  = 0;
+      i += len;
+    }
+    size_t pos = out.pos;
+    size_t res = ZSTD_decompressStream( cxt, &out, &in );
+    if ( ZSTD_isError( res ) ) {
+      return 0;
+    }
+    if ( res == 0 || out.pos == out.size ) {
+      break;
+    }
+    if ( i == dlen && in.pos == in.size && out.pos == pos ) {
+      // truncated frame
+      return 0;
+    }
+  }
+  return out.pos;
+}
+
+size_t rpc_client::get_data_ref(
+    const char *dptr, size_t dlen, bool is_zstd, size_t tlen, char *&ptr )
+{
+  zbuf_.resize( ZSTD_compressBound( tlen ) );
   ptr = &zbuf_[0];
-  return tlen;
+  return get_data( dptr, dlen, is_zstd, zbuf_.size(), ptr );
 }
 
 size_t rpc_client::get_data_val(
-    const char *dptr, size_t dlen, size_t tlen, char *tgt )
+    const char *dptr, size_t dlen, bool is_zstd, size_t tlen, char *tgt )
 {
-  abuf_.resize( dlen );
-  ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
-  dlen = dec_base64( dptr, dlen, (uint8_t*)&abuf_[0] );
-  tlen = ZSTD_decompressDCtx( cxt, tgt, tlen, &abuf_[0], dlen );
-  return tlen;
+  return get_data( dptr, dlen, is_zstd, tlen, tgt );
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -318,7 +759,8 @@ rpc_request::rpc_request()
   id_( 0UL ),
   ec_( 0 ),
   sent_ts_( 0L ),
-  recv_ts_( 0L )
+  recv_ts_( 0L ),
+  gen_( 0UL )
 {
 }
 
@@ -369,6 +811,7 @@ int rpc_request::get_err_code() const
 void rpc_request::set_sent_time( int64_t sent_ts )
 {
   sent_ts_ = sent_ts;
+  gen_ = cp_ ? cp_->get_gen() : 0UL;
 }
 
 int64_t rpc_request::get_sent_time() const
@@ -388,7 +831,7 @@ int64_t rpc_request::get_recv_time() const
 
 bool rpc_request::get_is_recv() const
 {
-  return recv_ts_ >= sent_ts_;
+  return recv_ts_ >= sent_ts_ || ( cp_ && gen_ != cp_->get_gen() );
 }
 
 bool rpc_request::get_is_http() const
@@ -434,7 +877,8 @@ void rpc_request::on_response( T *req )
 template<class T>
 bool rpc_request::on_error( const jtree& jt, T *req )
 {
-  uint32_t etok = jt.find_val( 1, "error" );
+  static const jkey k_error( "error" );
+  uint32_t etok = jt.find_val( 1, k_error );
   if ( etok == 0 ) return false;
   const char *txt = nullptr;
   size_t txt_len = 0;
@@ -525,6 +969,41 @@ void rpc::get_slot::response( const jtree& jt )
   on_response( this );
 }
 
+///////////////////////////////////////////////////////////////////////////
+// slot_subscribe
+
+rpc::slot_subscribe::slot_subscribe()
+: slot_( 0UL )
+{
+}
+
+uint64_t rpc::slot_subscribe::get_slot() const
+{
+  return slot_;
+}
+
+void rpc::slot_subscribe::request( json_wtr& msg )
+{
+  msg.add_key( "method", "slotSubscribe" );
+}
+
+void rpc::slot_subscribe::response( const jtree& jt )
+{
+  if ( on_error( jt, this ) ) return;
+  // add to notification list
+  add_notify( jt );
+}
+
+bool rpc::slot_subscribe::notify( const jtree& jt )
+{
+  if ( on_error( jt, this ) ) return true;
+  uint32_t ptok = jt.find_val( 1, "params" );
+  uint32_t rtok = jt.find_val( ptok, "result" );
+  slot_ = jt.get_uint( jt.find_val( rtok, "slot" ) );
+  on_response( this );
+  return false; // keep notification
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // account_update
 
@@ -534,8 +1013,18 @@ rpc::account_update::account_update()
   slot_{ 0UL },
   lamports_{ 0UL },
   dlen_{ 0UL },
-  dptr_{ nullptr }
+  dptr_{ nullptr },
+  is_zstd_{ true }
+{
+}
+
+void rpc::account_update::set_data( const jtree& jt, uint32_t dtok )
 {
+  // data is [ "<text>", "<encoding>" ]
+  uint32_t ttok = jt.get_first( dtok );
+  jt.get_text( ttok, dptr_, dlen_ );
+  uint32_t etok = jt.get_next( ttok );
+  is_zstd_ = !etok || jt.get_str( etok ) != "base64";
 }
 
 pub_key const* rpc::account_update::get_account() const
@@ -606,14 +1095,13 @@ void rpc::get_account_info::request( json_wtr& msg )
 void rpc::get_account_info::response( const jtree& jt )
 {
   if ( on_error( jt, this ) ) return;
-  uint32_t rtok = jt.find_val( 1, "result" );
-  uint32_t ctok = jt.find_val( rtok, "context" );
-  slot_ = jt.get_uint( jt.find_val( ctok, "slot" ) );
-  uint32_t vtok = jt.find_val( rtok, "value" );
+  uint32_t rtok = jt.find_val( 1, p_result );
+  slot_ = jt.get_uint( jt.find_val( rtok, p_slot ) );
+  uint32_t vtok = jt.find_val( rtok, p_value );
   is_exec_ = jt.get_bool( jt.find_val( vtok, "executable" ) );
-  lamports_ = jt.get_uint( jt.find_val( vtok, "lamports" ) );
-  uint32_t dtok = jt.find_val( vtok, "data" );
-  jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
+  lamports_ = jt.get_uint( jt.find_val( vtok, p_lamports ) );
+  uint32_t dtok = jt.find_val( vtok, p_data );
+  set_data( jt, dtok );
   jt.get_text( jt.find_val( vtok, "owner" ), optr_, olen_ );
   rent_epoch_ = jt.get_uint( jt.find_val( vtok, "rentEpoch" ) );
   on_response( this );
@@ -624,6 +1112,110 @@ bool rpc::get_account_info::get_is_http() const
   return true;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// get_multiple_accounts
+
+rpc::get_multiple_accounts::get_multiple_accounts()
+: account_update{},
+  soff_( 0UL ),
+  slen_( 0UL )
+{
+  kvec_.reserve( max_accounts );
+}
+
+void rpc::get_multiple_accounts::add_account( const pub_key& acc )
+{
+  kvec_.push_back( acc );
+}
+
+void rpc::get_multiple_accounts::clear_accounts()
+{
+  kvec_.clear();
+}
+
+size_t rpc::get_multiple_accounts::get_num_accounts() const
+{
+  return kvec_.size();
+}
+
+const pub_key& rpc::get_multiple_accounts::get_request_account(
+    size_t i ) const
+{
+  return kvec_[i];
+}
+
+void rpc::get_multiple_accounts::set_data_slice( size_t offset, size_t len )
+{
+  soff_ = offset;
+  slen_ = len;
+}
+
+size_t rpc::get_multiple_accounts::get_data_slice_len() const
+{
+  return slen_;
+}
+
+void rpc::get_multiple_accounts::request( json_wtr& msg )
+{
+  msg.add_key( "method", "getMultipleAccounts" );
+  msg.add_key( "params", json_wtr::e_arr );
+  msg.add_val( json_wtr::e_arr );
+  for( const pub_key& acc: kvec_ ) {
+    msg.add_val( acc );
+  }
+  msg.pop();
+  msg.add_val( json_wtr::e_obj );
+  if ( slen_ ) {
+    // slices are too small to be worth compressing
+    msg.add_key( "encoding", "base64" );
+    msg.add_key( "dataSlice", json_wtr::e_obj );
+    msg.add_key( "offset", soff_ );
+    msg.add_key( "length", slen_ );
+    msg.pop();
+  } else {
+    msg.add_key( "encoding", "base64+zstd" );
+  }
+  msg.add_key( "commitment", commitment_to_str( cmt_ ) );
+  msg.pop();
+  msg.pop();
+}
+
+void rpc::get_multiple_accounts::response( const jtree& jt )
+{
+  if ( on_error( jt, this ) ) return;
+  uint32_t rtok = jt.find_val( 1, p_result );
+  slot_ = jt.get_uint( jt.find_val( rtok, p_slot ) );
+  uint32_t vtok = jt.find_val( rtok, p_value );
+  size_t i = 0;
+  for( uint32_t tok = jt.get_first( vtok );
+       tok && i != kvec_.size(); tok = jt.get_next( tok ), ++i ) {
+    acc_ = kvec_[i];
+    if ( jt.get_type( tok ) == jtree::e_obj ) {
+      lamports_ = jt.get_uint( jt.find_val( tok, p_lamports ) );
+      set_data( jt, jt.find_val( tok, p_data ) );
+    } else {
+      // account does not exist
+      lamports_ = 0UL;
+      dptr_ = nullptr;
+      dlen_ = 0UL;
+      set_err_msg( "account not found" );
+      set_err_code( PC_RPC_ERROR_NOT_FOUND );
+    }
+    on_response( this );
+    reset_err();
+    set_err_code( 0 );
+  }
+  if ( i == 0 ) {
+    // nothing to dispatch but the request is complete
+    set_recv_time( get_now() );
+  }
+}
+
+bool rpc::get_multiple_accounts::get_is_http() const
+{
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // account_subscribe
 
@@ -660,14 +1252,12 @@ bool rpc::account_subscribe::notify( const jtree& jt )
 
   if ( on_error( jt, this_t ) ) return true;
 
-  uint32_t ptok = jt.find_val( 1, "params" );
-  uint32_t rtok = jt.find_val( ptok, "result" );
-  uint32_t ctok = jt.find_val( rtok, "context" );
-  slot_ = jt.get_uint( jt.find_val( ctok, "slot" ) );
-  uint32_t vtok = jt.find_val( rtok, "value" );
-  uint32_t dtok = jt.find_val( vtok, "data" );
-  jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
-  lamports_ = jt.get_uint( jt.find_val( vtok, "lamports" ) );
+  uint32_t rtok = jt.find_val( 1, p_notify_result );
+  slot_ = jt.get_uint( jt.find_val( rtok, p_slot ) );
+  uint32_t vtok = jt.find_val( rtok, p_value );
+  uint32_t dtok = jt.find_val( vtok, p_data );
+  set_data( jt, dtok );
+  lamports_ = jt.get_uint( jt.find_val( vtok, p_lamports ) );
 
   on_response( this_t );
   return false;  // keep notification
@@ -679,6 +1269,9 @@ bool rpc::account_subscribe::notify( const jtree& jt )
 rpc::program_subscribe::program_subscribe()
 : account_update{}
 , pgm_{ nullptr }
+, is_coalesce_{ false }
+, num_stale_{ 0UL }
+, num_coalesce_{ 0UL }
 {
 }
 
@@ -687,6 +1280,62 @@ void rpc::program_subscribe::set_program( pub_key *pkey )
   pgm_ = pkey;
 }
 
+void rpc::program_subscribe::set_coalesce( bool is_coalesce )
+{
+  is_coalesce_ = is_coalesce;
+}
+
+bool rpc::program_subscribe::get_coalesce() const
+{
+  return is_coalesce_;
+}
+
+uint64_t rpc::program_subscribe::get_num_stale() const
+{
+  return num_stale_;
+}
+
+uint64_t rpc::program_subscribe::get_num_coalesce() const
+{
+  return num_coalesce_;
+}
+
+rpc::program_subscribe::acc_state&
+rpc::program_subscribe::get_state( const pub_key& akey )
+{
+  acc_map_t::iter_t it = amap_.find( akey );
+  if ( it ) {
+    return avec_[amap_.obj( it )];
+  }
+  amap_.ref( amap_.add( akey ) ) = (uint32_t)avec_.size();
+  avec_.emplace_back();
+  acc_state& st = avec_.back();
+  st.acc_      = akey;
+  st.slot_     = 0UL;
+  st.lamports_ = 0UL;
+  st.is_pend_  = false;
+  st.is_zstd_  = true;
+  return st;
+}
+
+void rpc::program_subscribe::flush()
+{
+  auto* const this_t = static_cast< account_update* >( this );
+
+  for( uint32_t idx: pvec_ ) {
+    acc_state& st = avec_[idx];
+    st.is_pend_ = false;
+    acc_      = st.acc_;
+    slot_     = st.slot_;
+    lamports_ = st.lamports_;
+    dptr_     = st.data_.data();
+    dlen_     = st.data_.size();
+    is_zstd_  = st.is_zstd_;
+    on_response( this_t );
+  }
+  pvec_.clear();
+}
+
 void rpc::program_subscribe::request( json_wtr& msg )
 {
   msg.add_key( "method", "programSubscribe" );
@@ -715,19 +1364,43 @@ bool rpc::program_subscribe::notify( const jtree& jt )
 
   if ( on_error( jt, this_t ) ) return true;
 
-  uint32_t ptok = jt.find_val( 1, "params" );
-  uint32_t rtok = jt.find_val( ptok, "result" );
-  uint32_t ctok = jt.find_val( rtok, "context" );
-  slot_ = jt.get_uint( jt.find_val( ctok, "slot" ) );
-  uint32_t vtok = jt.find_val( rtok, "value" );
-  str akey = jt.get_str( jt.find_val( vtok, "pubkey" ) );
+  uint32_t rtok = jt.find_val( 1, p_notify_result );
+  uint64_t slot = jt.get_uint( jt.find_val( rtok, p_slot ) );
+  uint32_t vtok = jt.find_val( rtok, p_value );
+  str akey = jt.get_str( jt.find_val( vtok, p_pubkey ) );
   acc_.init_from_text( akey );
-  uint32_t atok = jt.find_val( vtok, "account" );
-  uint32_t dtok = jt.find_val( atok, "data" );
-  jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
-  lamports_ = jt.get_uint( jt.find_val( atok, "lamports" ) );
 
-  on_response( this_t );
+  // drop out-of-order or repeated updates before decoding anything.
+  // processed commitment may legitimately update an account several
+  // times in the same slot
+  acc_state& st = get_state( acc_ );
+  if ( slot < st.slot_ || (
+        slot == st.slot_ && cmt_ != commitment::e_processed ) ) {
+    ++num_stale_;
+    return false;
+  }
+  st.slot_ = slot;
+
+  uint32_t atok = jt.find_val( vtok, p_account );
+  uint32_t dtok = jt.find_val( atok, p_data );
+  set_data( jt, dtok );
+  slot_ = slot;
+  lamports_ = jt.get_uint( jt.find_val( atok, p_lamports ) );
+  if ( !is_coalesce_ ) {
+    on_response( this_t );
+    return false;  // keep notification
+  }
+
+  // hold a copy of the still-encoded data until flush
+  if ( st.is_pend_ ) {
+    ++num_coalesce_;
+  } else {
+    st.is_pend_ = true;
+    pvec_.push_back( (uint32_t)( &st - &avec_[0] ) );
+  }
+  st.lamports_ = lamports_;
+  st.is_zstd_  = is_zstd_;
+  st.data_.assign( dptr_, dlen_ );
   return false;  // keep notification
 }
 
@@ -780,17 +1453,16 @@ void rpc::get_program_accounts::response( const jtree& jt )
   auto* const this_t = static_cast< account_update* >( this );
 
   if ( on_error( jt, this_t ) ) return;
-  uint32_t const rtok = jt.find_val( 1, "result" );
-  uint32_t const ctok = jt.find_val( rtok, "context" );
-  slot_ = jt.get_uint( jt.find_val( ctok, "slot" ) );
-  uint32_t const vtok = jt.find_val( rtok, "value" );
+  uint32_t const rtok = jt.find_val( 1, p_result );
+  slot_ = jt.get_uint( jt.find_val( rtok, p_slot ) );
+  uint32_t const vtok = jt.find_val( rtok, p_value );
   for ( uint32_t tok = jt.get_first( vtok ); tok; tok = jt.get_next( tok ) ) {
-    str akey = jt.get_str( jt.find_val( tok, "pubkey" ) );
+    str akey = jt.get_str( jt.find_val( tok, p_pubkey ) );
     acc_.init_from_text( akey );
-    uint32_t const atok = jt.find_val( tok, "account" );
-    lamports_ = jt.get_uint( jt.find_val( atok, "lamports" ) );
-    uint32_t dtok = jt.find_val( atok, "data" );
-    jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
+    uint32_t const atok = jt.find_val( tok, p_account );
+    lamports_ = jt.get_uint( jt.find_val( atok, p_lamports ) );
+    uint32_t dtok = jt.find_val( atok, p_data );
+    set_data( jt, dtok );
 
     on_response( this_t );
   }
@@ -828,6 +1500,11 @@ void rpc::upd_price::set_pubcache( key_cache *pk )
   ckey_ = pk;
 }
 
+key_cache *rpc::upd_price::get_pubcache() const
+{
+  return ckey_;
+}
+
 void rpc::upd_price::set_account( pub_key *akey )
 {
   akey_ = akey;
@@ -899,6 +1576,28 @@ bool rpc::upd_price::build_tx(
   unsigned cu_units,
   unsigned cu_price
 )
+{
+  upd_price_layout lay;
+  if ( ! build_unsigned_tx( tx, upds, n, cu_units, cu_price, lay ) ) {
+    return false;
+  }
+
+  // all accounts need to sign transaction
+  auto& first = *upds[ 0 ];
+  tx.sign( lay.sig_idx_, lay.msg_idx_, *first.ckey_ );
+  first.sig_.init_from_buf( (const uint8_t*)(tx.get_buf() + lay.sig_idx_) );
+
+  return true;
+}
+
+bool rpc::upd_price::build_unsigned_tx(
+  bincode& tx,
+  upd_price* upds[],
+  const unsigned n,
+  unsigned cu_units,
+  unsigned cu_price,
+  upd_price_layout& lay
+)
 {
   if ( ! n ) {
     return false;
@@ -906,10 +1605,10 @@ bool rpc::upd_price::build_tx(
 
   // signatures section
   tx.add_len< 1 >(); // one signature (publish)
-  size_t pub_idx = tx.reserve_sign();
+  lay.sig_idx_ = tx.reserve_sign();
 
   // message header
-  size_t tx_idx = tx.get_pos();
+  lay.msg_idx_ = tx.get_pos();
   tx.add( (uint8_t)1 ); // pub is only signing account
   tx.add( (uint8_t)0 ); // read-only signed accounts
   tx.add( (uint8_t)2 ); // sysvar and program-id are read-only
@@ -919,6 +1618,7 @@ bool rpc::upd_price::build_tx(
 
   // accounts
   tx.add_len( n + 4 ); // n + 4 accounts: publish, symbol{n}, sysvar, pyth program, compute budget program
+  lay.acc_idx_ = tx.get_pos();
   tx.add( *first.pkey_ ); // publish account
   for ( unsigned i = 0; i < n; ++i ) {
     tx.add( *upds[ i ]->akey_ ); // symbol account
@@ -928,6 +1628,7 @@ bool rpc::upd_price::build_tx(
   tx.add( *(pub_key*)compute_budget_program_id ); // compute budget program id
 
   // recent block hash
+  lay.hash_idx_ = tx.get_pos();
   tx.add( *first.bhash_ ); // recent block hash
 
   // instructions section
@@ -960,6 +1661,7 @@ bool rpc::upd_price::build_tx(
     tx.add( (uint64_t) cu_price ); // price we are willing to pay per compute unit in Micro Lamports
   }
 
+  size_t ins_idx = tx.get_pos();
   for ( unsigned i = 0; i < n; ++i ) {
     tx.add( (uint8_t)( n + 2 ) ); // program_id index
     tx.add_len< 3 >(); // 3 accounts: publish, symbol, sysvar
@@ -967,23 +1669,126 @@ bool rpc::upd_price::build_tx(
     tx.add( (uint8_t)( i + 1 ) ); // index of symbol account
     tx.add( (uint8_t)( n + 1 ) ); // index of sysvar account
 
-    auto const& upd = *upds[ i ];
-
     // instruction parameter section
     tx.add_len<sizeof(cmd_upd_price)>();
-    tx.add( (uint32_t)PC_VERSION );
-    tx.add( (int32_t)( upd.cmd_ ) );
-    tx.add( (int32_t)( upd.st_ ) );
-    tx.add( (int32_t)0 );
-    tx.add( upd.price_ );
-    tx.add( upd.conf_ );
-    tx.add( upd.pub_slot_ );
+    if ( i == 0 ) {
+      lay.upd_idx_ = tx.get_pos();
+    }
+    upds[ i ]->add_params( tx );
   }
+  lay.upd_len_ = ( tx.get_pos() - ins_idx ) / n;
 
-  // all accounts need to sign transaction
-  tx.sign( pub_idx, tx_idx, *first.ckey_ );
-  first.sig_.init_from_buf( (const uint8_t*)(tx.get_buf() + pub_idx) );
+  return true;
+}
+
+void rpc::upd_price::add_params( bincode& tx ) const
+{
+  tx.add( (uint32_t)PC_VERSION );
+  tx.add( (int32_t)( cmd_ ) );
+  tx.add( (int32_t)( st_ ) );
+  tx.add( (int32_t)0 );
+  tx.add( price_ );
+  tx.add( conf_ );
+  tx.add( pub_slot_ );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// upd_price_cache
+
+rpc::upd_price_cache::upd_price_cache()
+: num_hit_( 0UL ),
+  num_miss_( 0UL )
+{
+}
+
+bool rpc::upd_price_cache::build_unsigned_tx(
+  bincode& tx,
+  upd_price* upds[],
+  const unsigned n,
+  unsigned cu_units,
+  unsigned cu_price,
+  upd_price_layout& lay
+)
+{
+  if ( ! n ) {
+    return false;
+  }
+  if ( evec_.empty() ) {
+    evec_.resize( PC_TX_CACHE_SIZE );
+    for( entry& ent: evec_ ) {
+      ent.len_ = 0;
+      ent.lay_ = upd_price_layout();
+    }
+  }
+
+  // key on the leading bytes of every account in order
+  auto& first = *upds[ 0 ];
+  const uint8_t *pub = first.pkey_->data() + pub_key::len;
+  uint64_t key = n ^ ( (uint64_t)cu_units << 16 ) ^
+    ( (uint64_t)cu_price << 40 );
+  uint64_t val;
+  __builtin_memcpy( &val, pub, sizeof( val ) );
+  key = ( key ^ val ) * 0x9e3779b97f4a7c15UL;
+  __builtin_memcpy( &val, first.gkey_->data(), sizeof( val ) );
+  key = ( key ^ val ) * 0x9e3779b97f4a7c15UL;
+  for ( unsigned i = 0; i < n; ++i ) {
+    __builtin_memcpy( &val, upds[ i ]->akey_->data(), sizeof( val ) );
+    key = ( key ^ val ) * 0x9e3779b97f4a7c15UL;
+  }
+  key ^= key >> 29;
+  entry& ent = evec_[ key % PC_TX_CACHE_SIZE ];
+
+  // hit only if every account matches the image
+  size_t base = tx.get_pos();
+  bool is_hit = ent.len_ && ent.key_ == key && ent.n_ == n &&
+    ent.cu_units_ == cu_units && ent.cu_price_ == cu_price;
+  const char *acc = &ent.buf_[ ent.lay_.acc_idx_ ];
+  is_hit = is_hit &&
+    0 == __builtin_memcmp( acc, pub, pub_key::len ) &&
+    0 == __builtin_memcmp( &acc[ ( n + 2 ) * pub_key::len ],
+                           first.gkey_->data(), pub_key::len );
+  for ( unsigned i = 0; is_hit && i < n; ++i ) {
+    is_hit = 0 == __builtin_memcmp( &acc[ ( i + 1 ) * pub_key::len ],
+                                    upds[ i ]->akey_->data(), pub_key::len );
+  }
+
+  if ( !is_hit ) {
+    ++num_miss_;
+    if ( ! upd_price::build_unsigned_tx(
+          tx, upds, n, cu_units, cu_price, lay ) ) {
+      return false;
+    }
+    ent.key_      = key;
+    ent.n_        = n;
+    ent.cu_units_ = cu_units;
+    ent.cu_price_ = cu_price;
+    ent.len_      = tx.get_pos() - base;
+    ent.lay_      = lay;
+    ent.lay_.sig_idx_  -= base;
+    ent.lay_.msg_idx_  -= base;
+    ent.lay_.acc_idx_  -= base;
+    ent.lay_.hash_idx_ -= base;
+    ent.lay_.upd_idx_  -= base;
+    __builtin_memcpy( ent.buf_, &tx.get_buf()[ base ], ent.len_ );
+    return true;
+  }
 
+  // copy image and patch what changes between batches
+  ++num_hit_;
+  __builtin_memcpy( tx.get_wtr(), ent.buf_, ent.len_ );
+  lay = ent.lay_;
+  lay.sig_idx_  += base;
+  lay.msg_idx_  += base;
+  lay.acc_idx_  += base;
+  lay.hash_idx_ += base;
+  lay.upd_idx_  += base;
+  tx.set_pos( lay.hash_idx_ );
+  tx.add( *first.bhash_ );
+  for ( unsigned i = 0; i < n; ++i ) {
+    tx.set_pos( lay.upd_idx_ + i * lay.upd_len_ );
+    upds[ i ]->add_params( tx );
+  }
+  tx.set_pos( base + ent.len_ );
   return true;
 }
 
@@ -1034,21 +1839,26 @@ bool rpc::upd_price::request(
   net_buf *bptr = net_buf::alloc();
   bincode tx( bptr->buf_ );
   if ( ! build_tx( tx, upds, n, cu_units, cu_price ) ) {
+    bptr->dealloc();
     return false;
   }
+  request( msg, str( tx.get_buf(), tx.size() ) );
+  bptr->dealloc();
+
+  return true;
+}
 
+void rpc::upd_price::request( json_wtr& msg, str tx )
+{
   // encode transaction and add to json params
   msg.add_key( "method", "sendTransaction" );
   msg.add_key( "params", json_wtr::e_arr );
-  msg.add_val_enc_base64( str( tx.get_buf(), tx.size() ) );
+  msg.add_val_enc_base64( tx );
   msg.add_val( json_wtr::e_obj );
   msg.add_key( "encoding", "base64" );
   msg.add_key( "skipPreflight", json_wtr::jtrue() );
   msg.pop();
   msg.pop();
-  bptr->dealloc();
-
-  return true;
 }
 
 void rpc::upd_price::response( const jtree& jt )
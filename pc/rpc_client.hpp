@@ -7,7 +7,7 @@
 #include <oracle/oracle.h>
 #include <pc/hash_map.hpp>
 
-#include <unordered_map>
+#include <typeinfo>
 
 #define PC_RPC_ERROR_BLOCK_CLEANED_UP          -32001
 #define PC_RPC_ERROR_SEND_TX_PREFLIGHT_FAIL    -32002
@@ -19,12 +19,19 @@
 #define PC_RPC_ERROR_NO_SNAPSHOT               -32008
 #define PC_RPC_ERROR_LONG_TERM_SLOT_SKIPPED    -32009
 
+// client side error: no reply before the request deadline
+#define PC_RPC_ERROR_TIMEOUT                   -32100
+
+// client side error: requested account does not exist
+#define PC_RPC_ERROR_NOT_FOUND                 -32101
+
 #define PC_TPU_PROTO_ID 0xb1ab
 
 namespace pc
 {
   class bincode;
   class rpc_request;
+  class sign_pipeline;
 
   // type of "price" calculation represented by account
   enum class price_type
@@ -67,8 +74,82 @@ namespace pc
   namespace rpc
   {
     class upd_price;
+
+    // offsets into an upd_price transaction image
+    struct upd_price_layout
+    {
+      size_t sig_idx_;  // signature
+      size_t msg_idx_;  // signed message
+      size_t acc_idx_;  // account keys (publish, symbol{n}, ...)
+      size_t hash_idx_; // recent block hash
+      size_t upd_idx_;  // first upd_price instruction parameters
+      size_t upd_len_;  // distance between upd_price instructions
+    };
+
+    // prebuilt upd_price transaction images keyed by publisher, ordered
+    // symbol accounts, program and compute budget. a hit copies the image
+    // and patches only the block hash and the upd_price parameters
+    class upd_price_cache
+    {
+    public:
+      upd_price_cache();
+
+      // same as upd_price::build_unsigned_tx
+      bool build_unsigned_tx( bincode&, upd_price*[], unsigned n,
+                              unsigned cu_units, unsigned cu_price,
+                              upd_price_layout& );
+
+      uint64_t get_num_hit() const;
+      uint64_t get_num_miss() const;
+
+    private:
+      struct entry {
+        uint64_t         key_;      // hash of accounts and budget
+        unsigned         n_;
+        unsigned         cu_units_;
+        unsigned         cu_price_;
+        size_t           len_;      // image length or zero if unused
+        upd_price_layout lay_;      // offsets relative to image
+        char             buf_[net_buf::len];
+      };
+
+      typedef std::vector<entry> entry_vec_t;
+
+      entry_vec_t evec_;      // direct-mapped by key
+      uint64_t    num_hit_;
+      uint64_t    num_miss_;
+    };
+
+    inline uint64_t upd_price_cache::get_num_hit() const
+    {
+      return num_hit_;
+    }
+
+    inline uint64_t upd_price_cache::get_num_miss() const
+    {
+      return num_miss_;
+    }
   }
 
+  // log-linear histogram of latencies with four buckets per power of
+  // two microseconds (quantiles within 25%)
+  class latency_hist
+  {
+  public:
+    latency_hist();
+    void clear();
+    void add( int64_t ns );
+    uint64_t get_count() const;
+    int64_t get_max() const;
+    // upper bound of bucket containing quantile q in [0,1]
+    int64_t get_quantile( double q ) const;
+  private:
+    static const unsigned num_buckets = 128;
+    uint64_t cnt_;
+    int64_t  max_;
+    uint64_t hist_[num_buckets];
+  };
+
   // solana rpc REST API client
   class rpc_client : public error
   {
@@ -89,6 +170,31 @@ namespace pc
     void send( rpc_request * );
     void send( rpc::upd_price *[], unsigned n, unsigned cu_units, unsigned cu_price );
 
+    // extra http connections that upd_price transactions are also sent
+    // to. the copies carry request id zero so their replies are dropped
+    void add_hedge_conn( tcp_connect * );
+    void clear_hedge_conn();
+
+    // sign upd_price transactions on the pipeline's worker threads
+    // instead of inline in send. signed transactions are sent from poll
+    void set_sign_pipeline( sign_pipeline * );
+    sign_pipeline *get_sign_pipeline() const;
+
+    // templates that batched upd_price transactions are built from
+    const rpc::upd_price_cache& get_tx_cache() const;
+
+    // deadline for a reply to requests of type T. requests that time out
+    // are resent up to max_retry times doubling the deadline each time.
+    // after that they fail with PC_RPC_ERROR_TIMEOUT through the same
+    // callback as an error reply. ids of timed out requests are not
+    // reused for another deadline so that late replies are dropped.
+    // zero timeout means no deadline (default)
+    template<class T>
+    void set_timeout( int64_t timeout, unsigned max_retry );
+
+    // send signed transactions and expire requests past their deadline
+    void poll( int64_t now );
+
   public:
 
     // parse json payload and invoke callback
@@ -98,18 +204,41 @@ namespace pc
     void add_notify( rpc_request * );
     void remove_notify( rpc_request * );
 
-    // decode into internal buffer and return pointer
+    // decode base64 or base64+zstd account data into internal buffer
+    // and return pointer. returns decoded length or zero on error
     size_t get_data_ref(
-        const char *dptr, size_t dlen, size_t tlen, char*&ptr);
-    // decode into provided buffer
+        const char *dptr, size_t dlen, bool is_zstd, size_t tlen, char*&ptr);
+    // decode straight into provided buffer of tlen bytes
     size_t get_data_val(
-        const char *dptr, size_t dlen, size_t tlen, char*ptr);
+        const char *dptr, size_t dlen, bool is_zstd, size_t tlen, char*ptr);
 
-    // reset state
+    // reset state and abandon requests awaiting a reply
     void reset();
+    uint64_t get_gen() const;
+
+    // request statistics by request type
+    struct method_stats {
+      std::string method_;      // request class name
+      uint64_t    num_inflight_;// number awaiting a reply
+      int64_t     sent_ts_;     // send time of oldest or zero if none
+      uint64_t    num_reply_;   // replies received
+      uint64_t    num_retry_;   // requests resent after a timeout
+      uint64_t    num_timeout_; // requests given up on
+      int64_t     p50_;         // reply latency quantiles (nanoseconds)
+      int64_t     p99_;
+      int64_t     max_;
+    };
+    typedef std::vector<method_stats> stats_vec_t;
+    void get_stats( stats_vec_t& ) const;
+
+    // total requests awaiting a reply
+    uint64_t get_num_inflight() const;
 
   private:
 
+    size_t get_data(
+        const char *dptr, size_t dlen, bool is_zstd, size_t tlen, char *);
+
     struct rpc_http : public http_client {
       void parse_content( const char *, size_t ) override;
       rpc_client *cp_;
@@ -131,25 +260,82 @@ namespace pc
       };
     };
 
-    typedef std::unordered_multimap< uint64_t, rpc_request* > request_t;
+    // requests waiting on one id. ids are small and dense so they index
+    // a flat table directly and entries keep their capacity on reuse
+    typedef std::vector<rpc_request*> req_vec_t;
+    struct id_ent {
+      req_vec_t rvec_;  // requests sharing id (batched upd_price)
+      unsigned  midx_;  // index into method table
+      unsigned  retry_; // times resent after a timeout
+    };
+    struct hold_ent {
+      uint64_t id_;
+      int64_t  ts_;     // time id may be reused
+    };
+    struct method_ent {
+      const std::type_info *type_;
+      std::string           name_;
+      uint64_t              num_;
+      int64_t               timeout_;
+      unsigned              max_retry_;
+      uint64_t              num_reply_;
+      uint64_t              num_retry_;
+      uint64_t              num_timeout_;
+      latency_hist          hist_;
+    };
+
+    uint64_t get_id();
+    void send( rpc_request *, unsigned retry );
+    void send_tx( uint64_t id, str tx, bool is_http );
+    void poll_sign();
+    void on_sign( rpc::upd_price *, const signature& );
+    void add_request( uint64_t id, rpc_request *, unsigned retry );
+    void del_request( uint64_t id, int64_t hold_ts );
+    void on_timeout( rpc_request * );
+    unsigned get_method( const std::type_info& );
+    void set_timeout( const std::type_info&, int64_t, unsigned );
+
+    typedef std::vector<id_ent>       id_tab_t;
+    typedef std::vector<method_ent>   method_vec_t;
     typedef std::vector<uint64_t>     id_vec_t;
+    typedef std::vector<hold_ent>     hold_vec_t;
+    typedef std::vector<tcp_connect*> conn_vec_t;
     typedef std::vector<char>         acc_buf_t;
     typedef hash_map<trait>           sub_map_t;
 
     tcp_connect *hptr_;
     net_connect *wptr_;
+    conn_vec_t   hvec_;  // hedge connections for transactions
+    sign_pipeline *sp_;  // transaction signing workers
+    uint64_t     gen_;   // reset count to discard stale signed jobs
+    rpc::upd_price_cache tc_; // upd_price transaction templates
     rpc_http     hp_;    // http parser wrapper
     rpc_ws       wp_;    // websocket parser wrapper
     jtree        jp_;    // json parser
-    request_t    rv_;    // waiting requests by id
+    id_tab_t     itab_;  // waiting requests by id
+    method_vec_t mvec_;  // in-flight counts by request type
+    req_vec_t    dvec_;  // requests being dispatched
     id_vec_t     reuse_; // reuse id list
+    hold_vec_t   hold_;  // timed out ids waiting to be reused
+    uint64_t     num_;   // requests awaiting a reply
+    int64_t      scan_ts_; // last scan for timed out requests
     sub_map_t    smap_;  // subscription map
-    acc_buf_t    abuf_;  // account decode buffer
-    acc_buf_t    zbuf_;  // account decompress buffer
+    acc_buf_t    zbuf_;  // account decode buffer
     uint64_t     id_;    // next request id
     void        *cxt_;
   };
 
+  inline const rpc::upd_price_cache& rpc_client::get_tx_cache() const
+  {
+    return tc_;
+  }
+
+  template<class T>
+  void rpc_client::set_timeout( int64_t timeout, unsigned max_retry )
+  {
+    set_timeout( typeid( T ), timeout, max_retry );
+  }
+
   // rpc response or subscrption callback
   class rpc_sub
   {
@@ -166,6 +352,14 @@ namespace pc
     virtual void on_response( T * ) = 0;
   };
 
+  // notified once a transaction has been signed and sent
+  class rpc_sign_sub
+  {
+  public:
+    virtual ~rpc_sign_sub() {}
+    virtual void on_sign( rpc::upd_price * ) = 0;
+  };
+
   // base-class rpc request message
   class rpc_request : public error
   {
@@ -193,7 +387,8 @@ namespace pc
     void set_recv_time( int64_t );
     int64_t get_recv_time() const;
 
-    // have we received a reply
+    // have we received a reply. requests abandoned by a reset of
+    // their rpc_client count as complete
     bool get_is_recv() const;
 
     // rpc response callback
@@ -224,6 +419,7 @@ namespace pc
     int         ec_;
     int64_t     sent_ts_;
     int64_t     recv_ts_;
+    uint64_t    gen_;
   };
 
   struct tx_hdr
@@ -288,6 +484,19 @@ namespace pc
       uint64_t cslot_; // result
     };
 
+    // find out when slots update
+    class slot_subscribe : public rpc_subscription
+    {
+    public:
+      slot_subscribe();
+      uint64_t get_slot() const;
+      void request( json_wtr& ) override;
+      void response( const jtree& ) override;
+      bool notify( const jtree& ) override;
+    private:
+      uint64_t slot_;
+    };
+
     // base class for account updates
     class account_update : public rpc_subscription
     {
@@ -308,19 +517,23 @@ namespace pc
       size_t get_data_val( T *, size_t srclen=sizeof(T) ) const;
 
     protected:
+      void set_data( const jtree&, uint32_t dtok );
+
       pub_key     acc_;
       commitment  cmt_;
       uint64_t    slot_;
       uint64_t    lamports_;
       size_t      dlen_;
       const char *dptr_;
+      bool        is_zstd_;
     };
 
     template<class T>
     size_t account_update::get_data_ref( T *&res, size_t tlen ) const
     {
       char *ptr;
-      size_t len = get_rpc_client()->get_data_ref( dptr_, dlen_, tlen, ptr );
+      size_t len = get_rpc_client()->get_data_ref(
+          dptr_, dlen_, is_zstd_, tlen, ptr );
       res = (T*)ptr;
       return len;
     }
@@ -329,7 +542,8 @@ namespace pc
     size_t account_update::get_data_val( T *res, size_t tlen ) const
     {
       char *ptr = (char*)res;
-      size_t len = get_rpc_client()->get_data_val( dptr_, dlen_, tlen, ptr );
+      size_t len = get_rpc_client()->get_data_val(
+          dptr_, dlen_, is_zstd_, tlen, ptr );
       return len;
     }
 
@@ -355,6 +569,37 @@ namespace pc
       bool        is_exec_;
     };
 
+    // get account data for a batch of accounts in one round trip.
+    // the subscriber is called back once per account in request order
+    class get_multiple_accounts : public account_update
+    {
+    public:
+      // maximum accounts per request allowed by the rpc api
+      static const size_t max_accounts = 100;
+
+      // parameters
+      void add_account( const pub_key& );
+      void clear_accounts();
+      size_t get_num_accounts() const;
+      const pub_key& get_request_account( size_t ) const;
+
+      // fetch only len bytes from offset of each account (as plain
+      // base64). zero length fetches whole accounts (default)
+      void set_data_slice( size_t offset, size_t len );
+      size_t get_data_slice_len() const;
+
+      get_multiple_accounts();
+      void request( json_wtr& ) override;
+      void response( const jtree& ) override;
+
+      bool get_is_http() const override;
+
+    private:
+      std::vector<pub_key> kvec_;
+      size_t               soff_;
+      size_t               slen_;
+    };
+
     // account data subscription
     class account_subscribe : public account_update
     {
@@ -372,13 +617,65 @@ namespace pc
       // parameters
       void set_program( pub_key * );
 
+      // hold account updates until flush() and then apply only the
+      // latest one per account (default false)
+      void set_coalesce( bool );
+      bool get_coalesce() const;
+
+      // apply held account updates
+      void flush();
+
+      // notifications dropped because they were not newer than the
+      // last one seen for the same account
+      uint64_t get_num_stale() const;
+
+      // held updates replaced by a newer one before flush()
+      uint64_t get_num_coalesce() const;
+
       program_subscribe();
       void request( json_wtr& ) override;
       void response( const jtree& ) override;
       bool notify( const jtree& ) override;
 
     private:
+
+      struct trait_account {
+        static const size_t hsize_ = 8363UL;
+        typedef uint32_t        idx_t;
+        typedef pub_key         key_t;
+        typedef const pub_key&  keyref_t;
+        typedef uint32_t        val_t;
+        struct hash_t {
+          idx_t operator() ( keyref_t a ) {
+            uint64_t *i = (uint64_t*)a.data();
+            return *i;
+          }
+        };
+      };
+
+      // per-account slot watermark and held update
+      struct acc_state {
+        pub_key     acc_;
+        uint64_t    slot_;
+        uint64_t    lamports_;
+        bool        is_pend_;
+        bool        is_zstd_;
+        std::string data_;
+      };
+
+      typedef hash_map<trait_account> acc_map_t;
+      typedef std::vector<acc_state>  acc_vec_t;
+      typedef std::vector<uint32_t>   idx_vec_t;
+
+      acc_state& get_state( const pub_key& );
+
       pub_key    *pgm_;
+      bool        is_coalesce_;
+      uint64_t    num_stale_;
+      uint64_t    num_coalesce_;
+      acc_map_t   amap_;  // account to index in avec_
+      acc_vec_t   avec_;  // account state
+      idx_vec_t   pvec_;  // accounts with held updates
     };
 
     class get_program_accounts : public account_update
@@ -407,6 +704,7 @@ namespace pc
       void set_symbol_status( symbol_status );
       void set_publish( key_pair * );
       void set_pubcache( key_cache * );
+      key_cache *get_pubcache() const;
       void set_account( pub_key * );
       void set_program( pub_key * );
       void set_block_hash( hash * );
@@ -431,8 +729,20 @@ namespace pc
       static bool build( net_wtr&, upd_price*[], unsigned n, unsigned cu_units, unsigned cu_price  );
       static bool request( json_wtr&, upd_price*[], const unsigned n, unsigned cu_units, unsigned cu_price );
 
-    private:
+      // sign transaction once and wrap the same bytes in several requests
       static bool build_tx( bincode&, upd_price*[], unsigned n, unsigned cu_units, unsigned cu_price );
+      static void request( json_wtr&, str tx );
+
+      // build transaction with room for the signature and report where
+      // its fields are
+      static bool build_unsigned_tx( bincode&, upd_price*[], unsigned n, unsigned cu_units, unsigned cu_price, upd_price_layout& );
+
+    private:
+
+      friend class upd_price_cache;
+
+      // upd_price instruction parameters
+      void add_params( bincode& ) const;
 
       hash         *bhash_;
       key_pair     *pkey_;
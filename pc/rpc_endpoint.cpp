@@ -0,0 +1,187 @@
+#include "rpc_endpoint.hpp"
+#include "log.hpp"
+#include "misc.hpp"
+#include <algorithm>
+
+#define PC_RPC_HTTP_PORT       8899
+#define PC_HEDGE_TIMEOUT       (2L*PC_NSECS_IN_SEC)
+#define PC_HEDGE_RECONNECT     (120L*PC_NSECS_IN_SEC)
+
+// cost of each slot an endpoint lags behind in its score
+#define PC_HEDGE_LAG_COST      (400L*PC_NSECS_IN_MSEC)
+
+// weight of a new latency sample as a power of two fraction (1/8)
+#define PC_HEDGE_EWMA_SHIFT    3
+
+using namespace pc;
+
+rpc_endpoint::rpc_endpoint()
+: has_conn_( false ),
+  wait_conn_( false ),
+  cts_( 0L ),
+  ctimeout_( PC_NSECS_IN_SEC ),
+  slot_( 0UL ),
+  lat_( 0L ),
+  num_reply_( 0UL ),
+  num_win_( 0UL ),
+  num_reset_( 0UL ),
+  sreq_{ { commitment::e_processed } }
+{
+  clnt_.set_http_conn( &hconn_ );
+  clnt_.set_timeout<rpc::get_slot>( PC_HEDGE_TIMEOUT, 0 );
+  clnt_.set_timeout<rpc::get_recent_block_hash>( PC_HEDGE_TIMEOUT, 0 );
+}
+
+rpc_endpoint::~rpc_endpoint()
+{
+  teardown();
+}
+
+void rpc_endpoint::set_rpc_host( const std::string& rhost )
+{
+  rhost_ = rhost;
+}
+
+std::string rpc_endpoint::get_rpc_host() const
+{
+  return rhost_;
+}
+
+void rpc_endpoint::set_net_loop( net_loop *nl )
+{
+  hconn_.set_net_loop( nl );
+}
+
+void rpc_endpoint::set_sub( rpc_sub *sub )
+{
+  sreq_->set_sub( sub );
+  breq_->set_sub( sub );
+}
+
+tcp_connect *rpc_endpoint::get_http_conn()
+{
+  return &hconn_;
+}
+
+rpc_client *rpc_endpoint::get_rpc_client()
+{
+  return &clnt_;
+}
+
+bool rpc_endpoint::init()
+{
+  int rport = 0, wport = 0;
+  std::string rhost = get_host_port( rhost_, rport, wport );
+  hconn_.set_port( rport ? rport : PC_RPC_HTTP_PORT );
+  hconn_.set_host( rhost );
+  cts_ = get_now();
+  wait_conn_ = true;
+  if ( !hconn_.init() ) {
+    return set_err_msg( hconn_.get_err_msg() );
+  }
+  return true;
+}
+
+void rpc_endpoint::teardown()
+{
+  hconn_.close();
+  has_conn_ = false;
+}
+
+void rpc_endpoint::poll( int64_t now, int64_t slot_int, bool do_poll )
+{
+  if ( has_conn_ && do_poll ) {
+    hconn_.poll();
+  }
+  if ( !has_conn_ || hconn_.get_is_err() ) {
+    reconnect( now );
+    return;
+  }
+  clnt_.poll( now );
+  if ( sreq_->get_is_recv() && now - sreq_->get_sent_time() >= slot_int ) {
+    clnt_.send( sreq_ );
+  }
+}
+
+void rpc_endpoint::send_block_hash()
+{
+  if ( has_conn_ && !hconn_.get_is_err() && breq_->get_is_recv() ) {
+    clnt_.send( breq_ );
+  }
+}
+
+void rpc_endpoint::reconnect( int64_t now )
+{
+  // waiting to connect
+  if ( hconn_.get_is_wait() ) {
+    hconn_.check();
+    if ( hconn_.get_is_wait() ) {
+      return;
+    }
+  }
+
+  // check for successful (re)connect
+  if ( !hconn_.get_is_err() ) {
+    PC_LOG_INF( "rpc_endpoint_connected" )
+      .add( "host", rhost_ )
+      .end();
+    has_conn_ = true;
+    wait_conn_ = false;
+    ctimeout_ = PC_NSECS_IN_SEC;
+    slot_ = 0UL;
+    clnt_.reset();
+    clnt_.send( sreq_ );
+    return;
+  }
+
+  // log failure to (re)connect
+  if ( wait_conn_ || has_conn_ ) {
+    PC_LOG_WRN( "rpc_endpoint_reset" )
+      .add( "host", rhost_ )
+      .add( "error", hconn_.get_err_msg() )
+      .end();
+    num_reset_ += has_conn_;
+    wait_conn_ = false;
+  }
+
+  // wait for reconnect timeout
+  has_conn_ = false;
+  if ( ctimeout_ > ( now - cts_ ) ) {
+    return;
+  }
+
+  // attempt to reconnect
+  cts_ = now;
+  ctimeout_ += ctimeout_;
+  ctimeout_ = std::min( ctimeout_, PC_HEDGE_RECONNECT );
+  wait_conn_ = true;
+  hconn_.init();
+}
+
+void rpc_endpoint::add_reply( uint64_t slot, int64_t rtt )
+{
+  if ( slot > slot_ ) {
+    slot_ = slot;
+  }
+  if ( num_reply_++ ) {
+    lat_ += ( rtt - lat_ ) / ( 1L << PC_HEDGE_EWMA_SHIFT );
+  } else {
+    lat_ = rtt;
+  }
+}
+
+void rpc_endpoint::add_win()
+{
+  ++num_win_;
+}
+
+bool rpc_endpoint::get_is_fresh( uint64_t slot, uint64_t max_lag ) const
+{
+  return has_conn_ && slot_ + max_lag >= slot;
+}
+
+int64_t rpc_endpoint::get_score( uint64_t slot ) const
+{
+  uint64_t lag = slot > slot_ ? slot - slot_ : 0UL;
+  return lat_ + static_cast<int64_t>( lag ) * PC_HEDGE_LAG_COST;
+}
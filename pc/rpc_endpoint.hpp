@@ -0,0 +1,114 @@
+#pragma once
+
+#include <pc/net_socket.hpp>
+#include <pc/rpc_client.hpp>
+
+namespace pc
+{
+
+  // additional solana rpc node that latency critical requests are hedged
+  // across. replies are delivered to the same subscriber as those of the
+  // primary node and the first (freshest) one wins. the node is scored by
+  // its reply latency and by how far its slot lags behind the best one
+  class rpc_endpoint : public error
+  {
+  public:
+
+    rpc_endpoint();
+    ~rpc_endpoint();
+
+    // <host>[:port] of the rpc http api
+    void set_rpc_host( const std::string& );
+    std::string get_rpc_host() const;
+
+    // event loop and subscriber for slot and block hash replies
+    void set_net_loop( net_loop * );
+    void set_sub( rpc_sub * );
+
+    // start connecting
+    bool init();
+
+    // (re)connect, poll for the slot every slot_int nanoseconds and time
+    // out requests. sockets are polled here if not driven by the net_loop
+    void poll( int64_t now, int64_t slot_int, bool do_poll );
+
+    // request a block hash unless one is already outstanding
+    void send_block_hash();
+
+    // close connection
+    void teardown();
+
+    bool get_is_connect() const;
+    tcp_connect *get_http_conn();
+    rpc_client *get_rpc_client();
+
+    // record a successful reply observed at slot
+    void add_reply( uint64_t slot, int64_t rtt );
+
+    // record a reply that was the first to deliver new state
+    void add_win();
+
+    // connected and no more than max_lag slots behind slot
+    bool get_is_fresh( uint64_t slot, uint64_t max_lag ) const;
+
+    // reply latency plus a cost per slot behind slot (lower is better)
+    int64_t get_score( uint64_t slot ) const;
+
+    uint64_t get_slot() const;
+    int64_t get_latency() const;
+    uint64_t get_num_reply() const;
+    uint64_t get_num_win() const;
+    uint64_t get_num_reset() const;
+
+  private:
+
+    void reconnect( int64_t now );
+
+    std::string    rhost_;    // rpc host
+    tcp_connect    hconn_;    // rpc http connection
+    rpc_client     clnt_;     // rpc api
+    bool           has_conn_; // connected
+    bool           wait_conn_;// waiting on connection
+    int64_t        cts_;      // (re)connect timestamp
+    int64_t        ctimeout_; // connection timeout
+    uint64_t       slot_;     // highest slot reported
+    int64_t        lat_;      // moving average reply latency
+    uint64_t       num_reply_;// successful replies
+    uint64_t       num_win_;  // replies that delivered new state first
+    uint64_t       num_reset_;// connection resets
+
+    rpc::get_slot              sreq_[1]; // slot poll
+    rpc::get_recent_block_hash breq_[1]; // block hash request
+  };
+
+  inline bool rpc_endpoint::get_is_connect() const
+  {
+    return has_conn_;
+  }
+
+  inline uint64_t rpc_endpoint::get_slot() const
+  {
+    return slot_;
+  }
+
+  inline int64_t rpc_endpoint::get_latency() const
+  {
+    return lat_;
+  }
+
+  inline uint64_t rpc_endpoint::get_num_reply() const
+  {
+    return num_reply_;
+  }
+
+  inline uint64_t rpc_endpoint::get_num_win() const
+  {
+    return num_win_;
+  }
+
+  inline uint64_t rpc_endpoint::get_num_reset() const
+  {
+    return num_reset_;
+  }
+
+}
@@ -0,0 +1,175 @@
+#include "sign_pipeline.hpp"
+#include "bincode.hpp"
+#include "log.hpp"
+#include "misc.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+using namespace pc;
+
+static void run_worker( sign_pipeline *sp, unsigned i )
+{
+  sp->run( i );
+}
+
+void sign_pipeline::wake::poll()
+{
+  uint64_t val;
+  while( ::read( get_fd(), &val, sizeof( val ) ) > 0 );
+}
+
+sign_pipeline::worker::worker()
+: in_( PC_SIGN_QUEUE ),
+  out_( PC_SIGN_QUEUE ),
+  fd_( -1 )
+{
+}
+
+sign_pipeline::sign_pipeline()
+: num_( 1 ),
+  nl_( nullptr ),
+  is_run_( false ),
+  sidx_( 0UL ),
+  pidx_( 0UL ),
+  max_( 0UL )
+{
+}
+
+sign_pipeline::~sign_pipeline()
+{
+  teardown();
+}
+
+void sign_pipeline::set_num_worker( unsigned num )
+{
+  num_ = num ? num : 1;
+}
+
+unsigned sign_pipeline::get_num_worker() const
+{
+  return num_;
+}
+
+void sign_pipeline::set_net_loop( net_loop *nl )
+{
+  nl_ = nl;
+}
+
+bool sign_pipeline::init()
+{
+  if ( nl_ ) {
+    int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if ( fd < 0 ) {
+      return set_err_msg( "failed to create eventfd", errno );
+    }
+    wk_.set_fd( fd );
+    wk_.set_net_loop( nl_ );
+    if ( !wk_.init() ) {
+      return set_err_msg( wk_.get_err_msg() );
+    }
+  }
+  for( unsigned i = 0; i != num_; ++i ) {
+    worker *wk = new worker;
+    wvec_.push_back( wk );
+    wk->fd_ = ::eventfd( 0, EFD_CLOEXEC );
+    if ( wk->fd_ < 0 ) {
+      return set_err_msg( "failed to create eventfd", errno );
+    }
+  }
+  is_run_ = true;
+  for( unsigned i = 0; i != num_; ++i ) {
+    wvec_[i]->thrd_ = std::thread( run_worker, this, i );
+  }
+  return true;
+}
+
+void sign_pipeline::teardown()
+{
+  is_run_ = false;
+  for( worker *wk: wvec_ ) {
+    if ( wk->thrd_.joinable() ) {
+      uint64_t val = 1;
+      while( ::write( wk->fd_, &val, sizeof( val ) ) < 0 && errno == EINTR );
+      wk->thrd_.join();
+    }
+  }
+  job jb;
+  for( worker *wk: wvec_ ) {
+    while( wk->in_.pop( jb ) ) {
+      jb.buf_->dealloc();
+    }
+    while( wk->out_.pop( jb ) ) {
+      jb.buf_->dealloc();
+    }
+    if ( wk->fd_ >= 0 ) {
+      ::close( wk->fd_ );
+    }
+    delete wk;
+  }
+  wvec_.clear();
+  wk_.close();
+  sidx_ = pidx_ = 0UL;
+}
+
+void sign_pipeline::submit( job& jb )
+{
+  if ( get_is_full() ) {
+    jb.buf_->dealloc();
+    return;
+  }
+
+  // cannot fail as the jobs in flight are bounded by the queue size
+  worker *wk = wvec_[sidx_ % wvec_.size()];
+  jb.ts_ = get_now();
+  jb.dur_ = 0L;
+  wk->in_.push( jb );
+  ++sidx_;
+  max_ = std::max( max_, get_depth() );
+  uint64_t val = 1;
+  while( ::write( wk->fd_, &val, sizeof( val ) ) < 0 && errno == EINTR );
+}
+
+bool sign_pipeline::pop( job& jb )
+{
+  if ( sidx_ == pidx_ ) {
+    return false;
+  }
+  worker *wk = wvec_[pidx_ % wvec_.size()];
+  if ( !wk->out_.pop( jb ) ) {
+    return false;
+  }
+  ++pidx_;
+  lat_.add( get_now() - jb.ts_ );
+  sign_.add( jb.dur_ );
+  return true;
+}
+
+void sign_pipeline::run( unsigned i )
+{
+  worker *wk = wvec_[i];
+  job jb;
+  while( is_run_ ) {
+    uint64_t val;
+    if ( ::read( wk->fd_, &val, sizeof( val ) ) < 0 && errno != EINTR ) {
+      PC_LOG_ERR( "sign_worker_read" ).add( "errno", (int64_t)errno ).end();
+      break;
+    }
+    bool is_sign = false;
+    while( wk->in_.pop( jb ) ) {
+      int64_t ts = get_now();
+      bincode tx( jb.buf_->buf_ );
+      tx.set_pos( jb.len_ );
+      tx.sign( jb.sig_, jb.msg_, *jb.key_ );
+      jb.dur_ = get_now() - ts;
+
+      wk->out_.push( jb );
+      is_sign = true;
+    }
+    if ( is_sign && nl_ ) {
+      val = 1;
+      while( ::write( wk_.get_fd(), &val, sizeof( val ) ) < 0 &&
+             errno == EINTR );
+    }
+  }
+}
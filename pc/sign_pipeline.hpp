@@ -0,0 +1,134 @@
+#pragma once
+
+#include <pc/net_socket.hpp>
+#include <pc/spsc_queue.hpp>
+#include <pc/rpc_client.hpp>
+#include <atomic>
+#include <thread>
+
+// transactions queued per sign worker
+#define PC_SIGN_QUEUE 1024
+
+namespace pc
+{
+
+  class key_cache;
+
+  // signs transaction images on worker threads so that the manager thread
+  // keeps servicing sockets. jobs are handed to the workers round-robin
+  // over spsc queues and returned in submission order
+  class sign_pipeline : public error
+  {
+  public:
+
+    struct job {
+      net_buf         *buf_;  // transaction image signed in place
+      size_t           len_;  // image length
+      size_t           sig_;  // offset of signature
+      size_t           msg_;  // offset of signed message
+      const key_cache *key_;  // signing key
+      uint64_t         id_;   // caller request id
+      uint64_t         gen_;  // caller generation
+      int64_t          ts_;   // submit time
+      int64_t          dur_;  // time spent signing
+    };
+
+    sign_pipeline();
+    ~sign_pipeline();
+
+    // number of worker threads (default 1)
+    void set_num_worker( unsigned );
+    unsigned get_num_worker() const;
+
+    // optional loop woken up when signed jobs are ready
+    void set_net_loop( net_loop * );
+
+    // start worker threads
+    bool init();
+
+    // stop worker threads. jobs not yet popped are released
+    void teardown();
+
+    // manager thread: too many jobs pending to accept another
+    bool get_is_full() const;
+
+    // manager thread: queue job unless full
+    void submit( job& );
+
+    // manager thread: next signed job in submission order
+    bool pop( job& );
+
+    // jobs submitted and not yet popped
+    uint64_t get_depth() const;
+    uint64_t get_max_depth() const;
+    uint64_t get_num_sign() const;
+
+    // submit to pop latency and time spent signing
+    const latency_hist& get_latency() const;
+    const latency_hist& get_sign_time() const;
+
+    // worker thread interface
+    void run( unsigned );
+
+  private:
+
+    typedef spsc_queue<job> queue_t;
+
+    // eventfd used to wake up the net_loop
+    struct wake : public net_socket {
+      void poll() override;
+    };
+
+    struct worker {
+      worker();
+      queue_t     in_;    // manager -> worker
+      queue_t     out_;   // worker -> manager
+      int         fd_;    // blocking wake-up eventfd
+      std::thread thrd_;
+    };
+
+    typedef std::vector<worker*> worker_vec_t;
+
+    unsigned          num_;     // number of workers
+    net_loop         *nl_;      // loop to wake up
+    wake              wk_;      // completion eventfd
+    std::atomic<bool> is_run_;  // keep running flag
+    worker_vec_t      wvec_;    // workers
+    uint64_t          sidx_;    // jobs submitted
+    uint64_t          pidx_;    // jobs popped
+    uint64_t          max_;     // maximum depth
+    latency_hist      lat_;     // submit to pop latency
+    latency_hist      sign_;    // time spent signing
+  };
+
+  inline bool sign_pipeline::get_is_full() const
+  {
+    return wvec_.empty() || get_depth() >= PC_SIGN_QUEUE;
+  }
+
+  inline uint64_t sign_pipeline::get_depth() const
+  {
+    return sidx_ - pidx_;
+  }
+
+  inline uint64_t sign_pipeline::get_max_depth() const
+  {
+    return max_;
+  }
+
+  inline uint64_t sign_pipeline::get_num_sign() const
+  {
+    return pidx_;
+  }
+
+  inline const latency_hist& sign_pipeline::get_latency() const
+  {
+    return lat_;
+  }
+
+  inline const latency_hist& sign_pipeline::get_sign_time() const
+  {
+    return sign_;
+  }
+
+}
@@ -0,0 +1,71 @@
+#include "slot_clock.hpp"
+#include "misc.hpp"
+
+// nominal slot interval before anything is observed
+#define PC_SLOT_INTERVAL  (400L*PC_NSECS_IN_MSEC)
+
+// weight of a new sample as a power of two fraction (1/8)
+#define PC_SLOT_EWMA_SHIFT 3
+
+using namespace pc;
+
+slot_clock::slot_clock()
+: slot_( 0UL ),
+  ts_( 0L ),
+  int_( PC_SLOT_INTERVAL )
+{
+}
+
+void slot_clock::reset()
+{
+  slot_ = 0UL;
+  ts_ = 0L;
+}
+
+bool slot_clock::update( uint64_t slot, int64_t ts )
+{
+  if ( slot <= slot_ ) {
+    return false;
+  }
+  if ( slot_ && ts > ts_ ) {
+    // average over skipped slots and bound outliers (e.g. after a
+    // stall) to a few times the current estimate
+    int64_t val = ( ts - ts_ ) / static_cast<int64_t>( slot - slot_ );
+    val = val < int_/4 ? int_/4 : ( val > 4*int_ ? 4*int_ : val );
+    int_ += ( val - int_ ) / ( 1L << PC_SLOT_EWMA_SHIFT );
+  }
+  slot_ = slot;
+  ts_ = ts;
+  return true;
+}
+
+uint64_t slot_clock::get_slot() const
+{
+  return slot_;
+}
+
+int64_t slot_clock::get_slot_time() const
+{
+  return ts_;
+}
+
+int64_t slot_clock::get_slot_interval() const
+{
+  return int_;
+}
+
+uint64_t slot_clock::get_est_slot( int64_t ts ) const
+{
+  if ( !slot_ || ts <= ts_ ) {
+    return slot_;
+  }
+  return slot_ + static_cast<uint64_t>( ( ts - ts_ ) / int_ );
+}
+
+int64_t slot_clock::get_next_slot_time( int64_t ts ) const
+{
+  if ( ts < ts_ ) {
+    return ts_ + int_;
+  }
+  return ts_ + ( ( ts - ts_ ) / int_ + 1 ) * int_;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace pc
+{
+
+  // tracks slot boundaries as they are observed and predicts the ones
+  // in between using a moving average of the slot interval
+  class slot_clock
+  {
+  public:
+
+    slot_clock();
+
+    // forget the last slot but keep the interval estimate
+    void reset();
+
+    // slot observed at time ts (nanoseconds). returns false if the slot
+    // is not newer than the last one
+    bool update( uint64_t slot, int64_t ts );
+
+    // last observed slot and the time it was observed
+    uint64_t get_slot() const;
+    int64_t get_slot_time() const;
+
+    // estimated slot interval in nanoseconds
+    int64_t get_slot_interval() const;
+
+    // predicted slot at time ts
+    uint64_t get_est_slot( int64_t ts ) const;
+
+    // predicted start time of the first slot boundary after ts
+    int64_t get_next_slot_time( int64_t ts ) const;
+
+  private:
+
+    uint64_t slot_;
+    int64_t  ts_;
+    int64_t  int_;
+  };
+
+}
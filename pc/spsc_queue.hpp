@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+namespace pc
+{
+
+  // bounded lock-free single-producer single-consumer queue
+  template<class T>
+  class spsc_queue
+  {
+  public:
+
+    // capacity is rounded up to power of 2
+    spsc_queue( size_t len = 4096 );
+
+    // producer: move item into queue. returns false if full
+    bool push( T& );
+
+    // consumer: move item out of queue. returns false if empty
+    bool pop( T& );
+
+    // approximate number of queued items
+    size_t size() const;
+
+  private:
+
+    static const size_t pad_len = 64;
+    typedef std::atomic<size_t> atomic_t;
+    typedef std::vector<T>      vec_t;
+
+    vec_t    vec_;
+    size_t   mask_;
+    char     pad0_[pad_len];
+    atomic_t hd_;      // consumer position
+    size_t   ctl_;     // consumer copy of tail
+    char     pad1_[pad_len];
+    atomic_t tl_;      // producer position
+    size_t   phd_;     // producer copy of head
+    char     pad2_[pad_len];
+  };
+
+  template<class T>
+  spsc_queue<T>::spsc_queue( size_t len )
+  : hd_( 0 ),
+    ctl_( 0 ),
+    tl_( 0 ),
+    phd_( 0 )
+  {
+    size_t cap = 2;
+    while( cap < len ) {
+      cap <<= 1;
+    }
+    vec_.resize( cap );
+    mask_ = cap - 1;
+  }
+
+  template<class T>
+  bool spsc_queue<T>::push( T& item )
+  {
+    size_t tl = tl_.load( std::memory_order_relaxed );
+    if ( tl - phd_ > mask_ ) {
+      phd_ = hd_.load( std::memory_order_acquire );
+      if ( tl - phd_ > mask_ ) {
+        return false;
+      }
+    }
+    vec_[tl & mask_] = std::move( item );
+    tl_.store( tl + 1, std::memory_order_release );
+    return true;
+  }
+
+  template<class T>
+  bool spsc_queue<T>::pop( T& item )
+  {
+    size_t hd = hd_.load( std::memory_order_relaxed );
+    if ( hd == ctl_ ) {
+      ctl_ = tl_.load( std::memory_order_acquire );
+      if ( hd == ctl_ ) {
+        return false;
+      }
+    }
+    item = std::move( vec_[hd & mask_] );
+    hd_.store( hd + 1, std::memory_order_release );
+    return true;
+  }
+
+  template<class T>
+  size_t spsc_queue<T>::size() const
+  {
+    return tl_.load( std::memory_order_acquire ) -
+           hd_.load( std::memory_order_acquire );
+  }
+
+}
@@ -1,5 +1,6 @@
 #include "user.hpp"
 #include "manager.hpp"
+#include "user_reactor.hpp"
 #include "log.hpp"
 #include "mem_map.hpp"
 #include <algorithm>
@@ -27,6 +28,8 @@ void user::user_http::parse_content( const char *txt, size_t len )
 user::user()
 : rptr_( nullptr ),
   sptr_( nullptr ),
+  rtr_( nullptr ),
+  rid_( 0UL ),
   psub_( this )
 {
   // setup the plumbing
@@ -46,6 +49,26 @@ void user::set_manager( manager *sptr )
   sptr_ = sptr;
 }
 
+void user::set_reactor( user_reactor *rtr, uint64_t id )
+{
+  rtr_ = rtr;
+  rid_ = id;
+}
+
+user_reactor *user::get_reactor() const
+{
+  return rtr_;
+}
+
+void user::send( net_wtr& msg )
+{
+  if ( rtr_ ) {
+    rtr_->send( rid_, msg );
+  } else {
+    add_send( msg );
+  }
+}
+
 void user::teardown()
 {
   net_connect::teardown();
@@ -90,7 +113,7 @@ void user::parse_content( const char *, size_t )
   ) {
     msg.init( "404", "Not Found" );
     msg.commit();
-    add_send( msg );
+    send( msg );
     return;
   }
 
@@ -114,13 +137,18 @@ void user::parse_content( const char *, size_t )
     msg.init( "404", "Not Found" );
     msg.commit();
   }
-  add_send( msg );
+  send( msg );
 }
 
 void user::parse_msg( const char *txt, size_t len )
 {
   jw_.reset();
   jp_.parse( txt, len );
+  parse_tree();
+}
+
+void user::parse_tree()
+{
   if ( jp_.is_valid() ) {
     jtree::type_t t = jp_.get_type( 1 );
     if ( t == jtree::e_obj ) {
@@ -149,7 +177,7 @@ void user::parse_msg( const char *txt, size_t len )
   // wrap in websockets header and submit
   ws_wtr msg;
   msg.commit( ws_wtr::text_id, jw_, false );
-  add_send( msg );
+  send( msg );
 
   // process any deferred subscriptions
   if ( PC_UNLIKELY( !dvec_.empty() ) ) {
@@ -197,11 +225,8 @@ void user::parse_upd_price( uint32_t tok, uint32_t itok )
     if ( 0 == (ntok = jp_.find_val( ptok, "account" ) ) ) break;
     pub_key pkey;
     pkey.init_from_text( jp_.get_str( ntok ) );
-    price *sptr = sptr_->get_price( pkey );
-    price *sptr_secondary = nullptr;
-    if ( sptr_->has_secondary() ) {
-      sptr_secondary = sptr_->get_secondary()->get_price( pkey );
-    }
+    price *sptr = nullptr, *sptr_secondary = nullptr;
+    get_price( pkey, sptr, sptr_secondary );
 
     // Bail if we cannot find the price in either manager.
     if ( PC_UNLIKELY( !sptr && !sptr_secondary ) ) { add_unknown_symbol(itok); return; }
@@ -215,14 +240,7 @@ void user::parse_upd_price( uint32_t tok, uint32_t itok )
 
     // Add the price to both the managers pending updates, so that it will
     // be published to both networks if possible.
-    if ( sptr ) {
-      sptr->update_no_send( price, conf, stype, false );
-      sptr_->add_dirty_price( sptr );
-    }
-    if ( sptr_secondary ) {
-      sptr_secondary->update_no_send( price, conf, stype, false );
-      sptr_->get_secondary()->add_dirty_price( sptr_secondary );
-    }
+    upd_price( sptr, sptr_secondary, price, conf, stype );
 
     // Send the result back
     add_header();
@@ -234,6 +252,21 @@ void user::parse_upd_price( uint32_t tok, uint32_t itok )
   add_invalid_params( itok );
 }
 
+void user::get_price( const pub_key& pkey, price *&sptr, price *&sptr2 )
+{
+  sptr = sptr_->get_price( pkey );
+  sptr2 = nullptr;
+  if ( sptr_->has_secondary() ) {
+    sptr2 = sptr_->get_secondary()->get_price( pkey );
+  }
+}
+
+void user::upd_price( price *sptr, price *sptr2, int64_t px, uint64_t conf,
+                      symbol_status stype )
+{
+  sptr_->upd_price( sptr, sptr2, px, conf, stype );
+}
+
 void user::parse_sub_price( uint32_t tok, uint32_t itok )
 {
   do {
@@ -467,7 +500,7 @@ void user::on_response( price *rptr, uint64_t idx )
   // wrap in websockets header and submit
   ws_wtr msg;
   msg.commit( ws_wtr::text_id, jw_, false );
-  add_send( msg );
+  send( msg );
 }
 
 void user::on_response( price_sched *, uint64_t idx )
@@ -484,5 +517,5 @@ void user::on_response( price_sched *, uint64_t idx )
   // wrap in websockets header and submit
   ws_wtr msg;
   msg.commit( ws_wtr::text_id, jw_, false );
-  add_send( msg );
+  send( msg );
 }
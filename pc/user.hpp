@@ -10,6 +10,7 @@ namespace pc
 {
 
   class manager;
+  class user_reactor;
 
   // pyth daemon web-socket user connection
   class user : public prev_next<user>,
@@ -28,6 +29,10 @@ namespace pc
     // associated pyth server
     void set_manager( manager * );
 
+    // route outbound messages through reactor thread owning the socket
+    void set_reactor( user_reactor *, uint64_t id );
+    user_reactor *get_reactor() const;
+
     // http request message parsing
     void parse_content( const char *, size_t );
 
@@ -43,6 +48,29 @@ namespace pc
     // symbol price schedule callback
     void on_response( price_sched *, uint64_t ) override;
 
+  protected:
+
+    // process request(s) already parsed into jp_
+    void parse_tree();
+
+    // find price account on primary and secondary network
+    virtual void get_price( const pub_key&, price *&, price *& );
+
+    // queue component price update for publishing
+    virtual void upd_price( price *, price *, int64_t px, uint64_t conf,
+                            symbol_status );
+
+    void add_header();
+    void add_tail( uint32_t id );
+    void add_invalid_request( uint32_t id = 0 );
+
+    rpc_client     *rptr_;        // rpc manager api
+    manager        *sptr_;        // manager collection
+    user_reactor   *rtr_;         // reactor owning remote socket
+    uint64_t        rid_;         // connection id in reactor
+    jtree           jp_;          // json parser
+    json_wtr        jw_;          // json writer
+
   private:
 
     // http-only request parsing
@@ -65,19 +93,13 @@ namespace pc
     void parse_upd_price( uint32_t,  uint32_t );
     void parse_sub_price( uint32_t,  uint32_t );
     void parse_sub_price_sched( uint32_t,  uint32_t );
-    void add_header();
-    void add_tail( uint32_t id );
     void add_parse_error();
-    void add_invalid_request( uint32_t id = 0 );
     void add_invalid_params( uint32_t id );
     void add_unknown_symbol( uint32_t id );
     void add_error( uint32_t id, int err, str );
+    void send( net_wtr& );
 
-    rpc_client     *rptr_;        // rpc manager api
-    manager        *sptr_;        // manager collection
     user_http       hsvr_;        // http parser
-    jtree           jp_;          // json parser
-    json_wtr        jw_;          // json writer
     def_vec_t       dvec_;        // deferred subscriptions
     request_sub_set psub_;        // price subscriptions
   };
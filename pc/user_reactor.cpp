@@ -0,0 +1,406 @@
+#include "user_reactor.hpp"
+#include "manager.hpp"
+#include "log.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pc;
+
+///////////////////////////////////////////////////////////////////////////
+// price_index
+
+price_index::price_index()
+: vec_( nullptr ),
+  num_( 0 ),
+  is_full_( false )
+{
+}
+
+price_index::~price_index()
+{
+  delete [] vec_;
+}
+
+void price_index::init()
+{
+  if ( !vec_ ) {
+    vec_ = new slot[num_slots];
+    for( size_t i=0; i != num_slots; ++i ) {
+      vec_[i].val_.store( nullptr, std::memory_order_relaxed );
+    }
+  }
+}
+
+bool price_index::get_is_init() const
+{
+  return vec_ != nullptr;
+}
+
+bool price_index::add( const pub_key& key, price *ptr )
+{
+  if ( num_ == max_used ) {
+    is_full_.store( true, std::memory_order_release );
+    return false;
+  }
+  size_t idx = *(const uint64_t*)key.data();
+  for( ;; ++idx ) {
+    slot& s = vec_[idx & (num_slots-1)];
+    price *val = s.val_.load( std::memory_order_relaxed );
+    if ( !val ) {
+      // key must be visible before readers can observe the value
+      s.key_ = key;
+      s.val_.store( ptr, std::memory_order_release );
+      ++num_;
+      return true;
+    }
+    if ( s.key_ == key ) {
+      return true;
+    }
+  }
+}
+
+price *price_index::get( const pub_key& key ) const
+{
+  size_t idx = *(const uint64_t*)key.data();
+  for( ;; ++idx ) {
+    const slot& s = vec_[idx & (num_slots-1)];
+    price *val = s.val_.load( std::memory_order_acquire );
+    if ( !val || s.key_ == key ) {
+      return val;
+    }
+  }
+}
+
+bool price_index::get_is_full() const
+{
+  return is_full_.load( std::memory_order_acquire );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// reactor_user
+
+reactor_user::reactor_user( user_reactor *ur, uint64_t id )
+: ur_( ur ),
+  uid_( id ),
+  num_fwd_( 0UL )
+{
+}
+
+uint64_t reactor_user::get_id() const
+{
+  return uid_;
+}
+
+void reactor_user::on_done()
+{
+  if ( num_fwd_ ) {
+    --num_fwd_;
+  }
+}
+
+bool reactor_user::get_is_upd( uint32_t tok ) const
+{
+  if ( jp_.get_type( tok ) != jtree::e_obj ) {
+    return false;
+  }
+  uint32_t mtok = jp_.find_val( tok, "method" );
+  return mtok && jp_.get_str( mtok ) == "update_price";
+}
+
+bool reactor_user::get_is_upd_only() const
+{
+  if ( !jp_.is_valid() ) {
+    return false;
+  }
+  jtree::type_t t = jp_.get_type( 1 );
+  if ( t == jtree::e_obj ) {
+    return get_is_upd( 1 );
+  }
+  if ( t != jtree::e_arr || !jp_.get_first( 1 ) ) {
+    return false;
+  }
+  for( uint32_t tok = jp_.get_first( 1 ); tok; tok = jp_.get_next( tok ) ) {
+    if ( !get_is_upd( tok ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void reactor_user::parse_msg( const char *txt, size_t len )
+{
+  jw_.reset();
+  jp_.parse( txt, len );
+
+  // answer update_price batches locally unless the price index could
+  // not hold every account (in which case the manager has to look up)
+  // or the reply would overtake that of a forwarded request
+  manager *mgr = ur_->get_manager();
+  bool is_full = mgr->get_price_index()->get_is_full() || (
+      mgr->has_secondary() &&
+      mgr->get_secondary()->get_price_index()->get_is_full() );
+  if ( !is_full && !num_fwd_ && get_is_upd_only() ) {
+    parse_tree();
+  } else {
+    ++num_fwd_;
+    ur_->forward( uid_, txt, len );
+  }
+}
+
+void reactor_user::get_price( const pub_key& pkey,
+                              price *&sptr, price *&sptr2 )
+{
+  manager *mgr = ur_->get_manager();
+  sptr = mgr->get_price_index()->get( pkey );
+  sptr2 = nullptr;
+  if ( mgr->has_secondary() ) {
+    sptr2 = mgr->get_secondary()->get_price_index()->get( pkey );
+  }
+}
+
+void reactor_user::upd_price( price *sptr, price *sptr2, int64_t px,
+                              uint64_t conf, symbol_status st )
+{
+  ur_->upd_price( sptr, sptr2, px, conf, st );
+}
+
+void reactor_user::teardown()
+{
+  net_connect::teardown();
+  ur_->del_user( this );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// user_reactor
+
+void user_reactor::wake::poll()
+{
+  uint64_t val;
+  while( ::read( get_fd(), &val, sizeof( val ) ) > 0 );
+}
+
+user_reactor::user_reactor()
+: mgr_( nullptr ),
+  is_run_( false ),
+  is_wk_( false )
+{
+}
+
+user_reactor::~user_reactor()
+{
+  teardown();
+}
+
+void user_reactor::set_manager( manager *mgr )
+{
+  mgr_ = mgr;
+}
+
+manager *user_reactor::get_manager() const
+{
+  return mgr_;
+}
+
+static void run_reactor( user_reactor *rptr )
+{
+  rptr->run();
+}
+
+bool user_reactor::init()
+{
+  if ( !nl_.init() ) {
+    return set_err_msg( nl_.get_err_msg() );
+  }
+  int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to create eventfd", errno );
+  }
+  wk_.set_fd( fd );
+  wk_.set_net_loop( &nl_ );
+  wk_.init();
+  is_run_ = true;
+  thrd_ = std::thread( run_reactor, this );
+  return true;
+}
+
+void user_reactor::teardown()
+{
+  if ( thrd_.joinable() ) {
+    is_run_ = false;
+    is_wk_ = true;
+    flush();
+    thrd_.join();
+  }
+  wk_.close();
+}
+
+void user_reactor::add_user( uint64_t id, int fd )
+{
+  msg m;
+  m.type_ = e_add_user;
+  m.id_   = id;
+  m.fd_   = fd;
+  push_in( m );
+}
+
+void user_reactor::send( uint64_t id, net_wtr& wtr )
+{
+  msg m;
+  m.type_ = e_send;
+  m.id_   = id;
+  m.buf_.reserve( wtr.size() );
+  net_buf *hd, *tl;
+  wtr.detach( hd, tl );
+  for( net_buf *ptr = hd; ptr; ) {
+    net_buf *nxt = ptr->next_;
+    m.buf_.append( ptr->buf_, ptr->size_ );
+    ptr->dealloc();
+    ptr = nxt;
+  }
+  push_in( m );
+}
+
+void user_reactor::done( uint64_t id )
+{
+  msg m;
+  m.type_ = e_done;
+  m.id_   = id;
+  push_in( m );
+}
+
+void user_reactor::push_in( msg& m )
+{
+  if ( !inq_.empty() || !in_.push( m ) ) {
+    inq_.emplace_back( std::move( m ) );
+  }
+  is_wk_ = true;
+}
+
+bool user_reactor::pop( msg& m )
+{
+  return out_.pop( m );
+}
+
+void user_reactor::flush()
+{
+  while( !inq_.empty() && in_.push( inq_.front() ) ) {
+    inq_.pop_front();
+  }
+  if ( is_wk_ ) {
+    uint64_t val = 1;
+    if ( ::write( wk_.get_fd(), &val, sizeof( val ) ) > 0 ) {
+      is_wk_ = false;
+    }
+  }
+}
+
+void user_reactor::push_out( msg& m )
+{
+  if ( !outq_.empty() || !out_.push( m ) ) {
+    outq_.emplace_back( std::move( m ) );
+  }
+}
+
+void user_reactor::flush_out()
+{
+  while( !outq_.empty() && out_.push( outq_.front() ) ) {
+    outq_.pop_front();
+  }
+}
+
+void user_reactor::forward( uint64_t id, const char *txt, size_t len )
+{
+  msg m;
+  m.type_ = e_request;
+  m.id_   = id;
+  m.buf_.assign( txt, len );
+  push_out( m );
+}
+
+void user_reactor::upd_price( price *sptr, price *sptr2, int64_t px,
+                              uint64_t conf, symbol_status st )
+{
+  msg m;
+  m.type_   = e_upd_price;
+  m.id_     = 0;
+  m.px_[0]  = sptr;
+  m.px_[1]  = sptr2;
+  m.price_  = px;
+  m.conf_   = conf;
+  m.st_     = st;
+  push_out( m );
+}
+
+void user_reactor::del_user( reactor_user *usr )
+{
+  if ( umap_.erase( usr->get_id() ) ) {
+    msg m;
+    m.type_ = e_del_user;
+    m.id_   = usr->get_id();
+    push_out( m );
+    dvec_.push_back( usr );
+  }
+}
+
+void user_reactor::poll_in()
+{
+  msg m;
+  while( in_.pop( m ) ) {
+    switch( m.type_ ) {
+      case e_add_user: {
+        reactor_user *usr = new reactor_user( this, m.id_ );
+        usr->set_manager( mgr_ );
+        usr->set_net_loop( &nl_ );
+        usr->set_fd( m.fd_ );
+        usr->set_block( false );
+        umap_[m.id_] = usr;
+        if ( !usr->init() ) {
+          usr->teardown();
+        }
+        break;
+      }
+      case e_send: {
+        user_map_t::iterator it = umap_.find( m.id_ );
+        if ( it != umap_.end() ) {
+          net_wtr wtr;
+          wtr.add( str( m.buf_.data(), m.buf_.size() ) );
+          it->second->add_send( wtr );
+        }
+        break;
+      }
+      case e_done: {
+        user_map_t::iterator it = umap_.find( m.id_ );
+        if ( it != umap_.end() ) {
+          it->second->on_done();
+        }
+        break;
+      }
+      default: break;
+    }
+  }
+}
+
+void user_reactor::teardown_users()
+{
+  for( reactor_user *usr: dvec_ ) {
+    usr->close();
+    delete usr;
+  }
+  dvec_.clear();
+}
+
+void user_reactor::run()
+{
+  while( is_run_ ) {
+    nl_.poll( 1 );
+    poll_in();
+    teardown_users();
+    flush_out();
+  }
+
+  // close all remaining connections
+  while( !umap_.empty() ) {
+    umap_.begin()->second->teardown();
+  }
+  teardown_users();
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <pc/user.hpp>
+#include <pc/spsc_queue.hpp>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+
+namespace pc
+{
+
+  // insert-only price account lookup written by the manager thread and
+  // read concurrently by reactor threads
+  class price_index
+  {
+  public:
+    price_index();
+    ~price_index();
+
+    // allocate table. must be called before any reader starts
+    void init();
+    bool get_is_init() const;
+
+    // add account (manager thread only). false if table is full
+    bool add( const pub_key&, price * );
+
+    // find account (any thread)
+    price *get( const pub_key& ) const;
+
+    // has any add failed due to lack of space
+    bool get_is_full() const;
+
+  private:
+
+    static const size_t num_slots = 65536;
+    static const size_t max_used  = num_slots / 2;
+
+    struct slot {
+      pub_key              key_;
+      std::atomic<price *> val_;
+    };
+
+    slot             *vec_;
+    size_t            num_;
+    std::atomic<bool> is_full_;
+  };
+
+  class user_reactor;
+
+  // publisher connection owned by a reactor thread. update_price
+  // batches are validated and queued to the manager on the reactor
+  // thread, everything else is forwarded to the manager-side user.
+  // update_price batches are also forwarded while an earlier request is
+  // waiting on the manager so replies stay in request order
+  class reactor_user : public user
+  {
+  public:
+    reactor_user( user_reactor *, uint64_t id );
+
+    uint64_t get_id() const;
+
+    // manager answered a forwarded request
+    void on_done();
+
+    void parse_msg( const char *buf, size_t sz ) override;
+    void teardown() override;
+
+  protected:
+    void get_price( const pub_key&, price *&, price *& ) override;
+    void upd_price( price *, price *, int64_t px, uint64_t conf,
+                    symbol_status ) override;
+
+  private:
+    bool get_is_upd_only() const;
+    bool get_is_upd( uint32_t ) const;
+
+    user_reactor *ur_;
+    uint64_t      uid_;
+    uint64_t      num_fwd_; // forwarded requests awaiting reply
+  };
+
+  // worker thread servicing publisher connections on its own net_loop
+  class user_reactor : public error
+  {
+  public:
+
+    typedef enum {
+      e_add_user = 0, // manager -> reactor: new client socket
+      e_send,         // manager -> reactor: outbound message
+      e_done,         // manager -> reactor: forwarded request answered
+      e_upd_price,    // reactor -> manager: validated price update
+      e_request,      // reactor -> manager: request for manager-side user
+      e_del_user      // reactor -> manager: connection closed
+    } msg_type_t;
+
+    struct msg {
+      msg_type_t     type_;
+      uint64_t       id_;
+      int            fd_;
+      price         *px_[2];
+      int64_t        price_;
+      uint64_t       conf_;
+      symbol_status  st_;
+      std::string    buf_;
+    };
+
+    user_reactor();
+    ~user_reactor();
+
+    // associated manager
+    void set_manager( manager * );
+    manager *get_manager() const;
+
+    // start reactor thread
+    bool init();
+
+    // stop reactor thread and close all its connections
+    void teardown();
+
+    // manager thread: hand new client socket to reactor
+    void add_user( uint64_t id, int fd );
+
+    // manager thread: queue message to client
+    void send( uint64_t id, net_wtr& );
+
+    // manager thread: reply to forwarded request has been sent
+    void done( uint64_t id );
+
+    // manager thread: next message from reactor
+    bool pop( msg& );
+
+    // manager thread: push queued messages and wake reactor
+    void flush();
+
+    // reactor thread interface
+    void run();
+    void forward( uint64_t id, const char *, size_t );
+    void upd_price( price *, price *, int64_t, uint64_t, symbol_status );
+    void del_user( reactor_user * );
+
+  private:
+
+    typedef spsc_queue<msg>                         queue_t;
+    typedef std::deque<msg>                         msg_deq_t;
+    typedef std::unordered_map<uint64_t,reactor_user*> user_map_t;
+    typedef std::vector<reactor_user*>              user_vec_t;
+
+    // eventfd used to wake up reactor thread
+    struct wake : public net_socket {
+      void poll() override;
+    };
+
+    void push_in( msg& );
+    void push_out( msg& );
+    void poll_in();
+    void flush_out();
+    void teardown_users();
+
+    manager          *mgr_;
+    net_loop          nl_;     // reactor event loop
+    wake              wk_;     // wake-up eventfd
+    std::thread       thrd_;   // reactor thread
+    std::atomic<bool> is_run_; // keep running flag
+    queue_t           in_;     // manager -> reactor
+    queue_t           out_;    // reactor -> manager
+    msg_deq_t         inq_;    // in_ overflow (manager thread)
+    msg_deq_t         outq_;   // out_ overflow (reactor thread)
+    bool              is_wk_;  // wake-up required (manager thread)
+    user_map_t        umap_;   // open users by id
+    user_vec_t        dvec_;   // users to delete
+  };
+
+}
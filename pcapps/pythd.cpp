@@ -37,6 +37,14 @@ int usage()
             << std::endl;
   std::cerr << "     Host name or IP address of solana rpc node in the form "
                "host_name[:rpc_port[:ws_port]]\n" << std::endl;
+  std::cerr << "  -e <rpc_host>" << std::endl;
+  std::cerr << "     Additional solana rpc node in the form host_name[:rpc_port]"
+               " that slot, block hash and transaction requests are hedged "
+               "across. May be repeated\n" << std::endl;
+  std::cerr << "  -P <symbol>" << std::endl;
+  std::cerr << "     Symbol whose price updates are sent ahead of others when "
+               "more updates wait than fit in a batch. May be repeated\n"
+            << std::endl;
   std::cerr << "  -t <tx proxy host (default " << get_tx_host() << ")>"
             << std::endl;
   std::cerr << "     Host name or IP address of running pyth_tx server\n"
@@ -66,6 +74,23 @@ int usage()
   std::cerr << "  -z" << std::endl;
   std::cerr << "     Disable WebSocket connection to Solana RPC node"
                "\n" << std::endl;
+  std::cerr << "  -q" << std::endl;
+  std::cerr << "     Use io_uring for socket polling. Falls back to epoll if "
+               "not supported by the kernel\n" << std::endl;
+  std::cerr << "  -g" << std::endl;
+  std::cerr << "     Allocate network buffers from 2MB hugepages where "
+               "available\n" << std::endl;
+  std::cerr << "  -a" << std::endl;
+  std::cerr << "     Warm start from an account cache kept in the key store "
+               "directory. Cached prices are published only while "
+               "less than 150 slots old until refreshed from the rpc "
+               "node\n" << std::endl;
+  std::cerr << "  -j <num_threads>" << std::endl;
+  std::cerr << "     Number of worker threads servicing publisher connections "
+               "(default 0 - serviced by main thread)\n" << std::endl;
+  std::cerr << "  -y <num_threads>" << std::endl;
+  std::cerr << "     Number of worker threads signing price update transactions "
+               "(default 0 - signed by main thread)\n" << std::endl;
   std::cerr << "  -m <commitment_level>" << std::endl;
   std::cerr << "     Subscription commitment level: processed, confirmed or "
                "finalized\n" << std::endl;
@@ -103,6 +128,8 @@ int main(int argc, char **argv)
   std::string cnt_dir, cap_file, log_file;
   std::string rpc_host = get_rpc_host();
   std::string secondary_rpc_host = "";
+  std::vector<std::string> hedge_hosts;
+  std::vector<std::string> prio_syms;
   std::string key_dir  = get_key_store();
   std::string tx_host  = get_tx_host();
   int pyth_port = get_port();
@@ -112,10 +139,14 @@ int main(int argc, char **argv)
   unsigned cu_price = 0;
   unsigned max_batch_size = 0;
   bool do_wait = true, do_tx = true, do_ws = true, do_debug = false;
-  while( (opt = ::getopt(argc,argv, "r:s:t:p:i:k:w:c:l:m:b:u:v:dnxhz" )) != -1 ) {
+  bool do_uring = false, do_cache = false;
+  unsigned num_rtr = 0, num_sgn = 0;
+  while( (opt = ::getopt(argc,argv, "r:e:s:P:t:p:i:k:w:c:l:m:b:u:v:j:y:adgnqxhz" )) != -1 ) {
     switch(opt) {
       case 'r': rpc_host = optarg; break;
+      case 'e': hedge_hosts.push_back( optarg ); break;
       case 's': secondary_rpc_host = optarg; break;
+      case 'P': prio_syms.push_back( optarg ); break;
       case 't': tx_host = optarg; break;
       case 'p': pyth_port = ::atoi(optarg); break;
       case 'i': pub_int = ::atoi(optarg); break;
@@ -126,6 +157,11 @@ int main(int argc, char **argv)
       case 'm': cmt = str_to_commitment(optarg); break;
       case 'b': max_batch_size = strtoul(optarg, NULL, 0); break;
       case 'n': do_wait = false; break;
+      case 'q': do_uring = true; break;
+      case 'g': net_buf::set_use_hugepage( true ); break;
+      case 'j': num_rtr = strtoul(optarg, NULL, 0); break;
+      case 'y': num_sgn = strtoul(optarg, NULL, 0); break;
+      case 'a': do_cache = true; break;
       case 'x': do_tx = false; break;
       case 'z': do_ws = false; break;
       case 'd': do_debug = true; break;
@@ -152,17 +188,27 @@ int main(int argc, char **argv)
   manager mgr;
   mgr.set_dir( key_dir );
   mgr.set_rpc_host( rpc_host );
+  for( const std::string& host: hedge_hosts ) {
+    mgr.add_rpc_hedge_host( host );
+  }
   mgr.set_tx_host( tx_host );
   mgr.set_listen_port( pyth_port );
   mgr.set_content_dir( cnt_dir );
   mgr.set_capture_file( cap_file );
   mgr.set_do_tx( do_tx );
   mgr.set_do_ws( do_ws );
+  mgr.set_do_uring( do_uring );
+  mgr.set_num_reactor( num_rtr );
+  mgr.set_num_signer( num_sgn );
+  mgr.set_do_cache( do_cache );
   mgr.set_do_capture( !cap_file.empty() );
   mgr.set_commitment( cmt );
   mgr.set_publish_interval( pub_int );
   mgr.set_requested_upd_price_cu_units( cu_units );
   mgr.set_requested_upd_price_cu_price( cu_price );
+  for( const std::string& sym: prio_syms ) {
+    mgr.add_priority_symbol( sym );
+  }
 
   bool do_secondary = !secondary_rpc_host.empty();
   if ( do_secondary ) {
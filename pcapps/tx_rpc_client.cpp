@@ -138,33 +138,3 @@ void rpc::get_slot_leaders::response( const jtree& jt )
   }
   on_response( this );
 }
-
-///////////////////////////////////////////////////////////////////////////
-// slot_subscribe
-
-uint64_t rpc::slot_subscribe::get_slot() const
-{
-  return slot_;
-}
-
-void rpc::slot_subscribe::request( json_wtr& msg )
-{
-  msg.add_key( "method", "slotSubscribe" );
-}
-
-void rpc::slot_subscribe::response( const jtree& jt )
-{
-  if ( on_error( jt, this ) ) return;
-  // add to notification list
-  add_notify( jt );
-}
-
-bool rpc::slot_subscribe::notify( const jtree& jt )
-{
-  if ( on_error( jt, this ) ) return true;
-  uint32_t ptok = jt.find_val( 1, "params" );
-  uint32_t rtok = jt.find_val( ptok, "result" );
-  slot_ = jt.get_uint( jt.find_val( rtok, "slot" ) );
-  on_response( this );
-  return false; // keep notification
-}
@@ -58,18 +58,6 @@ namespace pc {
       ldr_vec_t lvec_;
     };
 
-    // find out when slots update
-    class slot_subscribe : public rpc_subscription
-    {
-    public:
-      uint64_t get_slot() const;
-      void request( json_wtr& ) override;
-      void response( const jtree& ) override;
-      bool notify( const jtree& ) override;
-    private:
-      uint64_t slot_;
-    };
-
   }
 
 }
@@ -0,0 +1,61 @@
+#include <pc/misc.hpp>
+#include <iostream>
+#include <unistd.h>
+
+using namespace pc;
+
+typedef int (*enc_fn)( const uint8_t *, int, char *, int );
+typedef int (*dec_fn)( const uint8_t *, int, uint8_t * );
+
+static void bench( const char *name, int len, unsigned num,
+                   enc_fn enc, dec_fn dec )
+{
+  uint8_t src[64], dst[128];
+  char txt[128];
+  for( int i=0; i != len; ++i ) {
+    src[i] = (uint8_t)( i * 37 + 11 );
+  }
+  uint64_t sum = 0;
+  int tlen = 0;
+  int64_t ts = get_now();
+  for( unsigned i=0; i != num; ++i ) {
+    src[i % (unsigned)len] ^= (uint8_t)i;
+    tlen = enc( src, len, txt, sizeof( txt ) );
+    sum += (uint8_t)txt[tlen/2];
+  }
+  int64_t te = get_now();
+  for( unsigned i=0; i != num; ++i ) {
+    sum += (unsigned)dec( (const uint8_t*)txt, tlen, dst );
+  }
+  int64_t td = get_now();
+  std::cout << name << " " << len << " bytes: encode "
+            << (double)( te - ts ) / num << " ns, decode "
+            << (double)( td - te ) / num << " ns" << std::endl;
+  if ( sum == 0 ) {
+    std::cout << "unexpected result" << std::endl;
+  }
+}
+
+int usage()
+{
+  std::cerr << "usage: bench_base58 [options]" << std::endl;
+  std::cerr << "  -n <number of iterations (default 1000000)>" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  unsigned num = 1000000;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "n:h" )) != -1 ) {
+    switch(opt) {
+      case 'n': num = (unsigned)::atoi(optarg); break;
+      default: return usage();
+    }
+  }
+  for( int len: { 32, 64 } ) {
+    bench( "generic", len, num, enc_base58_generic, dec_base58_generic );
+    bench( "fixed  ", len, num, enc_base58, dec_base58 );
+  }
+  return 0;
+}
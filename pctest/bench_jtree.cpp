@@ -0,0 +1,128 @@
+#include <pc/jtree.hpp>
+#include <pc/mem_map.hpp>
+#include <pc/misc.hpp>
+#include <iostream>
+#include <unistd.h>
+#include <string>
+
+using namespace pc;
+
+// synthetic programSubscribe notification with num accounts
+static std::string gen_msg( unsigned num )
+{
+  std::string msg = "{\"jsonrpc\":\"2.0\",\"method\":\"programNotification\","
+    "\"params\":{\"result\":{\"context\":{\"slot\":123456789},\"value\":[";
+  std::string data( 3200, 'A' );
+  for( unsigned i=0; i != 64; ++i ) {
+    data[i*50] = (char)( 'a' + i % 26 );
+  }
+  for( unsigned i=0; i != num; ++i ) {
+    if ( i ) msg += ',';
+    msg += "{\"pubkey\":\"7FGk4P3zUXJpcBZ8dKxwVyhSu2ZpqRTc3a9XwdgjVxS";
+    msg += std::to_string( i );
+    msg += "\",\"account\":{\"data\":[\"" + data + "\",\"base64\"],"
+      "\"executable\":false,\"lamports\":23942400,"
+      "\"owner\":\"FsJ3A3u2vn5cTVofAjvy6y5kwABJAqYWpe4975bi2epH\","
+      "\"rentEpoch\":361, \"space\": 3312}}";
+  }
+  msg += "]},\"subscription\":0}}";
+  return msg;
+}
+
+static void bench( const std::string& msg, jtree::simd_t simd, unsigned num )
+{
+  static const char *name[] = { "scalar", "sse4.2", "avx2" };
+  jtree::set_simd( simd );
+  if ( jtree::get_simd() != simd ) {
+    std::cout << name[simd] << ": not supported" << std::endl;
+    return;
+  }
+  jtree jt;
+  int64_t ts = get_now();
+  for( unsigned i=0; i != num; ++i ) {
+    jt.parse( msg.data(), msg.size() );
+  }
+  int64_t te = get_now();
+  double secs = 1e-9 * (double)( te - ts );
+  std::cout << name[simd] << ": "
+            << 1e-6 * (double)( msg.size() * num ) / secs << " MB/s "
+            << (double)( te - ts ) / num << " ns/msg" << std::endl;
+}
+
+// notification field lookups by key string vs cached paths
+static void bench_find( const std::string& msg, unsigned num )
+{
+  jtree jt;
+  jt.parse( msg.data(), msg.size() );
+  uint64_t sum = 0;
+  int64_t ts = get_now();
+  for( unsigned i=0; i != num; ++i ) {
+    uint32_t ptok = jt.find_val( 1, "params" );
+    uint32_t rtok = jt.find_val( ptok, "result" );
+    uint32_t ctok = jt.find_val( rtok, "context" );
+    sum += jt.get_uint( jt.find_val( ctok, "slot" ) );
+    uint32_t vtok = jt.find_val( rtok, "value" );
+    uint32_t atok = jt.find_val( jt.get_last( vtok ), "account" );
+    sum += jt.get_uint( jt.find_val( atok, "lamports" ) );
+  }
+  int64_t te = get_now();
+  jpath p_res{ "params", "result" }, p_slot{ "context", "slot" };
+  jpath p_val{ "value" }, p_lam{ "account", "lamports" };
+  for( unsigned i=0; i != num; ++i ) {
+    uint32_t rtok = jt.find_val( 1, p_res );
+    sum += jt.get_uint( jt.find_val( rtok, p_slot ) );
+    uint32_t vtok = jt.find_val( rtok, p_val );
+    sum += jt.get_uint( jt.find_val( jt.get_last( vtok ), p_lam ) );
+  }
+  int64_t tp = get_now();
+  std::cout << "find_val(str): " << (double)( te - ts ) / num
+            << " ns/msg" << std::endl;
+  std::cout << "find_val(jpath): " << (double)( tp - te ) / num
+            << " ns/msg" << std::endl;
+  if ( sum == 0 ) {
+    std::cout << "unexpected lookup result" << std::endl;
+  }
+}
+
+int usage()
+{
+  std::cerr << "usage: bench_jtree [options]" << std::endl;
+  std::cerr << "  -f <json file (default synthetic programNotification)>"
+            << std::endl;
+  std::cerr << "  -n <number of iterations (default 10000)>" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  std::string file;
+  unsigned num = 10000;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "f:n:h" )) != -1 ) {
+    switch(opt) {
+      case 'f': file = optarg; break;
+      case 'n': num = (unsigned)::atoi(optarg); break;
+      default: return usage();
+    }
+  }
+  std::string msg;
+  if ( !file.empty() ) {
+    mem_map mp;
+    mp.set_file( file );
+    if ( !mp.init() ) {
+      std::cerr << "bench_jtree: failed to read " << file << std::endl;
+      return 1;
+    }
+    msg.assign( mp.data(), mp.size() );
+  } else {
+    msg = gen_msg( 8 );
+  }
+  std::cout << "message size: " << msg.size() << " bytes" << std::endl;
+  bench( msg, jtree::e_scalar, num );
+  bench( msg, jtree::e_sse42, num );
+  bench( msg, jtree::e_avx2, num );
+  if ( file.empty() ) {
+    bench_find( msg, num );
+  }
+  return 0;
+}
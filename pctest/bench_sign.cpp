@@ -0,0 +1,115 @@
+#include <pc/key_pair.hpp>
+#include <pc/misc.hpp>
+#include <openssl/evp.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace pc;
+
+// signing as done before key_cache held an expanded key
+static void sign_openssl( const key_pair& kp, uint8_t *msg, size_t len,
+                          unsigned num )
+{
+  EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key( EVP_PKEY_ED25519,
+      NULL, kp.data(), pub_key::len );
+  uint8_t sig[signature::len];
+  for( unsigned i=0; i != num; ++i ) {
+    msg[0] = (uint8_t)i;
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new();
+    EVP_DigestSignInit( mctx, NULL, NULL, NULL, pkey );
+    size_t sig_len = signature::len;
+    EVP_DigestSign( mctx, sig, &sig_len, msg, len );
+    EVP_MD_CTX_free( mctx );
+  }
+  EVP_PKEY_free( pkey );
+}
+
+static void sign_key_pair( const key_pair& kp, uint8_t *msg, size_t len,
+                           unsigned num )
+{
+  signature sig;
+  for( unsigned i=0; i != num; ++i ) {
+    msg[0] = (uint8_t)i;
+    sig.sign( msg, (uint32_t)len, kp );
+  }
+}
+
+static void sign_key_cache( const key_pair& kp, uint8_t *msg, size_t len,
+                            unsigned num )
+{
+  key_cache kc;
+  kc.set( kp );
+  signature sig;
+  for( unsigned i=0; i != num; ++i ) {
+    msg[0] = (uint8_t)i;
+    sig.sign( msg, (uint32_t)len, kc );
+  }
+}
+
+typedef void (*sign_fn)( const key_pair&, uint8_t *, size_t, unsigned );
+
+static void run( sign_fn fn, const key_pair *kp, size_t len, unsigned num )
+{
+  std::vector<uint8_t> msg( len, 0x5a );
+  fn( *kp, msg.data(), len, num );
+}
+
+static void bench( const char *name, sign_fn fn, const key_pair& kp,
+                   size_t len, unsigned num, unsigned nthr )
+{
+  std::vector<std::thread> tvec;
+  int64_t ts = get_now();
+  for( unsigned i=0; i != nthr; ++i ) {
+    tvec.emplace_back( run, fn, &kp, len, num );
+  }
+  for( std::thread& thrd: tvec ) {
+    thrd.join();
+  }
+  int64_t dt = get_now() - ts;
+  double per_sec = 1e9 * (double)num * nthr / (double)dt;
+  std::cout << name << " " << len << " bytes: "
+            << (double)dt / num << " ns/sig, "
+            << per_sec / nthr << " sig/s/core, "
+            << per_sec << " sig/s total" << std::endl;
+}
+
+int usage()
+{
+  std::cerr << "usage: bench_sign [options]" << std::endl;
+  std::cerr << "  -n <number of signatures per thread (default 20000)>"
+            << std::endl;
+  std::cerr << "  -t <number of threads (default 1)>" << std::endl;
+  std::cerr << "  -l <message length (default 512)>" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  unsigned num = 20000, nthr = 1;
+  size_t len = 512;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "n:t:l:h" )) != -1 ) {
+    switch(opt) {
+      case 'n': num = (unsigned)::atoi(optarg); break;
+      case 't': nthr = (unsigned)::atoi(optarg); break;
+      case 'l': len = (size_t)::atoi(optarg); break;
+      default: return usage();
+    }
+  }
+  if ( !num || !nthr || !len ) {
+    return usage();
+  }
+  key_pair kp;
+  kp.gen();
+
+  // build base point table before timing
+  key_cache kc;
+  kc.set( kp );
+
+  bench( "openssl  ", sign_openssl, kp, len, num, nthr );
+  bench( "key_pair ", sign_key_pair, kp, len, num, nthr );
+  bench( "key_cache", sign_key_cache, kp, len, num, nthr );
+  return 0;
+}
@@ -2,7 +2,15 @@
 #include <pc/net_socket.hpp>
 #include <pc/net_socket.hpp>
 #include <pc/misc.hpp>
+#include <pc/rpc_client.hpp>
+#include <pc/rpc_endpoint.hpp>
+#include <pc/manager.hpp>
+#include <zstd.h>
 #include <iostream>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <thread>
+#include <atomic>
 
 using namespace pc;
 
@@ -58,6 +66,114 @@ void test_net_buf()
   }
 }
 
+void test_net_buf_alloc()
+{
+  static const size_t num = 10000;
+  net_buf_stats st0, st1, st2;
+  net_buf::set_high_water( 1024 );
+  net_buf::get_stats( st0 );
+
+  // allocate on worker thread and release on this one
+  std::vector<net_buf*> vec;
+  std::thread thrd( [&vec]() {
+    for( size_t i=0; i != num; ++i ) {
+      net_buf *ptr = net_buf::alloc();
+      ptr->size_ = 1;
+      vec.push_back( ptr );
+    }
+  } );
+  thrd.join();
+  net_buf::get_stats( st1 );
+  PC_TEST_CHECK( st1.num_alloc_ - st0.num_alloc_ >= num );
+  PC_TEST_CHECK( st1.num_peak_ >= num );
+  for( net_buf *ptr: vec ) {
+    PC_TEST_CHECK( ptr->size_ == 1 && !ptr->next_ );
+    ptr->dealloc();
+  }
+
+  // memory above high-water mark released back to the system
+  net_buf::get_stats( st2 );
+  PC_TEST_CHECK( st2.num_rel_ - st1.num_rel_ >= num - 2048 );
+  PC_TEST_CHECK( st2.num_depot_ <= 1024 + 64 );
+  PC_TEST_CHECK( st2.num_sys_ - st2.num_rel_ <= 2048 );
+
+  // buffers now served from depot and thread cache
+  net_buf *ptr = net_buf::alloc();
+  ptr->dealloc();
+  net_buf::get_stats( st1 );
+  PC_TEST_CHECK( st1.num_sys_ == st2.num_sys_ );
+
+  // heap buffers still released with hugepage slabs enabled
+  net_buf::set_use_hugepage( true );
+  vec.clear();
+  for( size_t i=0; i != num; ++i ) {
+    vec.push_back( net_buf::alloc() );
+  }
+  net_buf::get_stats( st1 );
+  for( net_buf *ptr: vec ) {
+    ptr->dealloc();
+  }
+  net_buf::get_stats( st2 );
+  uint64_t num_slab = st2.num_huge_ * ( ( 2UL << 20 ) / sizeof( net_buf ) );
+  PC_TEST_CHECK( st2.num_rel_ - st1.num_rel_ + num_slab >= num - 2048 );
+  net_buf::set_use_hugepage( false );
+
+  // thread that only frees buffers hands them back on exit
+  net_buf::set_high_water( 1UL << 14 );
+  vec.clear();
+  for( size_t i=0; i != 1000; ++i ) {
+    vec.push_back( net_buf::alloc() );
+  }
+  net_buf::get_stats( st1 );
+  std::thread thrd2( [&vec]() {
+    for( net_buf *ptr: vec ) {
+      ptr->dealloc();
+    }
+  } );
+  thrd2.join();
+  net_buf::get_stats( st2 );
+  PC_TEST_CHECK( st2.num_depot_ - st1.num_depot_ +
+                 st2.num_rel_ - st1.num_rel_ == 1000 );
+}
+
+void test_net_buf_stress()
+{
+  // threads popping from the depot while others release magazines
+  // above a low high-water mark. buffers must never be shared
+  static const unsigned num_thrd = 4, num_iter = 2000, num_buf = 300;
+  net_buf_stats st0, st1;
+  net_buf::set_high_water( 256 );
+  net_buf::get_stats( st0 );
+  std::atomic<unsigned> num_bad( 0 );
+  std::vector<std::thread> tvec;
+  for( unsigned t = 0; t != num_thrd; ++t ) {
+    tvec.emplace_back( [&num_bad,t]() {
+      std::vector<net_buf*> vec;
+      for( unsigned i = 0; i != num_iter; ++i ) {
+        unsigned num = 1 + ( i * 37 + t * 101 ) % num_buf;
+        for( unsigned j = 0; j != num; ++j ) {
+          net_buf *ptr = net_buf::alloc();
+          ptr->size_ = (uint16_t)( t + 1 );
+          vec.push_back( ptr );
+        }
+        for( net_buf *ptr: vec ) {
+          num_bad += ptr->size_ != t + 1;
+          ptr->dealloc();
+        }
+        vec.clear();
+      }
+    } );
+  }
+  for( std::thread& thrd: tvec ) {
+    thrd.join();
+  }
+  net_buf::get_stats( st1 );
+  PC_TEST_CHECK( num_bad == 0 );
+  PC_TEST_CHECK( st1.num_rel_ > st0.num_rel_ );
+  PC_TEST_CHECK( st1.num_depot_ <= 256 + num_thrd * 64 );
+  net_buf::set_high_water( 1UL << 14 );
+}
+
 void test_json_wtr()
 {
   {
@@ -124,12 +240,819 @@ void test_enc()
   PC_TEST_CHECK( -954 == str_to_dec( "-0.000954000", -6 ) );
 }
 
+void test_base64()
+{
+  // known vectors
+  char ebuf[256];
+  std::string txt = "Man is distinguished, not only by his reason";
+  size_t elen = enc_base64( (const uint8_t*)txt.data(), (int)txt.size(), ebuf );
+  PC_TEST_CHECK( std::string( ebuf, elen ) ==
+      "TWFuIGlzIGRpc3Rpbmd1aXNoZWQsIG5vdCBvbmx5IGJ5IGhpcyByZWFzb24=" );
+  PC_TEST_CHECK( elen == enc_base64_len( txt.size() ) );
+
+  // simd implementations match scalar for all lengths and alignments
+  unsigned prev = get_base64_simd();
+  uint8_t src[200];
+  uint32_t seed = 1;
+  for( size_t i=0; i != sizeof( src ); ++i ) {
+    seed = seed * 1103515245 + 12345;
+    src[i] = (uint8_t)( seed >> 16 );
+  }
+  bool is_ok = true;
+  for( unsigned simd = 1; simd != 3; ++simd ) {
+    for( int len = 0; len != 120; ++len ) {
+      for( int off = 0; off != 5; ++off ) {
+        char e0[256], e1[256];
+        uint8_t d0[256], d1[256];
+        set_base64_simd( 0 );
+        size_t l0 = enc_base64( &src[off], len, e0 );
+        set_base64_simd( simd );
+        size_t l1 = enc_base64( &src[off], len, e1 );
+        is_ok = is_ok && l0 == l1 && 0 == __builtin_memcmp( e0, e1, l0 );
+        size_t k0 = dec_base64( e1, (int)l1, d1 );
+        is_ok = is_ok && (int)k0 == len &&
+          0 == __builtin_memcmp( d1, &src[off], k0 );
+
+        // corrupt one character (may be padding or invalid)
+        e1[ (size_t)( len * 7 + off ) % ( l1 ? l1 : 1 ) ] = "=!/_ "[off];
+        set_base64_simd( 0 );
+        k0 = dec_base64( e1, (int)l1, d0 );
+        set_base64_simd( simd );
+        size_t k1 = dec_base64( e1, (int)l1, d1 );
+        is_ok = is_ok && k0 == k1 && 0 == __builtin_memcmp( d0, d1, k0 );
+      }
+    }
+  }
+  PC_TEST_CHECK( is_ok );
+  set_base64_simd( prev );
+  PC_TEST_CHECK( get_base64_simd() == prev );
+}
+
+void test_account_data()
+{
+  // account data decodes straight into the target for both encodings,
+  // through the single block and the streaming paths
+  rpc_client clnt;
+  bool is_ok = true;
+  for( size_t len: { 3312UL, 100000UL } ) {
+    std::vector<uint8_t> src( len ), zbuf( ZSTD_compressBound( len ) );
+    uint32_t seed = (uint32_t)len;
+    for( size_t i=0; i != len; ++i ) {
+      seed = seed * 1103515245 + 12345;
+      src[i] = (uint8_t)( i % 7 ? seed >> 16 : i );
+    }
+    size_t zlen = ZSTD_compress( &zbuf[0], zbuf.size(), &src[0], len, 1 );
+    std::vector<char> zenc( enc_base64_len( zlen ) ), enc( enc_base64_len( len ) );
+    zenc.resize( enc_base64( &zbuf[0], (int)zlen, &zenc[0] ) );
+    enc.resize( enc_base64( &src[0], (int)len, &enc[0] ) );
+    std::vector<char> tgt( len + 16 );
+    is_ok = is_ok && len == clnt.get_data_val(
+        &zenc[0], zenc.size(), true, tgt.size(), &tgt[0] ) &&
+      0 == __builtin_memcmp( &tgt[0], &src[0], len );
+    tgt.assign( tgt.size(), 0 );
+    is_ok = is_ok && len == clnt.get_data_val(
+        &enc[0], enc.size(), false, tgt.size(), &tgt[0] ) &&
+      0 == __builtin_memcmp( &tgt[0], &src[0], len );
+
+    // truncated to target size
+    tgt.assign( tgt.size(), 0 );
+    is_ok = is_ok && 1001 == clnt.get_data_val(
+        &enc[0], enc.size(), false, 1001, &tgt[0] ) &&
+      0 == __builtin_memcmp( &tgt[0], &src[0], 1001 ) && tgt[1001] == 0;
+
+    // truncated frame
+    is_ok = is_ok && 0 == clnt.get_data_val(
+        &zenc[0], zenc.size() / 8 * 4, true, tgt.size(), &tgt[0] );
+  }
+  PC_TEST_CHECK( is_ok );
+}
+
+class test_acc_sub : public rpc_sub,
+                     public rpc_sub_i<rpc::account_update>
+{
+public:
+  void on_response( rpc::account_update *res ) override {
+    char val = 0;
+    res->get_data_val( &val, 1 );
+    upd_.push_back( std::make_pair( res->get_slot(), val ) );
+  }
+  std::vector<std::pair<uint64_t,char>> upd_;
+};
+
+static void notify_account(
+    rpc::program_subscribe& req, const char *acc, uint64_t slot, char val )
+{
+  // single byte of account data in plain base64
+  char data[8];
+  data[ enc_base64( (const uint8_t*)&val, 1, data ) ] = '\0';
+  std::string msg = std::string( "{\"jsonrpc\":\"2.0\","
+      "\"method\":\"programNotification\",\"params\":{\"result\":{"
+      "\"context\":{\"slot\":" ) + std::to_string( slot ) + "},"
+      "\"value\":{\"pubkey\":\"" + acc + "\",\"account\":{"
+      "\"data\":[\"" + data + "\",\"base64\"],\"lamports\":1}}},"
+      "\"subscription\":1}}";
+  jtree jt;
+  jt.parse( msg.c_str(), msg.size() );
+  req.notify( jt );
+}
+
+void test_program_subscribe()
+{
+  const char *acc1 = "9vNb2tQoZ8bB4vzMbQLWViGwNaDJCNTrYxsHPoRjWuVh";
+  const char *acc2 = "BNvwMCQRe5Dn5PCTVfMJD5Kv5JW8R6nDDxsNKSgmvCLU";
+  rpc_client clnt;
+  test_acc_sub sub;
+  rpc::program_subscribe req;
+  req.set_rpc_client( &clnt );
+  req.set_sub( &sub );
+
+  // stale and repeated slots are dropped
+  notify_account( req, acc1, 10, 'a' );
+  notify_account( req, acc1, 9, 'b' );
+  notify_account( req, acc1, 10, 'c' );
+  notify_account( req, acc1, 11, 'd' );
+  PC_TEST_CHECK( sub.upd_.size() == 2 );
+  PC_TEST_CHECK( sub.upd_[1] == std::make_pair( 11UL, 'd' ) );
+  PC_TEST_CHECK( req.get_num_stale() == 2 );
+
+  // coalesced updates apply the latest per account on flush
+  sub.upd_.clear();
+  req.set_coalesce( true );
+  notify_account( req, acc1, 12, 'e' );
+  notify_account( req, acc2, 12, 'f' );
+  notify_account( req, acc1, 13, 'g' );
+  notify_account( req, acc1, 12, 'h' );
+  PC_TEST_CHECK( sub.upd_.empty() );
+  req.flush();
+  PC_TEST_CHECK( sub.upd_.size() == 2 );
+  PC_TEST_CHECK( sub.upd_[0] == std::make_pair( 13UL, 'g' ) );
+  PC_TEST_CHECK( sub.upd_[1] == std::make_pair( 12UL, 'f' ) );
+  PC_TEST_CHECK( req.get_num_coalesce() == 1 );
+  PC_TEST_CHECK( req.get_num_stale() == 3 );
+  req.flush();
+  PC_TEST_CHECK( sub.upd_.size() == 2 );
+}
+
+class test_multi_sub : public rpc_sub,
+                       public rpc_sub_i<rpc::get_multiple_accounts>
+{
+public:
+  void on_response( rpc::get_multiple_accounts *res ) override {
+    char val = 0;
+    size_t len = res->get_data_val( &val, 1 );
+    upd_.push_back( std::make_pair( *res->get_account(), len ? val : 0 ) );
+    ec_.push_back( res->get_is_err() ? res->get_err_code() : 0 );
+  }
+  std::vector<std::pair<pub_key,char>> upd_;
+  std::vector<int> ec_;
+};
+
+void test_get_multiple_accounts()
+{
+  pub_key acc1, acc2;
+  acc1.init_from_text( std::string( "9vNb2tQoZ8bB4vzMbQLWViGwNaDJCNTrYxsHPoRjWuVh" ) );
+  acc2.init_from_text( std::string( "BNvwMCQRe5Dn5PCTVfMJD5Kv5JW8R6nDDxsNKSgmvCLU" ) );
+  rpc_client clnt;
+  test_multi_sub sub;
+  rpc::get_multiple_accounts req;
+  req.set_rpc_client( &clnt );
+  req.set_sub( &sub );
+  req.add_account( acc1 );
+  req.add_account( acc2 );
+  PC_TEST_CHECK( req.get_num_accounts() == 2 );
+
+  // request lists every account
+  json_wtr wtr;
+  wtr.add_val( json_wtr::e_obj );
+  req.request( wtr );
+  wtr.pop();
+  std::string msg;
+  net_buf *hd, *tl;
+  wtr.detach( hd, tl );
+  for( net_buf *ptr = hd; ptr; ) {
+    net_buf *nxt = ptr->next_;
+    msg.append( ptr->buf_, ptr->size_ );
+    ptr->dealloc();
+    ptr = nxt;
+  }
+  PC_TEST_CHECK( msg.find( "\"getMultipleAccounts\"" ) != std::string::npos );
+  PC_TEST_CHECK( msg.find( "[[\"9vNb2tQoZ8bB4vzMbQLWViGwNaDJCNTrYxsHPoRjWuVh\","
+        "\"BNvwMCQRe5Dn5PCTVfMJD5Kv5JW8R6nDDxsNKSgmvCLU\"]" ) != std::string::npos );
+
+  // results dispatched once per account in request order
+  std::string rsp = "{\"jsonrpc\":\"2.0\",\"result\":{\"context\":"
+    "{\"slot\":42},\"value\":[null,{\"data\":[\"eA==\",\"base64\"],"
+    "\"lamports\":7}]},\"id\":1}";
+  jtree jt;
+  jt.parse( rsp.c_str(), rsp.size() );
+  req.response( jt );
+  PC_TEST_CHECK( sub.upd_.size() == 2 );
+  PC_TEST_CHECK( sub.upd_[0].first == acc1 && sub.upd_[0].second == 0 );
+  PC_TEST_CHECK( sub.upd_[1].first == acc2 && sub.upd_[1].second == 'x' );
+  PC_TEST_CHECK( req.get_slot() == 42UL && req.get_lamports() == 7UL );
+
+  // missing accounts fail on their own
+  PC_TEST_CHECK( sub.ec_[0] == PC_RPC_ERROR_NOT_FOUND && sub.ec_[1] == 0 );
+  PC_TEST_CHECK( !req.get_is_err() );
+
+  // sliced requests ask for plain base64
+  PC_TEST_CHECK( msg.find( "\"base64+zstd\"" ) != std::string::npos );
+  req.set_data_slice( 0UL, 56UL );
+  PC_TEST_CHECK( req.get_data_slice_len() == 56UL );
+  json_wtr swtr;
+  swtr.add_val( json_wtr::e_obj );
+  req.request( swtr );
+  swtr.pop();
+  msg.clear();
+  swtr.detach( hd, tl );
+  for( net_buf *ptr = hd; ptr; ) {
+    net_buf *nxt = ptr->next_;
+    msg.append( ptr->buf_, ptr->size_ );
+    ptr->dealloc();
+    ptr = nxt;
+  }
+  PC_TEST_CHECK( msg.find( "\"dataSlice\":{\"offset\":0,\"length\":56}" )
+      != std::string::npos );
+  PC_TEST_CHECK( msg.find( "\"base64+zstd\"" ) == std::string::npos );
+}
+
+void test_rpc_inflight()
+{
+  // websocket requests without a connection are tracked but not sent
+  rpc_client clnt;
+  rpc::slot_subscribe req1, req2;
+  clnt.send( &req1 );
+  clnt.send( &req2 );
+  PC_TEST_CHECK( req1.get_id() == 1UL && req2.get_id() == 2UL );
+  PC_TEST_CHECK( clnt.get_num_inflight() == 2UL );
+  rpc_client::stats_vec_t svec;
+  clnt.get_stats( svec );
+  PC_TEST_CHECK( svec.size() == 1 );
+  PC_TEST_CHECK( svec[0].method_ == "slot_subscribe" );
+  PC_TEST_CHECK( svec[0].num_inflight_ == 2UL );
+  PC_TEST_CHECK( svec[0].sent_ts_ == req1.get_sent_time() );
+
+  // replies release the id for reuse and unknown ids are ignored
+  std::string rsp = "{\"jsonrpc\":\"2.0\",\"result\":5,\"id\":1}";
+  clnt.parse_response( rsp.c_str(), rsp.size() );
+  rsp = "{\"jsonrpc\":\"2.0\",\"result\":6,\"id\":9}";
+  clnt.parse_response( rsp.c_str(), rsp.size() );
+  PC_TEST_CHECK( clnt.get_num_inflight() == 1UL );
+  clnt.get_stats( svec );
+  PC_TEST_CHECK( svec[0].num_inflight_ == 1UL );
+  PC_TEST_CHECK( svec[0].num_reply_ == 1UL );
+  PC_TEST_CHECK( svec[0].max_ > 0L && svec[0].p99_ == svec[0].max_ );
+  PC_TEST_CHECK( svec[0].sent_ts_ == req2.get_sent_time() );
+  clnt.send( &req1 );
+  PC_TEST_CHECK( req1.get_id() == 1UL );
+  PC_TEST_CHECK( !req1.get_is_recv() && !req2.get_is_recv() );
+  clnt.reset();
+  PC_TEST_CHECK( req1.get_is_recv() && req2.get_is_recv() );
+  PC_TEST_CHECK( clnt.get_num_inflight() == 0UL );
+  clnt.get_stats( svec );
+  PC_TEST_CHECK( svec[0].num_inflight_ == 0UL && svec[0].sent_ts_ == 0L );
+
+  // retry once with a doubled deadline and then give up
+  clnt.set_timeout<rpc::slot_subscribe>( PC_NSECS_IN_SEC, 1 );
+  clnt.send( &req1 );
+  int64_t ts = req1.get_sent_time();
+  clnt.poll( ts + PC_NSECS_IN_SEC/2 );
+  PC_TEST_CHECK( req1.get_sent_time() == ts );
+  clnt.poll( ts + 3*PC_NSECS_IN_SEC/2 );
+  PC_TEST_CHECK( req1.get_sent_time() > ts && !req1.get_is_recv() );
+  ts = req1.get_sent_time();
+  clnt.poll( ts + 8*PC_NSECS_IN_SEC/5 );
+  PC_TEST_CHECK( clnt.get_num_inflight() == 1UL );
+  clnt.poll( ts + 5*PC_NSECS_IN_SEC/2 );
+  PC_TEST_CHECK( clnt.get_num_inflight() == 0UL && req1.get_is_recv() );
+  PC_TEST_CHECK( req1.get_is_err() );
+  PC_TEST_CHECK( req1.get_err_code() == PC_RPC_ERROR_TIMEOUT );
+  clnt.get_stats( svec );
+  PC_TEST_CHECK( svec[0].num_retry_ == 1UL && svec[0].num_timeout_ == 1UL );
+
+  // timed out ids are not reused for another deadline so late replies
+  // to them are dropped. the first attempt's id is released first
+  uint64_t id2 = req1.get_id();
+  PC_TEST_CHECK( id2 == 2UL );
+  clnt.poll( ts + 3*PC_NSECS_IN_SEC );
+  rpc::slot_subscribe req3, req4, req5;
+  clnt.send( &req3 );
+  clnt.send( &req4 );
+  PC_TEST_CHECK( req3.get_id() == 1UL && req4.get_id() == 3UL );
+  rsp = "{\"jsonrpc\":\"2.0\",\"result\":5,\"id\":2}";
+  clnt.parse_response( rsp.c_str(), rsp.size() );
+  PC_TEST_CHECK( clnt.get_num_inflight() == 2UL );
+  clnt.set_timeout<rpc::slot_subscribe>( 0L, 0 );
+  clnt.poll( ts + 5*PC_NSECS_IN_SEC );
+  clnt.send( &req5 );
+  PC_TEST_CHECK( req5.get_id() == id2 );
+}
+
+void test_latency_hist()
+{
+  latency_hist hist;
+  PC_TEST_CHECK( hist.get_quantile( .5 ) == 0L );
+  for( int64_t us = 1; us <= 1000; ++us ) {
+    hist.add( us * 1000L );
+  }
+  PC_TEST_CHECK( hist.get_count() == 1000UL );
+  PC_TEST_CHECK( hist.get_max() == 1000000L );
+  int64_t p50 = hist.get_quantile( .5 );
+  PC_TEST_CHECK( p50 >= 500000L && p50 <= 625000L );
+  int64_t p99 = hist.get_quantile( .99 );
+  PC_TEST_CHECK( p99 >= 990000L && p99 <= 1000000L );
+  PC_TEST_CHECK( hist.get_quantile( 1. ) == 1000000L );
+}
+
+void test_rpc_endpoint()
+{
+  // latency is a moving average and each slot of lag adds to the score
+  rpc_endpoint ep;
+  ep.add_reply( 100UL, 8L*PC_NSECS_IN_MSEC );
+  PC_TEST_CHECK( ep.get_latency() == 8L*PC_NSECS_IN_MSEC );
+  ep.add_reply( 99UL, 16L*PC_NSECS_IN_MSEC );
+  PC_TEST_CHECK( ep.get_latency() == 9L*PC_NSECS_IN_MSEC );
+  PC_TEST_CHECK( ep.get_slot() == 100UL && ep.get_num_reply() == 2UL );
+  PC_TEST_CHECK( ep.get_score( 100UL ) == ep.get_latency() );
+  PC_TEST_CHECK( ep.get_score( 102UL ) > ep.get_score( 101UL ) );
+
+  // not fresh until connected
+  PC_TEST_CHECK( !ep.get_is_fresh( 100UL, 2UL ) );
+
+  // replies to hedged transactions carry id zero and are dropped
+  rpc_client *clnt = ep.get_rpc_client();
+  std::string rsp = "{\"jsonrpc\":\"2.0\",\"result\":\"x\",\"id\":0}";
+  clnt->parse_response( rsp.c_str(), rsp.size() );
+  PC_TEST_CHECK( clnt->get_num_inflight() == 0UL );
+}
+
+void test_net_ring()
+{
+  net_ring rb;
+  PC_TEST_CHECK( rb.init( 100 ) );
+  size_t cap = rb.capacity();
+  PC_TEST_CHECK( cap >= 100 );
+  PC_TEST_CHECK( rb.space() == cap );
+
+  // fill and drain most of the ring so the next write wraps
+  __builtin_memset( rb.get_space(), 'a', cap - 10 );
+  rb.commit( cap - 10 );
+  rb.consume( cap - 10 );
+  PC_TEST_CHECK( rb.size() == 0 );
+  PC_TEST_CHECK( rb.space() == cap );
+  for( size_t i=0; i != 100; ++i ) {
+    rb.get_space()[i] = (char)i;
+  }
+  rb.commit( 100 );
+  const char *ptr = rb.get_data();
+  bool is_ok = true;
+  for( size_t i=0; i != 100; ++i ) {
+    is_ok = is_ok && ptr[i] == (char)i;
+  }
+  PC_TEST_CHECK( is_ok );
+
+  // grow keeps wrapped data intact
+  PC_TEST_CHECK( rb.grow( 2 * cap ) );
+  PC_TEST_CHECK( rb.capacity() == 2 * cap );
+  PC_TEST_CHECK( rb.size() == 100 );
+  ptr = rb.get_data();
+  for( size_t i=0; i != 100; ++i ) {
+    is_ok = is_ok && ptr[i] == (char)i;
+  }
+  PC_TEST_CHECK( is_ok );
+  rb.consume( 100 );
+  PC_TEST_CHECK( rb.size() == 0 );
+}
+
+// consume and accumulate everything received
+class test_parser : public net_parser
+{
+public:
+  bool parse( const char *buf, size_t sz, size_t& len ) override {
+    res_.append( buf, sz );
+    len = sz;
+    return true;
+  }
+  std::string res_;
+};
+
+void test_net_loop( bool use_uring )
+{
+  net_loop lp;
+  lp.set_use_uring( use_uring );
+  PC_TEST_CHECK( lp.init() );
+  PC_TEST_CHECK( !use_uring || lp.get_is_uring() );
+  int fds[2];
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+  test_parser tp;
+  net_connect conn;
+  conn.set_fd( fds[0] );
+  conn.set_block( false );
+  conn.set_net_parser( &tp );
+  conn.set_net_loop( &lp );
+  PC_TEST_CHECK( conn.init() );
+
+  // inbound
+  PC_TEST_CHECK( 5 == ::send( fds[1], "hello", 5, 0 ) );
+  for( int i=0; i != 100 && tp.res_.size() < 5; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( tp.res_ == "hello" );
+
+  // fallback when io_uring cannot queue polls keeps sockets registered
+  PC_TEST_CHECK( lp.switch_to_epoll() );
+  PC_TEST_CHECK( !lp.get_is_uring() && !conn.get_is_err() );
+  PC_TEST_CHECK( 5 == ::send( fds[1], "world", 5, 0 ) );
+  for( int i=0; i != 100 && tp.res_.size() < 10; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( tp.res_ == "helloworld" );
+
+  // outbound across multiple buffers
+  std::string out( 3000, 'x' );
+  net_wtr msg;
+  msg.add( str( out.c_str(), out.size() ) );
+  conn.add_send( msg );
+  for( int i=0; i != 100 && conn.get_is_send(); ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( !conn.get_is_send() );
+  PC_TEST_CHECK( conn.get_num_send_calls() == 1 );
+  PC_TEST_CHECK( conn.get_num_send_bytes() == 3000 );
+  char buf[4096];
+  PC_TEST_CHECK( 3000 == ::recv( fds[1], buf, sizeof( buf ), 0 ) );
+
+  // peer hang-up tears down connection
+  ::close( fds[1] );
+  for( int i=0; i != 100 && conn.get_fd() >= 0; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( conn.get_is_err() );
+  PC_TEST_CHECK( conn.get_fd() < 0 );
+}
+
+// consume complete lines only
+class test_line_parser : public net_parser
+{
+public:
+  bool parse( const char *buf, size_t sz, size_t& len ) override {
+    const char *end = (const char*)::memrchr( buf, '\n', sz );
+    if ( !end ) {
+      return false;
+    }
+    len = static_cast< size_t >( end - buf ) + 1;
+    res_.append( buf, len );
+    return true;
+  }
+  std::string res_;
+};
+
+void test_net_uring_io()
+{
+  net_loop lp;
+  lp.set_use_uring( true );
+  PC_TEST_CHECK( lp.init() );
+  PC_TEST_CHECK( lp.get_is_uring_io() );
+  int fds[2];
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+  int sbuf = 4096;
+  ::setsockopt( fds[0], SOL_SOCKET, SO_SNDBUF, &sbuf, sizeof( sbuf ) );
+  test_line_parser tp;
+  net_connect conn;
+  conn.set_fd( fds[0] );
+  conn.set_block( false );
+  conn.set_net_parser( &tp );
+  conn.set_net_loop( &lp );
+  PC_TEST_CHECK( conn.init() );
+  PC_TEST_CHECK( conn.get_in_ring() );
+
+  // partial message is kept until the rest arrives
+  PC_TEST_CHECK( 6 == ::send( fds[1], "one\ntw", 6, 0 ) );
+  for( int i=0; i != 100 && tp.res_.size() < 4; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( tp.res_ == "one\n" );
+  PC_TEST_CHECK( 2 == ::send( fds[1], "o\n", 2, 0 ) );
+  for( int i=0; i != 100 && tp.res_.size() < 8; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( tp.res_ == "one\ntwo\n" );
+
+  // poll_recv does not compete with the ring for data
+  PC_TEST_CHECK( 4 == ::send( fds[1], "six\n", 4, 0 ) );
+  conn.poll_recv();
+  PC_TEST_CHECK( tp.res_ == "one\ntwo\n" );
+  for( int i=0; i != 100 && tp.res_.size() < 12; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( tp.res_ == "one\ntwo\nsix\n" );
+
+  // queued output goes out through partial sendmsg completions and
+  // carries on through epoll after a switch mid-transfer
+  std::string out;
+  for( unsigned i=0; i != 200000; ++i ) {
+    out += (char)( 'a' + i % 23 );
+  }
+  net_wtr msg;
+  msg.add( str( out.c_str(), out.size() ) );
+  conn.add_send( msg );
+  std::string res;
+  char buf[8192];
+  for( int i=0; i != 100000 && res.size() < out.size(); ++i ) {
+    if ( i == 10 ) {
+      PC_TEST_CHECK( lp.switch_to_epoll() );
+      PC_TEST_CHECK( !conn.get_in_ring() && !conn.get_is_err() );
+    }
+    lp.poll( 0 );
+    ssize_t rc = ::recv( fds[1], buf, sizeof( buf ), MSG_DONTWAIT );
+    if ( rc > 0 ) {
+      res.append( buf, static_cast< size_t >( rc ) );
+    }
+  }
+  PC_TEST_CHECK( res == out );
+  PC_TEST_CHECK( !conn.get_is_send() );
+  PC_TEST_CHECK( conn.get_num_send_calls() > 1 );
+  PC_TEST_CHECK( conn.get_num_send_bytes() == out.size() );
+  ::close( fds[1] );
+  conn.close();
+
+  // peer hang-up tears down connection
+  net_loop lp2;
+  lp2.set_use_uring( true );
+  PC_TEST_CHECK( lp2.init() );
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+  net_connect conn2;
+  conn2.set_fd( fds[0] );
+  conn2.set_block( false );
+  conn2.set_net_parser( &tp );
+  conn2.set_net_loop( &lp2 );
+  PC_TEST_CHECK( conn2.init() );
+  ::close( fds[1] );
+  for( int i=0; i != 100 && conn2.get_fd() >= 0; ++i ) {
+    lp2.poll( 1 );
+  }
+  PC_TEST_CHECK( conn2.get_is_err() );
+  PC_TEST_CHECK( conn2.get_fd() < 0 );
+}
+
+void test_net_send()
+{
+  // large writer queue through a small socket buffer to exercise
+  // partial writes that resume in the middle of a net_buf
+  int fds[2];
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+  int sbuf = 4096;
+  ::setsockopt( fds[0], SOL_SOCKET, SO_SNDBUF, &sbuf, sizeof( sbuf ) );
+  net_connect conn;
+  conn.set_fd( fds[0] );
+  conn.set_block( false );
+  std::string out;
+  for( unsigned i=0; i != 200000; ++i ) {
+    out += (char)( 'a' + i % 23 );
+  }
+  net_wtr msg;
+  msg.add( str( out.c_str(), out.size() ) );
+  conn.add_send( msg );
+  std::string res;
+  char buf[8192];
+  for( int i=0; i != 100000 && res.size() < out.size(); ++i ) {
+    conn.poll_send();
+    ssize_t rc = ::recv( fds[1], buf, sizeof( buf ), MSG_DONTWAIT );
+    if ( rc > 0 ) {
+      res.append( buf, static_cast< size_t >( rc ) );
+    }
+  }
+  PC_TEST_CHECK( !conn.get_is_err() );
+  PC_TEST_CHECK( !conn.get_is_send() );
+  PC_TEST_CHECK( res == out );
+  PC_TEST_CHECK( conn.get_num_send_bytes() == out.size() );
+  PC_TEST_CHECK( conn.get_num_send_calls() < out.size() / net_buf::len );
+  conn.close();
+  ::close( fds[1] );
+}
+
+// consume only complete fixed-size messages
+class test_msg_parser : public net_parser
+{
+public:
+  bool parse( const char *buf, size_t sz, size_t& len ) override {
+    if ( sz < msg_len_ ) {
+      return false;
+    }
+    res_.push_back( std::string( buf, msg_len_ ) );
+    len = msg_len_;
+    return true;
+  }
+  size_t msg_len_;
+  std::vector<std::string> res_;
+};
+
+void test_net_recv()
+{
+  // messages larger than the default ring capacity force growth
+  int fds[2];
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+  test_msg_parser tp;
+  tp.msg_len_ = 100000;
+  net_connect conn;
+  conn.set_fd( fds[0] );
+  conn.set_block( false );
+  conn.set_net_parser( &tp );
+  std::string out;
+  for( unsigned i=0; i != 3 * tp.msg_len_; ++i ) {
+    out += (char)( 'a' + i % 19 );
+  }
+  ::fcntl( fds[1], F_SETFL, O_NONBLOCK );
+  size_t pos = 0;
+  for( int i=0; i != 100000 && tp.res_.size() < 3; ++i ) {
+    ssize_t rc = ::send( fds[1], &out[pos], out.size() - pos, 0 );
+    if ( rc > 0 ) {
+      pos += static_cast< size_t >( rc );
+    }
+    conn.poll_recv();
+  }
+  PC_TEST_CHECK( !conn.get_is_err() );
+  PC_TEST_CHECK( tp.res_.size() == 3 );
+  for( size_t i=0; i != tp.res_.size(); ++i ) {
+    PC_TEST_CHECK( tp.res_[i] == out.substr( i * tp.msg_len_, tp.msg_len_ ) );
+  }
+  conn.close();
+  ::close( fds[1] );
+}
+
+// websocket frame from client side of a user connection
+static void send_ws( int fd, const std::string& txt )
+{
+  net_wtr body;
+  body.add( str( txt.c_str(), txt.size() ) );
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, body, true );
+  net_buf *hd, *tl;
+  msg.detach( hd, tl );
+  for( net_buf *ptr = hd; ptr; ) {
+    net_buf *nxt = ptr->next_;
+    PC_TEST_CHECK( ptr->size_ == ::send( fd, ptr->buf_, ptr->size_, 0 ) );
+    ptr->dealloc();
+    ptr = nxt;
+  }
+}
+
+// blocking read of len bytes. timed socket waits are not restarted
+// after io_uring task work from earlier tests interrupts them
+static bool recv_all( int fd, void *buf, size_t len )
+{
+  for( char *ptr = (char*)buf; len; ) {
+    ssize_t rc = ::recv( fd, ptr, len, 0 );
+    if ( rc < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( rc <= 0 ) {
+      return false;
+    }
+    ptr += rc;
+    len -= static_cast< size_t >( rc );
+  }
+  return true;
+}
+
+static std::string recv_ws( int fd )
+{
+  uint8_t hdr[4];
+  if ( !recv_all( fd, hdr, 2 ) ) {
+    return std::string();
+  }
+  size_t len = hdr[1] & 0x7f;
+  if ( len == 126 ) {
+    if ( !recv_all( fd, &hdr[2], 2 ) ) {
+      return std::string();
+    }
+    len = ( (size_t)hdr[2] << 8 ) | hdr[3];
+  }
+  std::string res( len, '\0' );
+  if ( !recv_all( fd, &res[0], len ) ) {
+    return std::string();
+  }
+  return res;
+}
+
+static bool pop_reactor( user_reactor& rtr, user_reactor::msg& m )
+{
+  for( int i=0; i != 2000; ++i ) {
+    if ( rtr.pop( m ) ) {
+      return true;
+    }
+    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+  }
+  return false;
+}
+
+static void reply_ws( user_reactor& rtr, uint64_t id, const std::string& txt )
+{
+  net_wtr body;
+  body.add( str( txt.c_str(), txt.size() ) );
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, body, false );
+  rtr.send( id, msg );
+  rtr.done( id );
+  rtr.flush();
+}
+
+void test_reactor_user()
+{
+  // price known to the reactor through the manager's price index
+  pub_key acc;
+  acc.init_from_text( std::string( "9vNb2tQoZ8bB4vzMbQLWViGwNaDJCNTrYxsHPoRjWuVh" ) );
+  manager mgr;
+  mgr.get_price_index()->init();
+  price px( acc, nullptr );
+  PC_TEST_CHECK( mgr.get_price_index()->add( acc, &px ) );
+  user_reactor rtr;
+  rtr.set_manager( &mgr );
+  PC_TEST_CHECK( rtr.init() );
+  int fds[2];
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) );
+  struct timeval tv = { 2, 0 };
+  ::setsockopt( fds[0], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+  rtr.add_user( 7, fds[1] );
+  rtr.flush();
+
+  // websocket upgrade answered by the reactor
+  std::string req = "GET / HTTP/1.1\r\nHost: localhost\r\n"
+    "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n\r\n";
+  PC_TEST_CHECK( (ssize_t)req.size() ==
+      ::send( fds[0], req.c_str(), req.size(), 0 ) );
+  std::string rsp;
+  char buf[1024];
+  while( rsp.find( "\r\n\r\n" ) == std::string::npos ) {
+    if ( !recv_all( fds[0], buf, 1 ) ) break;
+    rsp.append( buf, 1 );
+  }
+  PC_TEST_CHECK( rsp.find( "101 Switching Protocols" ) != std::string::npos );
+
+  // mixed batch is forwarded to the manager-side user
+  std::string upd = "{\"jsonrpc\":\"2.0\",\"method\":\"update_price\","
+    "\"params\":{\"account\":\"9vNb2tQoZ8bB4vzMbQLWViGwNaDJCNTrYxsHPoRjWuVh\","
+    "\"price\":42,\"conf\":3,\"status\":\"trading\"},\"id\":";
+  std::string msg1 = "[" + upd + "1},{\"jsonrpc\":\"2.0\","
+    "\"method\":\"get_product_list\",\"id\":2}]";
+  send_ws( fds[0], msg1 );
+  user_reactor::msg m;
+  PC_TEST_CHECK( pop_reactor( rtr, m ) );
+  PC_TEST_CHECK( m.type_ == user_reactor::e_request && m.id_ == 7 );
+  PC_TEST_CHECK( m.buf_ == msg1 );
+
+  // update_price behind it is forwarded as well to keep reply order
+  send_ws( fds[0], upd + "3}" );
+  PC_TEST_CHECK( pop_reactor( rtr, m ) );
+  PC_TEST_CHECK( m.type_ == user_reactor::e_request && m.id_ == 7 );
+  PC_TEST_CHECK( m.buf_ == upd + "3}" );
+  reply_ws( rtr, 7, "reply1" );
+  reply_ws( rtr, 7, "reply3" );
+  PC_TEST_CHECK( recv_ws( fds[0] ) == "reply1" );
+  PC_TEST_CHECK( recv_ws( fds[0] ) == "reply3" );
+
+  // with nothing outstanding update_price is handed off by the reactor
+  // and answered locally
+  send_ws( fds[0], upd + "4}" );
+  PC_TEST_CHECK( pop_reactor( rtr, m ) );
+  PC_TEST_CHECK( m.type_ == user_reactor::e_upd_price );
+  PC_TEST_CHECK( m.px_[0] == &px && m.px_[1] == nullptr );
+  PC_TEST_CHECK( m.price_ == 42 && m.conf_ == 3UL );
+  std::string res = recv_ws( fds[0] );
+  PC_TEST_CHECK( res.find( "\"result\":0" ) != std::string::npos );
+  PC_TEST_CHECK( res.find( "\"id\":4" ) != std::string::npos );
+
+  // peer hang-up removes the user on both sides
+  ::close( fds[0] );
+  PC_TEST_CHECK( pop_reactor( rtr, m ) );
+  PC_TEST_CHECK( m.type_ == user_reactor::e_del_user && m.id_ == 7 );
+  rtr.teardown();
+}
+
 int main(int,char**)
 {
   PC_TEST_START
   test_net_buf();
+  test_net_buf_alloc();
+  test_net_buf_stress();
   test_json_wtr();
   test_enc();
+  test_base64();
+  test_account_data();
+  test_program_subscribe();
+  test_get_multiple_accounts();
+  test_rpc_inflight();
+  test_latency_hist();
+  test_rpc_endpoint();
+  test_net_ring();
+  test_net_loop( false );
+  test_net_loop( true );
+  test_net_uring_io();
+  test_net_send();
+  test_net_recv();
+  test_reactor_user();
   PC_TEST_END
   return 0;
 }
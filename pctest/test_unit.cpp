@@ -1,7 +1,17 @@
 #include <pc/key_pair.hpp>
+#include <pc/ed25519.hpp>
 #include <pc/misc.hpp>
 #include <pc/log.hpp>
 #include <pc/request.hpp>
+#include <pc/spsc_queue.hpp>
+#include <pc/jtree.hpp>
+#include <pc/account_cache.hpp>
+#include <pc/slot_clock.hpp>
+#include <pc/batch_policy.hpp>
+#include <pc/pending_queue.hpp>
+#include <pc/block_hash_ring.hpp>
+#include <pc/sign_pipeline.hpp>
+#include <pc/bincode.hpp>
 #include "test_error.hpp"
 
 #include <math.h>
@@ -10,6 +20,9 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <thread>
+#include <unistd.h>
+#include <openssl/evp.h>
 
 using namespace pc;
 
@@ -82,6 +95,52 @@ void test_key()
   PC_TEST_CHECK( cres == clock_var );
 }
 
+void test_base58()
+{
+  // fixed-width kernels match generic conversion
+  uint32_t seed = 7;
+  bool is_ok = true;
+  for( unsigned it=0; it != 2000; ++it ) {
+    uint8_t src[64];
+    for( size_t i=0; i != sizeof( src ); ++i ) {
+      seed = seed * 1103515245 + 12345;
+      src[i] = (uint8_t)( seed >> 16 );
+    }
+    // leading zeros and extreme values
+    unsigned nz = it % 40;
+    __builtin_memset( src, 0, nz < 34 ? nz : 0 );
+    if ( it % 97 == 1 ) __builtin_memset( src, 0xff, sizeof( src ) );
+    for( int len: { 32, 64 } ) {
+      char e0[128], e1[128];
+      int l0 = enc_base58_generic( src, len, e0, sizeof( e0 ) );
+      int l1 = enc_base58( src, len, e1, sizeof( e1 ) );
+      is_ok = is_ok && l0 == l1 && 0 == __builtin_strcmp( e0, e1 );
+      uint8_t d0[256], d1[256];
+      int k0 = dec_base58_generic( (const uint8_t*)e1, l1, d0 );
+      int k1 = dec_base58( (const uint8_t*)e1, l1, d1 );
+      is_ok = is_ok && k0 == k1 && 0 == __builtin_memcmp( d0, d1, (size_t)k0 );
+      if ( (int)nz < len ) {
+        is_ok = is_ok && k1 == len && 0 == __builtin_memcmp( d1, src, (size_t)len );
+      }
+
+      // not a canonical fixed-width value
+      e1[l1/2] = 'z';
+      e1[0] = '1';
+      k0 = dec_base58_generic( (const uint8_t*)e1, l1, d0 );
+      k1 = dec_base58( (const uint8_t*)e1, l1, d1 );
+      is_ok = is_ok && k0 == k1 && 0 == __builtin_memcmp( d0, d1, (size_t)k0 );
+    }
+  }
+  PC_TEST_CHECK( is_ok );
+
+  // output buffer too small
+  uint8_t key[32];
+  char buf[64];
+  __builtin_memset( key, 0xff, sizeof( key ) );
+  PC_TEST_CHECK( 0 == enc_base58( key, 32, buf, 44 ) );
+  PC_TEST_CHECK( 44 == enc_base58( key, 32, buf, 45 ) );
+}
+
 void test_log()
 {
   log::set_level( PC_LOG_DBG_LVL );
@@ -178,12 +237,544 @@ void test_request_sub()
   PC_TEST_CHECK( sub1.check( "r1", p1_3 ) );
 }
 
+void test_spsc_queue()
+{
+  // capacity rounded up and enforced
+  spsc_queue<uint64_t> q1( 3 );
+  uint64_t val = 0;
+  for( uint64_t i=0; i != 4; ++i ) {
+    val = i;
+    PC_TEST_CHECK( q1.push( val ) );
+  }
+  val = 4;
+  PC_TEST_CHECK( !q1.push( val ) );
+  PC_TEST_CHECK( q1.size() == 4 );
+  PC_TEST_CHECK( q1.pop( val ) && val == 0 );
+  val = 4;
+  PC_TEST_CHECK( q1.push( val ) );
+  for( uint64_t i=1; i != 5; ++i ) {
+    PC_TEST_CHECK( q1.pop( val ) && val == i );
+  }
+  PC_TEST_CHECK( !q1.pop( val ) );
+
+  // ordering across threads with moved-from payload
+  static const uint64_t num = 100000;
+  spsc_queue<std::string> q2( 64 );
+  std::thread thrd( [&q2]() {
+    for( uint64_t i=0; i != num; ) {
+      std::string s = std::to_string( i );
+      if ( q2.push( s ) ) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  } );
+  uint64_t nxt = 0;
+  bool is_ok = true;
+  std::string s;
+  while( nxt != num ) {
+    if ( q2.pop( s ) ) {
+      is_ok = is_ok && s == std::to_string( nxt );
+      ++nxt;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  thrd.join();
+  PC_TEST_CHECK( is_ok );
+  PC_TEST_CHECK( q2.size() == 0 );
+}
+
+void test_jtree( jtree::simd_t simd )
+{
+  jtree::simd_t prev = jtree::get_simd();
+  jtree::set_simd( simd );
+  PC_TEST_CHECK( jtree::get_simd() <= simd );
+
+  // pad strings across 64-byte block boundaries
+  std::string pad( 70, 'x' );
+  std::string msg = "{\"jsonrpc\": \"2.0\", \"id\":42,\n"
+    "\"result\":{\"" + pad + "\":[1, -2.5e+3,true,false,null],"
+    "\"esc\":\"a\\\"b\\\\\",\"key\" : \"" + pad + "\"}}";
+  jtree jt;
+  jt.parse( msg.c_str(), msg.size() );
+  PC_TEST_CHECK( jt.is_valid() );
+  PC_TEST_CHECK( jt.get_type( 1 ) == jtree::e_obj );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( 1, "jsonrpc" ) ) == "2.0" );
+  PC_TEST_CHECK( jt.get_uint( jt.find_val( 1, "id" ) ) == 42 );
+  uint32_t rtok = jt.find_val( 1, "result" );
+  PC_TEST_CHECK( rtok && jt.get_type( rtok ) == jtree::e_obj );
+  uint32_t atok = jt.find_val( rtok, pad );
+  PC_TEST_CHECK( atok && jt.get_type( atok ) == jtree::e_arr );
+  uint32_t tok = jt.get_first( atok );
+  PC_TEST_CHECK( jt.get_uint( tok ) == 1 );
+  tok = jt.get_next( tok );
+  PC_TEST_CHECK( jt.get_str( tok ) == "-2.5e+3" );
+  tok = jt.get_next( tok );
+  PC_TEST_CHECK( jt.get_bool( tok ) );
+  tok = jt.get_next( tok );
+  PC_TEST_CHECK( !jt.get_bool( tok ) );
+  tok = jt.get_next( tok );
+  PC_TEST_CHECK( jt.get_str( tok ) == "null" );
+  PC_TEST_CHECK( jt.get_next( tok ) == 0 );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( rtok, "esc" ) ) ==
+                 "a\\\"b\\\\" );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( rtok, "key" ) ) == pad );
+
+  // hashed keys and cached paths
+  jpath p1{ "result", "key" }, p2{ "result", "missing" }, p3{ "id", "x" };
+  for( unsigned i=0; i != 2; ++i ) {
+    PC_TEST_CHECK( jt.find_val( 1, jkey( "id" ) ) == jt.find_val( 1, "id" ) );
+    PC_TEST_CHECK( jt.get_str( jt.find_val( 1, p1 ) ) == pad );
+    PC_TEST_CHECK( jt.find_val( 1, p2 ) == 0 );
+    PC_TEST_CHECK( jt.find_val( 1, p3 ) == 0 );
+  }
+
+  // cached position is verified against a differently shaped message
+  std::string msg2 = "{\"result\":{\"key\":\"k\"}}";
+  jtree jt2;
+  jt2.parse( msg2.c_str(), msg2.size() );
+  PC_TEST_CHECK( jt2.get_str( jt2.find_val( 1, p1 ) ) == "k" );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( 1, p1 ) ) == pad );
+
+  // truncated message
+  jt.parse( msg.c_str(), msg.size() - 1 );
+  PC_TEST_CHECK( !jt.is_valid() );
+  jtree::set_simd( prev );
+}
+
+void test_account_cache()
+{
+  std::string file = "/tmp/test_account_cache." + std::to_string( getpid() );
+  ::unlink( file.c_str() );
+  pub_key k1, k2;
+  k1.init_from_text( std::string( "9vNb2tQoZ8bB4vzMbQLWViGwNaDJCNTrYxsHPoRjWuVh" ) );
+  k2.init_from_text( std::string( "BNvwMCQRe5Dn5PCTVfMJD5Kv5JW8R6nDDxsNKSgmvCLU" ) );
+  std::vector<char> img1( 600, 'a' ), img2( 3000, 'b' );
+  ((pc_acc_t*)&img1[0])->magic_ = PC_MAGIC;
+  ((pc_acc_t*)&img2[0])->magic_ = PC_MAGIC;
+  {
+    account_cache cache;
+    cache.set_file( file );
+    PC_TEST_CHECK( cache.init() );
+    PC_TEST_CHECK( cache.get_num_accounts() == 0 );
+    cache.write( k1, 10, 1, &img1[0], img1.size() );
+    cache.write( k2, 10, 2, &img2[0], img2.size() );
+
+    // older images are ignored and bigger ones move
+    img1[100] = 'c';
+    cache.write( k1, 9, 1, &img1[0], img1.size() );
+    img1.resize( 1000, 'd' );
+    cache.write( k1, 12, 3, &img1[0], img1.size() );
+    PC_TEST_CHECK( cache.get_num_accounts() == 2 );
+  }
+  {
+    // reopen and read back
+    account_cache cache;
+    cache.set_file( file );
+    PC_TEST_CHECK( cache.init() );
+    PC_TEST_CHECK( cache.get_num_accounts() == 2 );
+    uint64_t slot = 0, lamports = 0;
+    size_t len = 0;
+    const char *data = cache.read( k1, slot, lamports, len );
+    PC_TEST_CHECK( data && slot == 12 && lamports == 3 &&
+        len == img1.size() && 0 == __builtin_memcmp( data, &img1[0], len ) );
+    data = cache.read( k2, slot, lamports, len );
+    PC_TEST_CHECK( data && slot == 10 && lamports == 2 &&
+        len == img2.size() && 0 == __builtin_memcmp( data, &img2[0], len ) );
+    cached_account res( k2, slot, lamports, data, len );
+    pc_acc_t *acc = nullptr;
+    PC_TEST_CHECK( res.get_data_ref( acc ) == img2.size() &&
+        acc->magic_ == PC_MAGIC );
+  }
+  ::unlink( file.c_str() );
+}
+
+void test_slot_clock()
+{
+  const int64_t ms = PC_NSECS_IN_MSEC;
+  slot_clock clk;
+  PC_TEST_CHECK( clk.get_slot_interval() == 400*ms );
+  PC_TEST_CHECK( clk.update( 100, 1000*ms ) );
+  PC_TEST_CHECK( !clk.update( 100, 1100*ms ) );
+  PC_TEST_CHECK( !clk.update( 99, 1100*ms ) );
+
+  // converge on a faster slot interval including skipped slots
+  int64_t ts = 1000*ms;
+  for( uint64_t slot = 101; slot != 200; slot += 3 ) {
+    ts += 3*360*ms;
+    PC_TEST_CHECK( clk.update( slot, ts ) );
+  }
+  int64_t val = clk.get_slot_interval();
+  PC_TEST_CHECK( val > 359*ms && val < 362*ms );
+
+  // predict slots between updates
+  uint64_t slot = clk.get_slot();
+  PC_TEST_CHECK( clk.get_slot_time() == ts );
+  PC_TEST_CHECK( clk.get_est_slot( ts ) == slot );
+  PC_TEST_CHECK( clk.get_est_slot( ts + val + 1 ) == slot + 1 );
+  PC_TEST_CHECK( clk.get_est_slot( ts + 5*val + 1 ) == slot + 5 );
+  PC_TEST_CHECK( clk.get_next_slot_time( ts ) == ts + val );
+  PC_TEST_CHECK( clk.get_next_slot_time( ts + val ) == ts + 2*val );
+
+  // stalls only move the estimate a bounded amount
+  clk.update( slot + 1, ts + 60000*ms );
+  PC_TEST_CHECK( clk.get_slot_interval() < 2*val );
+  clk.reset();
+  PC_TEST_CHECK( clk.get_slot() == 0 );
+  PC_TEST_CHECK( clk.get_slot_interval() < 2*val );
+}
+
+void test_batch_policy()
+{
+  const int64_t ms = PC_NSECS_IN_MSEC;
+  batch_policy bp;
+  bp.set_max_batch( 8 );
+  PC_TEST_CHECK( bp.get_batch_size() == 8 );
+  PC_TEST_CHECK( bp.get_flush_time() == 0L );
+
+  // sends on a path that never reports acks hold the batch size
+  {
+    batch_policy bp2;
+    bp2.set_max_batch( 8 );
+    for( unsigned i = 0; i != 20; ++i ) {
+      bp2.add_sent( 8 );
+      bp2.on_slot( 100 + i, 1000*ms + i*400*ms, 400*ms );
+    }
+    PC_TEST_CHECK( bp2.get_ack_rate() == 1. );
+    PC_TEST_CHECK( bp2.get_batch_size() == 8 );
+    PC_TEST_CHECK( bp2.get_num_shrink() == 0 );
+  }
+
+  // flush half an ack round trip before the slot ends
+  for( unsigned i = 0; i != 4; ++i ) {
+    bp.add_ack( 100*ms );
+  }
+  PC_TEST_CHECK( !bp.on_slot( 100, 1000*ms, 400*ms ) );
+  PC_TEST_CHECK( bp.get_flush_lead() == 50*ms );
+  PC_TEST_CHECK( bp.get_flush_time() == 1350*ms );
+  bp.on_flush( 1349*ms );
+  PC_TEST_CHECK( bp.get_flush_time() == 1350*ms );
+  bp.on_flush( 1360*ms );
+  PC_TEST_CHECK( bp.get_flush_time() == 1750*ms );
+
+  // halve batches while updates go unacknowledged, then hold the size
+  int64_t ts = 1000*ms;
+  uint64_t slot = 100;
+  for( unsigned i = 0; i != 3; ++i ) {
+    bp.add_sent( 8 );
+    bp.on_slot( ++slot, ts += 400*ms, 400*ms );
+  }
+  PC_TEST_CHECK( bp.get_ack_rate() < 0.9 );
+  PC_TEST_CHECK( bp.get_batch_size() == 4 );
+  PC_TEST_CHECK( bp.get_num_shrink() == 1 );
+  for( unsigned i = 0; i != 3; ++i ) {
+    bp.add_sent( 8 );
+    bp.on_slot( ++slot, ts += 400*ms, 400*ms );
+  }
+  PC_TEST_CHECK( bp.get_batch_size() == 4 );
+
+  // grow by one per hold period once updates are acked and back up
+  for( unsigned i = 0; i != 60; ++i ) {
+    for( unsigned j = 0; j != 8; ++j ) {
+      bp.add_ack( 100*ms );
+    }
+    bp.add_sent( 8 );
+    bp.add_pending( 16 );
+    bp.on_slot( ++slot, ts += 400*ms, 400*ms );
+  }
+  PC_TEST_CHECK( bp.get_ack_rate() > 0.9 );
+  PC_TEST_CHECK( bp.get_batch_size() == 8 );
+  PC_TEST_CHECK( bp.get_num_grow() >= 4 );
+}
+
+struct test_pend
+{
+  bool get_is_pending() const { return is_pend_; }
+  void set_is_pending( bool is_pend ) { is_pend_ = is_pend; }
+  bool get_is_priority() const { return is_prio_; }
+  bool is_pend_;
+  bool is_prio_;
+};
+
+void test_pending_queue()
+{
+  test_pend vec[200] = {};
+  for( unsigned i = 0; i != 200; i += 10 ) {
+    vec[i].is_prio_ = true;
+  }
+  pending_queue<test_pend> pq;
+  std::vector<test_pend*> res;
+
+  // duplicates are ignored and the queue grows past its initial ring
+  for( unsigned i = 0; i != 200; ++i ) {
+    PC_TEST_CHECK( pq.add( &vec[i] ) );
+    PC_TEST_CHECK( !pq.add( &vec[i] ) );
+  }
+  PC_TEST_CHECK( pq.size() == 200 );
+  PC_TEST_CHECK( pq.get_num_priority() == 20 );
+
+  // oldest first across both rings
+  pq.pop( res, 15 );
+  PC_TEST_CHECK( res.size() == 15 );
+  for( unsigned i = 0; i != res.size(); ++i ) {
+    PC_TEST_CHECK( res[i] == &vec[i] && !vec[i].is_pend_ );
+  }
+  PC_TEST_CHECK( pq.add( &vec[0] ) );
+  PC_TEST_CHECK( pq.size() == 186 );
+
+  // priority items first, each ring in arrival order
+  pq.set_order( pending_queue<test_pend>::e_priority_first );
+  pq.pop( res, 20 );
+  PC_TEST_CHECK( res.size() == 20 );
+  for( unsigned i = 0; i != 18; ++i ) {
+    PC_TEST_CHECK( res[i] == &vec[20 + 10*i] );
+  }
+  PC_TEST_CHECK( res[18] == &vec[0] );
+  PC_TEST_CHECK( res[19] == &vec[15] );
+  PC_TEST_CHECK( pq.get_num_priority() == 0 );
+
+  // drain the rest
+  pq.pop( res, 1000 );
+  PC_TEST_CHECK( res.size() == 166 && pq.size() == 0 );
+  PC_TEST_CHECK( res.back() == &vec[199] );
+  pq.pop( res, 1 );
+  PC_TEST_CHECK( res.empty() );
+}
+
+void test_block_hash_ring()
+{
+  block_hash_ring ring;
+  hash h[PC_BLOCK_HASH_RING+2];
+  for( unsigned i = 0; i != PC_BLOCK_HASH_RING+2; ++i ) {
+    uint8_t buf[hash::len] = { static_cast<uint8_t>( i + 1 ) };
+    h[i].init_from_buf( buf );
+  }
+  PC_TEST_CHECK( ring.get_num() == 0 );
+  PC_TEST_CHECK( ring.add( h[0], 100UL, 1000L ) );
+
+  // repeats keep the time of first observation and older slots are ignored
+  PC_TEST_CHECK( !ring.add( h[0], 101UL, 2000L ) );
+  PC_TEST_CHECK( !ring.add( h[1], 99UL, 2000L ) );
+  PC_TEST_CHECK( ring.get_num() == 1 );
+  PC_TEST_CHECK( *ring.get_hash() == h[0] && ring.get_time() == 1000L );
+
+  // keep the last PC_BLOCK_HASH_RING hashes freshest first
+  for( unsigned i = 1; i != PC_BLOCK_HASH_RING+2; ++i ) {
+    PC_TEST_CHECK( ring.add( h[i], 100UL + i, 1000L*( i + 1 ) ) );
+  }
+  PC_TEST_CHECK( ring.get_num() == PC_BLOCK_HASH_RING );
+  PC_TEST_CHECK( *ring.get_hash() == h[PC_BLOCK_HASH_RING+1] );
+  PC_TEST_CHECK( ring.get_slot() == 101UL + PC_BLOCK_HASH_RING );
+  PC_TEST_CHECK( ring.get_slot( 1 ) == 100UL + PC_BLOCK_HASH_RING );
+  PC_TEST_CHECK( ring.find( h[2] ) == 102UL );
+  PC_TEST_CHECK( ring.find( h[1] ) == 0UL );
+  ring.reset();
+  PC_TEST_CHECK( ring.get_num() == 0 && ring.find( h[2] ) == 0UL );
+}
+
+void test_ed25519()
+{
+  // rfc 8032 test vector 1
+  static const uint8_t seed1[] = {
+    0x9d,0x61,0xb1,0x9d,0xef,0xfd,0x5a,0x60,0xba,0x84,0x4a,0xf4,0x92,0xec,
+    0x2c,0xc4,0x44,0x49,0xc5,0x69,0x7b,0x32,0x69,0x19,0x70,0x3b,0xac,0x03,
+    0x1c,0xae,0x7f,0x60
+  };
+  static const uint8_t pub1[] = {
+    0xd7,0x5a,0x98,0x01,0x82,0xb1,0x0a,0xb7,0xd5,0x4b,0xfe,0xd3,0xc9,0x64,
+    0x07,0x3a,0x0e,0xe1,0x72,0xf3,0xda,0xa6,0x23,0x25,0xaf,0x02,0x1a,0x68,
+    0xf7,0x07,0x51,0x1a
+  };
+  static const uint8_t sig1[] = {
+    0xe5,0x56,0x43,0x00,0xc3,0x60,0xac,0x72,0x90,0x86,0xe2,0xcc,0x80,0x6e,
+    0x82,0x8a,0x84,0x87,0x7f,0x1e,0xb8,0xe5,0xd9,0x74,0xd8,0x73,0xe0,0x65,
+    0x22,0x49,0x01,0x55,0x5f,0xb8,0x82,0x15,0x90,0xa3,0x3b,0xac,0xc6,0x1e,
+    0x39,0x70,0x1c,0xf9,0xb4,0x6b,0xd2,0x5b,0xf5,0xf0,0x59,0x5b,0xbe,0x24,
+    0x65,0x51,0x41,0x43,0x8e,0x7a,0x10,0x0b
+  };
+  ed25519 key;
+  key.init( seed1 );
+  PC_TEST_CHECK( 0 == __builtin_memcmp( key.get_pub_key(), pub1, 32 ) );
+  uint8_t sig[ed25519::sig_len];
+  key.sign( sig, nullptr, 0 );
+  PC_TEST_CHECK( 0 == __builtin_memcmp( sig, sig1, sizeof( sig1 ) ) );
+
+  // digests match openssl across block boundaries and split updates
+  uint8_t msg[300];
+  for( unsigned i = 0; i != sizeof( msg ); ++i ) {
+    msg[i] = (uint8_t)( i * 131 + 7 );
+  }
+  bool is_ok = true;
+  for( unsigned len = 0; len <= sizeof( msg ); ++len ) {
+    uint8_t md1[sha512::len], md2[sha512::len];
+    unsigned md_len = 0;
+    EVP_Digest( msg, len, md1, &md_len, EVP_sha512(), NULL );
+    sha512 dg;
+    dg.add( msg, len / 3 );
+    dg.add( &msg[len/3], len - len / 3 );
+    dg.fini( md2 );
+    is_ok = is_ok && 0 == __builtin_memcmp( md1, md2, sizeof( md1 ) );
+  }
+  PC_TEST_CHECK( is_ok );
+
+  // signatures and public keys match openssl for generated keys
+  for( unsigned i = 0; i != 32; ++i ) {
+    key_pair kp;
+    kp.gen();
+    key_cache kc;
+    kc.set( kp );
+    PC_TEST_CHECK( 0 == __builtin_memcmp(
+          kc.get().get_pub_key(), &kp.data()[pub_key::len], pub_key::len ) );
+    size_t len = 1 + ( i * 37 ) % ( sizeof( msg ) - 1 );
+    uint8_t ssl_sig[signature::len];
+    size_t ssl_len = signature::len;
+    EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(
+        EVP_PKEY_ED25519, NULL, kp.data(), pub_key::len );
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new();
+    PC_TEST_CHECK( EVP_DigestSignInit( mctx, NULL, NULL, NULL, pkey ) );
+    PC_TEST_CHECK( EVP_DigestSign( mctx, ssl_sig, &ssl_len, msg, len ) );
+    EVP_MD_CTX_free( mctx );
+    EVP_PKEY_free( pkey );
+    signature sig;
+    PC_TEST_CHECK( sig.sign( msg, (uint32_t)len, kc ) );
+    PC_TEST_CHECK( 0 == __builtin_memcmp( sig.data(), ssl_sig, ssl_len ) );
+    pub_key pk( kp );
+    PC_TEST_CHECK( sig.verify( msg, (uint32_t)len, pk ) );
+  }
+
+  // unset cache refuses to sign
+  key_cache kc;
+  signature sig2;
+  PC_TEST_CHECK( !sig2.sign( msg, 1, kc ) );
+}
+
+void test_sign_pipeline()
+{
+  key_pair kp;
+  kp.gen();
+  key_cache kc;
+  kc.set( kp );
+  pub_key pk( kp );
+
+  // jobs spread over two workers come back signed in submission order
+  sign_pipeline sp;
+  sp.set_num_worker( 2 );
+  PC_TEST_CHECK( sp.init() );
+  const uint64_t num_job = 64;
+  for( uint64_t i = 0; i != num_job; ++i ) {
+    sign_pipeline::job jb;
+    jb.buf_ = net_buf::alloc();
+    bincode tx( jb.buf_->buf_ );
+    jb.sig_ = tx.reserve_sign();
+    jb.msg_ = tx.get_pos();
+    tx.add( i );
+    jb.len_ = tx.size();
+    jb.key_ = &kc;
+    jb.id_  = i;
+    jb.gen_ = 0;
+    PC_TEST_CHECK( !sp.get_is_full() );
+    sp.submit( jb );
+  }
+  PC_TEST_CHECK( sp.get_max_depth() == num_job );
+  for( uint64_t i = 0; i != num_job; ) {
+    sign_pipeline::job jb;
+    if ( !sp.pop( jb ) ) {
+      std::this_thread::yield();
+      continue;
+    }
+    PC_TEST_CHECK( jb.id_ == i );
+    signature *sig = (signature*)&jb.buf_->buf_[jb.sig_];
+    PC_TEST_CHECK( sig->verify(
+          (const uint8_t*)&jb.buf_->buf_[jb.msg_], jb.len_ - jb.msg_, pk ) );
+    jb.buf_->dealloc();
+    ++i;
+  }
+  PC_TEST_CHECK( sp.get_depth() == 0 );
+  PC_TEST_CHECK( sp.get_latency().get_count() == num_job );
+  sp.teardown();
+  PC_TEST_CHECK( sp.get_is_full() );
+}
+
+void test_upd_price_cache()
+{
+  key_pair kp;
+  kp.gen();
+  key_cache kc;
+  kc.set( kp );
+  pub_key pgm, acc[4];
+  key_pair tmp;
+  tmp.gen();
+  tmp.get_pub_key( pgm );
+  for( unsigned i = 0; i != 4; ++i ) {
+    tmp.gen();
+    tmp.get_pub_key( acc[i] );
+  }
+  hash bh;
+  bh.zero();
+  rpc::upd_price upd[4];
+  for( unsigned i = 0; i != 4; ++i ) {
+    upd[i].set_publish( &kp );
+    upd[i].set_pubcache( &kc );
+    upd[i].set_program( &pgm );
+    upd[i].set_account( &acc[i] );
+    upd[i].set_block_hash( &bh );
+  }
+
+  // cached images match a fresh build as prices, hash and accounts change
+  rpc::upd_price_cache tc;
+  rpc::upd_price *upds[4] = { &upd[0], &upd[1], &upd[2], &upd[3] };
+  bool is_ok = true;
+  for( unsigned i = 0; i != 8; ++i ) {
+    for( unsigned j = 0; j != 4; ++j ) {
+      upd[j].set_price( 1000L*i + j, 10UL + j, symbol_status::e_trading,
+                        j == i % 4 );
+      upd[j].set_slot( 100UL + i );
+    }
+    *(uint64_t*)bh.data() = i;
+    if ( i == 6 ) {
+      std::swap( upds[1], upds[2] );
+    }
+    unsigned n = i < 4 ? 4 : 3;
+    unsigned cu_units = i == 5 ? 20000 : 0;
+    char buf1[net_buf::len], buf2[net_buf::len];
+    bincode tx1( buf1 ), tx2( buf2 );
+    rpc::upd_price_layout lay1, lay2;
+    tx1.add( (uint32_t)42 );
+    PC_TEST_CHECK( tc.build_unsigned_tx( tx1, upds, n, cu_units, 0, lay1 ) );
+    PC_TEST_CHECK( rpc::upd_price::build_unsigned_tx(
+          tx2, upds, n, cu_units, 0, lay2 ) );
+    is_ok = is_ok && tx1.size() == tx2.size() + 4 &&
+      lay1.sig_idx_ == lay2.sig_idx_ + 4 &&
+      lay1.msg_idx_ == lay2.msg_idx_ + 4 &&
+      0 == __builtin_memcmp( &buf1[lay1.msg_idx_], &buf2[lay2.msg_idx_],
+                             tx2.size() - lay2.msg_idx_ );
+  }
+  PC_TEST_CHECK( is_ok );
+  PC_TEST_CHECK( tc.get_num_miss() == 4 );
+  PC_TEST_CHECK( tc.get_num_hit() == 4 );
+}
+
 int main(int,char**)
 {
   PC_TEST_START
   test_key();
+  test_base58();
   test_log();
   test_request_sub();
+  test_spsc_queue();
+  test_account_cache();
+  test_slot_clock();
+  test_batch_policy();
+  test_pending_queue();
+  test_block_hash_ring();
+  test_ed25519();
+  test_sign_pipeline();
+  test_upd_price_cache();
+  test_jtree( jtree::e_scalar );
+  test_jtree( jtree::e_sse42 );
+  test_jtree( jtree::e_avx2 );
   PC_TEST_END
   return 0;
 }